@@ -0,0 +1,64 @@
+#include "anillo.h"
+
+#define MASCARA_ANILLO (ANILLO_TAM - 1)
+
+static Sensor muestras[ANILLO_TAM];
+static volatile uint8_t cabeza = 0;   //solo la modifica la interrupcion
+static volatile uint8_t cola = 0;     //solo la modifica el programa principal
+static volatile unsigned int desbordes = 0;
+
+void inicializarAnillo(void)
+{
+    cabeza = 0;
+    cola = 0;
+    desbordes = 0;
+}
+
+uint8_t ponerAnillo(const Sensor* sensor)
+{
+    uint8_t c = cabeza;
+    
+    if ((uint8_t)(c - cola) >= ANILLO_TAM)
+    {
+        if (desbordes != 0xFFFF)
+            desbordes++;
+        return 0;
+    }
+    muestras[c & MASCARA_ANILLO] = *sensor;
+    //La muestra se publica despues de copiarla
+    cabeza = c + 1;
+    return 1;
+}
+
+uint8_t sacarAnillo(Sensor* destino, uint8_t k)
+{
+    uint8_t c = cola, n, j;
+    
+    n = (uint8_t)(cabeza - c);
+    if (n > k)
+        n = k;
+    for (j = 0; j < n; j++)
+    {
+        destino[j] = muestras[c & MASCARA_ANILLO];
+        c++;
+    }
+    cola = c;
+    return n;
+}
+
+uint8_t muestrasAnillo(void)
+{
+    return (uint8_t)(cabeza - cola);
+}
+
+unsigned int desbordesAnillo(void)
+{
+    unsigned int n;
+    
+    //El contador es de 16 bits: se relee si la interrupcion lo cambio a la mitad
+    do
+    {
+        n = desbordes;
+    } while (n != desbordes);
+    return n;
+}
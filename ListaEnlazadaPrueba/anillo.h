@@ -0,0 +1,68 @@
+/*
+ * File:   anillo.h
+ * Author:
+ * Comments: Cola circular de muestras Sensor de capacidad fija: la
+ *           interrupcion agrega muestras y el programa principal las saca
+ *           por lotes, sin apuntadores por muestra
+ * Revision history:
+ */
+
+// This is a guard condition so that contents of this file are not included
+// more than once.
+#ifndef ANILLO_H
+#define	ANILLO_H
+
+#include <xc.h> // include processor files - each processor file is guarded.
+#include <stdint.h>
+#include "sensor.h"
+
+//Muestras que caben en la cola (potencia de 2, a lo sumo 128). Cada una ocupa
+//sizeof(Sensor) bytes; un Nodo de la lista ocupa ademas su apuntador.
+#ifndef ANILLO_TAM
+#define ANILLO_TAM 16
+#endif
+#if (ANILLO_TAM & (ANILLO_TAM - 1)) != 0 || ANILLO_TAM > 128
+#error "ANILLO_TAM debe ser potencia de 2 y a lo sumo 128"
+#endif
+
+/*
+ * La interrupcion solo mueve la cabeza y el programa principal solo mueve la
+ * cola; los indices son de 8 bits (se leen y escriben de una vez) y corren
+ * libres, de modo que ninguno de los dos lados necesita deshabilitar las
+ * interrupciones. Una cola con un solo productor y un solo consumidor.
+ */
+
+/** @brief Vacía la cola y pone en cero los desbordes. Se llama antes de habilitar la interrupción que agrega muestras. */
+void inicializarAnillo(void);
+/**
+ * @brief Agrega una muestra al final de la cola.
+ *
+ * @param sensor Muestra que se copia.
+ *
+ * @details Pensada para llamarse desde la interrupción (un solo productor). Si la cola está llena la muestra nueva se descarta y se cuenta un desborde: las que ya están no se tocan porque el programa principal puede estar copiándolas.
+ *
+ * @return 1 si se agregó, 0 si la cola estaba llena.
+ */
+uint8_t ponerAnillo(const Sensor* sensor);
+/**
+ * @brief Saca hasta `k` muestras del principio de la cola en una sola llamada.
+ *
+ * @param destino Arreglo donde se copian las muestras, en el orden en que llegaron.
+ * @param k Muestras máximas que caben en `destino`.
+ *
+ * @details Se llama desde el programa principal (un solo consumidor). Las posiciones se liberan después de copiar todo el lote, así que la interrupción puede seguir agregando muestras mientras tanto.
+ *
+ * @return Muestras copiadas (0 si la cola estaba vacía).
+ *
+ * @code
+ * Sensor lote[4];
+ * uint8_t n = sacarAnillo(lote, 4);
+ * @endcode
+ */
+uint8_t sacarAnillo(Sensor* destino, uint8_t k);
+/** @brief Muestras que esperan en la cola. */
+uint8_t muestrasAnillo(void);
+/** @brief Muestras descartadas porque la cola estaba llena (se detiene en 65535). */
+unsigned int desbordesAnillo(void);
+
+#endif	/* XC_HEADER_TEMPLATE_H */
@@ -0,0 +1,198 @@
+/*
+ * File:   bancoLista.c
+ * Author:
+ * Comments: Banco en PC de la lista (mainLista.c) y del anillo (anillo.c).
+ *           Mete y saca miles de muestras en orden FIFO, revisa el orden y los
+ *           contadores del pool, y mide el tiempo por muestra con varios
+ *           tamanos: si insertarFinal()/quitarInicio() son O(1) el tiempo por
+ *           muestra no depende del tamano de la lista. Regresa 0 si todas las
+ *           revisiones pasan.
+ *
+ * Se compila con el Makefile del simulador de matrizv3, que usa su xc.h en
+ * lugar del del compilador, deja el main() del PIC como main_firmware() y
+ * agranda NODOS_POOL y ANILLO_TAM (desde matrizv3/sim):
+ *
+ *   make bancoLista && ./bancoLista
+ *
+ * Revision history:
+ */
+
+//Aqui se necesita el main de la PC
+#undef main
+
+#include <stdio.h>
+#include <time.h>
+#include "lista.h"
+#include "anillo.h"
+
+#if NODOS_POOL < 8192
+#error "compilar el banco con -DNODOS_POOL=8192 o mas"
+#endif
+
+//Tamanos medidos: del menor al mayor, hasta llenar el pool
+#define TAMANO_MINIMO 256
+//Muestras que se mueven en cada medicion, sea cual sea el tamano
+#define MUESTRAS_MEDICION 4000000UL
+//Veces que se repite cada medicion; se toma la mas rapida
+#define REPETICIONES 5
+//Maxima diferencia aceptada entre el tiempo por muestra de dos tamanos
+#define TOLERANCIA_LINEAL 2.0
+
+static unsigned int fallas = 0;
+
+static void revisa(int condicion, const char *descripcion)
+{
+    printf("%-60s %s\n", descripcion, condicion ? "ok" : "FALLA");
+    if (!condicion)
+        fallas++;
+}
+
+//Muestra numero k de una secuencia; id y valor juntos la identifican
+static Sensor muestra(unsigned long k)
+{
+    Sensor s;
+    s.id = (uint8_t)(k >> 8);
+    s.valor = (uint8_t)k;
+    return s;
+}
+
+static int mismaMuestra(const Sensor *s, unsigned long k)
+{
+    Sensor e = muestra(k);
+    return s->id == e.id && s->valor == e.valor;
+}
+
+//Llena la lista con n muestras y la vacia; regresa 1 si salieron en orden
+static int llenaYVacia(Lista *lista, unsigned long n)
+{
+    unsigned long k;
+    Sensor s;
+    int enOrden = 1;
+
+    for (k = 0; k < n; k++)
+    {
+        s = muestra(k);
+        insertarFinal(lista, &s);
+    }
+    for (k = 0; k < n; k++)
+        if (!quitarInicio(lista, &s) || !mismaMuestra(&s, k))
+            enOrden = 0;
+    return enOrden && lista->cabeza == NULL && lista->cola == NULL;
+}
+
+static void pruebaLista(void)
+{
+    Lista lista;
+    Sensor s;
+    unsigned long k;
+
+    inicializarPool();
+    inicializarLista(&lista);
+    revisa(llenaYVacia(&lista, NODOS_POOL), "lista: el pool completo sale en orden FIFO");
+    revisa(nodosEnUso() == 0 && maximoNodosEnUso() == NODOS_POOL, "lista: todos los nodos regresan al pool");
+    revisa(!quitarInicio(&lista, &s), "lista: quitarInicio() de una lista vacia regresa 0");
+
+    for (k = 0; k <= NODOS_POOL; k++)
+    {
+        s = muestra(k);
+        insertarFinal(&lista, &s);
+    }
+    revisa(lista.longitud == NODOS_POOL && fallosPool() == 1, "lista: con el pool agotado la lista no cambia");
+    liberarLista(&lista);
+    revisa(nodosEnUso() == 0 && lista.longitud == 0 && lista.cabeza == NULL,
+           "lista: liberarLista() regresa todos los nodos");
+}
+
+static void pruebaAnillo(void)
+{
+    Sensor s, lote[ANILLO_TAM];
+    unsigned long puestas = 0, sacadas = 0, total = 64UL * NODOS_POOL;
+    int enOrden = 1;
+    uint8_t n, j;
+
+    //La mitad de la cola por vuelta: nunca se llena
+    inicializarAnillo();
+    while (sacadas < total)
+    {
+        while (puestas < total && muestrasAnillo() < ANILLO_TAM / 2)
+        {
+            s = muestra(puestas++);
+            ponerAnillo(&s);
+        }
+        n = sacarAnillo(lote, ANILLO_TAM);
+        for (j = 0; j < n; j++)
+            if (!mismaMuestra(&lote[j], sacadas++))
+                enOrden = 0;
+    }
+    revisa(enOrden && desbordesAnillo() == 0, "anillo: miles de muestras salen en orden y sin desbordes");
+
+    //Cola llena: las muestras nuevas se descartan y se cuentan
+    inicializarAnillo();
+    for (puestas = 0; puestas < ANILLO_TAM + 3; puestas++)
+    {
+        s = muestra(puestas);
+        ponerAnillo(&s);
+    }
+    n = sacarAnillo(lote, ANILLO_TAM);
+    revisa(n == ANILLO_TAM && desbordesAnillo() == 3 && mismaMuestra(&lote[ANILLO_TAM - 1], ANILLO_TAM - 1),
+           "anillo: con la cola llena se descarta la muestra nueva");
+}
+
+//Nanosegundos por muestra (insertar y quitar) con listas de n muestras
+static double midePorMuestra(unsigned long n)
+{
+    Lista lista;
+    unsigned long vueltas = MUESTRAS_MEDICION / n, v;
+    double mejor = 0, t;
+    clock_t inicio;
+    int r;
+
+    inicializarPool();
+    inicializarLista(&lista);
+    for (r = 0; r < REPETICIONES; r++)
+    {
+        inicio = clock();
+        for (v = 0; v < vueltas; v++)
+            if (!llenaYVacia(&lista, n))
+                return -1;
+        t = (double)(clock() - inicio) / CLOCKS_PER_SEC * 1e9 / ((double)vueltas * n);
+        if (r == 0 || t < mejor)
+            mejor = t;
+    }
+    return mejor;
+}
+
+static void bancoLineal(void)
+{
+    unsigned long n;
+    double t, minimo = 0, maximo = 0;
+    int enOrden = 1;
+
+    printf("\n%10s %14s\n", "muestras", "ns por muestra");
+    for (n = TAMANO_MINIMO; n <= NODOS_POOL; n *= 2)
+    {
+        t = midePorMuestra(n);
+        if (t < 0)
+        {
+            enOrden = 0;
+            continue;
+        }
+        printf("%10lu %14.2f\n", n, t);
+        if (n == TAMANO_MINIMO || t < minimo)
+            minimo = t;
+        if (n == TAMANO_MINIMO || t > maximo)
+            maximo = t;
+    }
+    printf("\n");
+    revisa(enOrden, "banco: todas las mediciones salen en orden FIFO");
+    revisa(maximo <= TOLERANCIA_LINEAL * minimo, "banco: el tiempo por muestra no crece con la lista (lineal)");
+}
+
+int main(void)
+{
+    pruebaLista();
+    pruebaAnillo();
+    bancoLineal();
+    printf("%u fallas\n", fallas);
+    return fallas != 0;
+}
@@ -63,6 +63,20 @@
 // TODO Insert declarations or function prototypes (right here) to leverage 
 // live documentation
 #include "sensor.h"
+
+//Nodos que se reservan en RAM para todas las listas (no se usa el heap)
+#ifndef NODOS_POOL
+#define NODOS_POOL 8
+#endif
+
+//Los contadores de nodos son de 8 bits salvo que el pool no quepa en ellos
+//(por ejemplo en el banco de la PC, ver bancoLista.c)
+#if NODOS_POOL > 255
+typedef unsigned int CuentaNodos;
+#else
+typedef uint8_t CuentaNodos;
+#endif
+
 typedef struct Nodo{
     Sensor sensor;
     struct Nodo* siguiente;
@@ -70,14 +84,44 @@ typedef struct Nodo{
 
 typedef struct Lista{
     Nodo* cabeza;
-    uint8_t longitud;
+    Nodo* cola;     //ultimo nodo, para insertar al final sin recorrer la lista
+    CuentaNodos longitud;
 }Lista;
 
 
+/**
+ * @brief Enlaza todos los nodos del pool en la lista de libres.
+ *
+ * @details Debe llamarse una vez antes de `crearNodo()`; los nodos que se hubieran tomado antes quedan libres.
+ */
+void inicializarPool(void);
+/**
+ * @brief Toma un nodo libre del pool y le copia el sensor.
+ *
+ * @return El nodo con `siguiente` en NULL, o NULL si el pool está agotado (se cuenta en `fallosPool()`).
+ */
 Nodo* crearNodo(Sensor* sensor);
+/** @brief Regresa un nodo al pool; NULL se ignora. */
 void destruirNodo(Nodo* nodo);
+/** @brief Nodos tomados del pool en este momento. */
+CuentaNodos nodosEnUso(void);
+/** @brief Máximo de nodos que han estado en uso a la vez desde `inicializarPool()`. */
+CuentaNodos maximoNodosEnUso(void);
+/** @brief Llamadas a `crearNodo()` que encontraron el pool agotado (se detiene en 255). */
+uint8_t fallosPool(void);
 void inicializarLista(Lista* lista);
+/** @brief Agrega una copia del sensor al final de la lista, sin recorrerla; si el pool está agotado la lista no cambia. */
 void insertarFinal(Lista* lista, Sensor* sensor);
+/**
+ * @brief Quita el primer nodo de la lista y copia su sensor, de modo que la lista funciona como cola FIFO con `insertarFinal()`.
+ *
+ * @param lista Lista de donde se quita.
+ * @param sensor Variable donde se copia el sensor quitado.
+ *
+ * @return 1 si se quitó un nodo, 0 si la lista estaba vacía (`*sensor` no cambia).
+ */
+uint8_t quitarInicio(Lista* lista, Sensor* sensor);
+/** @brief Regresa al pool todos los nodos de la lista en una pasada y la deja vacía. */
 void liberarLista(Lista* lista);
 
 #endif	/* XC_HEADER_TEMPLATE_H */
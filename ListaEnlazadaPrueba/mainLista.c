@@ -19,64 +19,125 @@
 #include <xc.h>
 #define _XTAL_FREQ 4000000
 #include <stdint.h>
-#include <stdlib.h>
+#include <stddef.h>
 #include "lista.h"
+#include "anillo.h"
 
+//Los nodos libres se enlazan por su propio campo siguiente
+static Nodo pool[NODOS_POOL];
+static Nodo* libres;
+static CuentaNodos enUso;
+static CuentaNodos maximoEnUso;
+static uint8_t fallos;
+
+void inicializarPool(void)
+{
+    CuentaNodos k;
+    
+    libres = NULL;
+    for (k = 0; k < NODOS_POOL; k++)
+    {
+        pool[k].siguiente = libres;
+        libres = &pool[k];
+    }
+    enUso = 0;
+    maximoEnUso = 0;
+    fallos = 0;
+}
 
 Nodo* crearNodo(Sensor* sensor)
 {
-    Nodo* nodo = (Nodo*) malloc(sizeof(Nodo));
+    Nodo* nodo = libres;
     if(nodo == NULL)
     {
+        if (fallos != 255)
+            fallos++;
         return NULL;
     }
+    libres = nodo->siguiente;
+    nodo->sensor = *sensor;
     nodo->siguiente = NULL;
+    enUso++;
+    if (enUso > maximoEnUso)
+        maximoEnUso = enUso;
     return nodo;
 }
 
 void destruirNodo(Nodo* nodo)
 {
-    free(nodo);
+    if (nodo == NULL)
+        return;
+    nodo->siguiente = libres;
+    libres = nodo;
+    enUso--;
+}
+
+CuentaNodos nodosEnUso(void)
+{
+    return enUso;
+}
+
+CuentaNodos maximoNodosEnUso(void)
+{
+    return maximoEnUso;
+}
+
+uint8_t fallosPool(void)
+{
+    return fallos;
 }
 
 void inicializarLista(Lista* lista)
 {
     lista->cabeza = NULL;
+    lista->cola = NULL;
     lista->longitud = 0;
 }
 
 void insertarFinal(Lista* lista, Sensor* sensor)
 {
     Nodo* nodo = crearNodo(sensor);
+    if(nodo == NULL)
+        return;     //pool agotado, ver fallosPool()
     if(lista->cabeza == NULL){
         lista->cabeza = nodo;
     }else{
-        Nodo* puntero = lista->cabeza;
-        while(puntero->siguiente){
-            puntero = puntero->siguiente;
-        }
-    puntero->siguiente = nodo;   
+        lista->cola->siguiente = nodo;
     }
+    lista->cola = nodo;
     lista->longitud++;
 }
 
+uint8_t quitarInicio(Lista* lista, Sensor* sensor)
+{
+    Nodo* primero = lista->cabeza;
+    if(primero == NULL)
+        return 0;
+    *sensor = primero->sensor;
+    lista->cabeza = primero->siguiente;
+    if(lista->cabeza == NULL)
+        lista->cola = NULL;
+    lista->longitud--;
+    destruirNodo(primero);
+    return 1;
+}
+
 void liberarLista(Lista* lista)
 {
-    if(lista->cabeza)
+    Nodo* eliminado = lista->cabeza;
+    Nodo* sig;
+    while (eliminado!=NULL)
     {
-        Nodo* eliminado = lista->cabeza;
-        Nodo* sig;
-        while (eliminado!=NULL)
-        {
-            sig = eliminado->siguiente;
-            destruirNodo(eliminado);
-            eliminado = sig->siguiente;
-        }
+        sig = eliminado->siguiente;
+        destruirNodo(eliminado);
+        eliminado = sig;
     }
+    inicializarLista(lista);
 }
 void main(void) {
     Lista miLista;
    
+    inicializarPool();
     inicializarLista(&miLista);
     
     //Creando algunos sensores
@@ -102,4 +163,22 @@ void main(void) {
     }
     liberarLista(&miLista);
     
+    //La misma cola con el anillo: en el equipo ponerAnillo() se llama desde
+    //la interrupcion que lee el sensor y el ciclo principal saca por lotes
+    Sensor lote[4];
+    uint8_t n, k;
+    inicializarAnillo();
+    ponerAnillo(&sensor1);
+    ponerAnillo(&sensor2);
+    ponerAnillo(&sensor3);
+    ponerAnillo(&sensor4);
+    ponerAnillo(&sensor5);
+    while((n = sacarAnillo(lote, 4)) != 0)
+    {
+        for(k = 0; k < n; k++)
+        {
+            //enviarRS232(lote[k].valor)
+        }
+    }
+    
 }
@@ -0,0 +1,211 @@
+#include "cacheGlifos.h"
+
+typedef struct {
+    unsigned char caracter;     //0: contador libre
+    uint8_t usos;
+} ContadorUso;
+
+static ContadorUso contadores[CACHE_CONTADORES];
+static unsigned char cacheValido = 0;
+static uint8_t cargasSinReemplazo = 0;
+static unsigned int aciertos = 0;
+static unsigned int fallos = 0;
+//Ranura en espera de grabarse: caracter, ancho y columnas, su direccion y el
+//siguiente paso de pasoCacheGlifos() (0: nada pendiente)
+static uint8_t ranuraPendiente[CACHE_BYTES_RANURA];
+static uint8_t dirPendiente;
+static uint8_t pasoPendiente = 0;
+
+//Las ranuras se recorren sumando CACHE_BYTES_RANURA a la direccion: el
+//producto usaria una rutina de XC8, con su marco en la pila compilada, en el
+//camino mas profundo de la carga de glifos
+#define FIN_RANURAS ((uint8_t)(CACHE_DIR_RANURAS + CACHE_RANURAS * CACHE_BYTES_RANURA))
+
+//Direccion de la ranura del caracter, o 0 si no esta en la cache
+static uint8_t buscaRanura(unsigned char caracter)
+{
+    uint8_t dir;
+    for (dir = CACHE_DIR_RANURAS; dir != FIN_RANURAS; dir += CACHE_BYTES_RANURA)
+        if (leeEEInterna(dir) == caracter)
+            return dir;
+    return 0;
+}
+
+static uint8_t usosDe(unsigned char caracter)
+{
+    uint8_t k;
+    for (k = 0; k < CACHE_CONTADORES; k++)
+        if (contadores[k].caracter == caracter)
+            return contadores[k].usos;
+    return 0;
+}
+
+//Cuenta un uso: si el caracter no tiene contador toma el del caracter con
+//menos usos y hereda su cuenta, de modo que los que se usan seguido no se
+//pierden aunque entren caracteres nuevos
+static void cuentaUso(unsigned char caracter)
+{
+    uint8_t k, menor = 0;
+
+    for (k = 0; k < CACHE_CONTADORES; k++)
+    {
+        if (contadores[k].caracter == caracter)
+            break;
+        if (contadores[k].usos < contadores[menor].usos)
+            menor = k;
+    }
+    if (k == CACHE_CONTADORES)
+    {
+        k = menor;
+        contadores[k].caracter = caracter;
+    }
+    if (contadores[k].usos == 255)
+    {
+        for (menor = 0; menor < CACHE_CONTADORES; menor++)
+            contadores[menor].usos >>= 1;
+    }
+    contadores[k].usos++;
+}
+
+static void incrementa(unsigned int *contador)
+{
+    if (*contador != 0xFFFF)
+        (*contador)++;
+}
+
+void indiceCacheGlifos(unsigned char posicion, unsigned char caracter)
+{
+    if (posicion < CACHE_INDICE_MAX)
+        escribeEEInterna(CACHE_DIR_INDICE + posicion, caracter);
+}
+
+void fuenteCacheGlifos(unsigned char glifos, uint16_t suma)
+{
+    uint8_t r;
+
+    cacheValido = 0;
+    pasoPendiente = 0;
+    if (leeEEInterna(CACHE_DIR_FIRMA) != CACHE_GLIFOS_FIRMA ||
+        leeEEInterna(CACHE_DIR_GLIFOS) != glifos ||
+        leeEEInterna(CACHE_DIR_SUMA) != (suma & 0x00FF) ||
+        leeEEInterna(CACHE_DIR_SUMA + 1) != (suma >> 8))
+    {
+        //Otra fuente: primero se invalida la cabecera, por si se corta la
+        //alimentacion a la mitad
+        escribeEEInterna(CACHE_DIR_GLIFOS, 0);
+        for (r = CACHE_DIR_RANURAS; r != FIN_RANURAS; r += CACHE_BYTES_RANURA)
+            escribeEEInterna(r, 0);
+        escribeEEInterna(CACHE_DIR_SUMA, suma & 0x00FF);
+        escribeEEInterna(CACHE_DIR_SUMA + 1, suma >> 8);
+        escribeEEInterna(CACHE_DIR_FIRMA, CACHE_GLIFOS_FIRMA);
+        escribeEEInterna(CACHE_DIR_GLIFOS, glifos);
+    }
+    for (r = 0; r < CACHE_CONTADORES; r++)
+    {
+        contadores[r].caracter = 0;
+        contadores[r].usos = 0;
+    }
+    cargasSinReemplazo = CACHE_PERIODO_REEMPLAZO;
+    cacheValido = (glifos != 0);
+}
+
+unsigned char caracterIndiceCacheGlifos(unsigned char posicion)
+{
+    //Durante una escritura interna la 93LC66B responde antes
+    if (posicion < CACHE_INDICE_MAX && !escribiendoEEInterna())
+        return leeEEInterna(CACHE_DIR_INDICE + posicion);
+    return 0;
+}
+
+unsigned char leeCacheGlifos(char dat, uint8_t *patrones)
+{
+    unsigned char caracter = dat;
+    uint8_t dir, j;
+
+    //Durante una escritura no se espera: el glifo se lee de la 93LC66B
+    if (!cacheValido || caracter == 0 || escribiendoEEInterna())
+        return 0;
+    dir = buscaRanura(caracter);
+    if (dir == 0)
+        return 0;
+    for (j = 0; j < ANCHO_MAX_GLIFO; j++)
+        patrones[j] = leeEEInterna(dir + 2 + j);
+    incrementa(&aciertos);
+    cuentaUso(caracter);
+    return leeEEInterna(dir + 1);
+}
+
+void guardaCacheGlifos(char dat, const uint8_t *patrones, unsigned char ancho)
+{
+    uint8_t menor = 255, dir, j;
+
+    incrementa(&fallos);
+    if (!cacheValido || dat == 0)
+        return;
+    cuentaUso(dat);
+    if (cargasSinReemplazo < CACHE_PERIODO_REEMPLAZO)
+        cargasSinReemplazo++;
+    //Una ranura a la vez, y sin esperar a que termine una escritura
+    if (pasoPendiente != 0 || escribiendoEEInterna())
+        return;
+    //Sin ranura pendiente dirPendiente esta libre y guarda la victima
+    for (dir = CACHE_DIR_RANURAS; dir != FIN_RANURAS; dir += CACHE_BYTES_RANURA)
+    {
+        j = leeEEInterna(dir);
+        if (j == 0)
+        {
+            //Las ranuras libres se llenan sin esperar
+            dirPendiente = dir;
+            break;
+        }
+        j = usosDe(j);
+        if (j < menor)
+        {
+            menor = j;
+            dirPendiente = dir;
+        }
+    }
+    if (dir == FIN_RANURAS)
+    {
+        //Todas ocupadas: se reemplaza la de menos usos, con histeresis y
+        //periodo. Los usos del caracter se vuelven a buscar en lugar de
+        //guardarlos, por la pila compilada.
+        if (cargasSinReemplazo < CACHE_PERIODO_REEMPLAZO ||
+            usosDe(dat) < (unsigned int)menor + CACHE_HISTERESIS)
+            return;
+        cargasSinReemplazo = 0;
+    }
+    ranuraPendiente[0] = dat;
+    ranuraPendiente[1] = ancho;
+    for (j = 0; j < ANCHO_MAX_GLIFO; j++)
+        ranuraPendiente[2 + j] = patrones[j];
+    pasoPendiente = 1;
+}
+
+void pasoCacheGlifos(void)
+{
+    uint8_t k;
+
+    if (pasoPendiente == 0 || escribiendoEEInterna())
+        return;
+    k = pasoPendiente - 1;
+    if (k == CACHE_BYTES_RANURA)
+    {
+        //El caracter se graba al final: una ranura a medio grabar queda libre
+        escribeEEInterna(dirPendiente, ranuraPendiente[0]);
+        pasoPendiente = 0;
+        return;
+    }
+    escribeEEInterna(dirPendiente + k, (k == 0) ? 0 : ranuraPendiente[k]);
+    pasoPendiente++;
+}
+
+unsigned int aciertosCacheGlifos(void)
+{
+    return aciertos;
+}
+
+unsigned int fallosCacheGlifos(void)
+{
+    return fallos;
+}
@@ -0,0 +1,130 @@
+/*
+ * File:   cacheGlifos.h
+ * Author:
+ * Comments: Segundo nivel de cache de glifos en la EEPROM de datos interna
+ *           del PIC: indice de caracteres y glifos mas usados
+ * Revision history:
+ */
+
+// This is a guard condition so that contents of this file are not included
+// more than once.
+#ifndef CACHEGLIFOS_H
+#define	CACHEGLIFOS_H
+
+#include <xc.h> // include processor files - each processor file is guarded.
+#include <stdint.h>
+#include "eeinterna.h"
+#include "matrizLed.h"
+
+/*
+ * Niveles de la carga de glifos:
+ *   1. RAM: indice en RAM (INDICE_MAX).
+ *   2. EEPROM interna: este modulo.
+ *   3. 93LC66B: la fuente completa.
+ *
+ * Organizacion de la EEPROM interna (direcciones en bytes):
+ *
+ *   0   firma CACHE_GLIFOS_FIRMA
+ *   1   glifos de la fuente guardada (0 si no hay fuente valida)
+ *   2   suma de verificacion de la fuente (LSB primero)
+ *   4   caracteres del indice de la fuente, en orden (CACHE_INDICE_MAX)
+ *   44  ranuras de glifos: caracter (0 = libre), ancho y ANCHO_MAX_GLIFO
+ *       columnas (CACHE_RANURAS de CACHE_BYTES_RANURA bytes)
+ *
+ * El contenido sobrevive a los reinicios; si la fuente de la 93LC66B cambia
+ * (otra suma de verificacion) las ranuras se vacian.
+ */
+#define CACHE_GLIFOS_FIRMA 0xC6
+#define CACHE_DIR_FIRMA 0
+#define CACHE_DIR_GLIFOS 1
+#define CACHE_DIR_SUMA 2
+#define CACHE_DIR_INDICE 4
+#define CACHE_INDICE_MAX 40
+#define CACHE_DIR_RANURAS (CACHE_DIR_INDICE + CACHE_INDICE_MAX)
+#define CACHE_BYTES_RANURA (2 + ANCHO_MAX_GLIFO)
+#define CACHE_RANURAS 8
+#if CACHE_DIR_RANURAS + CACHE_RANURAS * CACHE_BYTES_RANURA > EEINTERNA_BYTES
+#error "Las ranuras de glifos no caben en la EEPROM interna"
+#endif
+
+//Caracteres cuyo uso se cuenta en RAM para elegir los glifos de las ranuras.
+//Los contadores se reparten entre los caracteres vistos mas veces (los demas
+//se olvidan), y se dividen a la mitad cuando uno llega a 255 para que el
+//conjunto se adapte a los mensajes recientes.
+#define CACHE_CONTADORES 4
+//Un glifo reemplaza al de una ranura solo si se ha usado al menos tantas
+//veces mas; evita que dos glifos se alternen en la misma ranura
+#define CACHE_HISTERESIS 4
+//Cargas desde la 93LC66B que deben pasar entre dos reemplazos. Limita el
+//desgaste de la EEPROM interna (cada reemplazo graba CACHE_BYTES_RANURA
+//bytes) cuando los mensajes usan mas glifos que ranuras.
+#define CACHE_PERIODO_REEMPLAZO 32
+
+/**
+ * @brief Guarda en la EEPROM interna un carácter del índice de la fuente.
+ *
+ * @param posicion Posición del carácter en el índice (0 es el primero).
+ * @param caracter Carácter de esa entrada.
+ *
+ * @details `init_matrizLed()` la llama para cada entrada mientras lee la imagen. Solo se graban las posiciones menores que `CACHE_INDICE_MAX` y solo si cambiaron, así que con la misma fuente no se escribe nada.
+ */
+void indiceCacheGlifos(unsigned char posicion, unsigned char caracter);
+/**
+ * @brief Registra la fuente que se acaba de cargar y vacía las ranuras si es otra.
+ *
+ * @param glifos Número de glifos de la fuente, o 0 si la imagen no es válida.
+ * @param suma Suma de verificación de la fuente.
+ *
+ * @details Compara la cabecera de la EEPROM interna con la fuente. Si coinciden, los glifos guardados siguen sirviendo desde el arranque anterior; si no, libera todas las ranuras y graba la nueva cabecera. Con `glifos` en 0 el cache queda deshabilitado.
+ */
+void fuenteCacheGlifos(unsigned char glifos, uint16_t suma);
+/**
+ * @brief Carácter de una posición del índice de la fuente.
+ *
+ * @param posicion Posición en el índice.
+ *
+ * @pre La fuente debe estar cargada (`fuenteCacheGlifos()` con una fuente válida).
+ *
+ * @return El carácter, leído de la EEPROM interna, o 0 si `posicion` no es menor que `CACHE_INDICE_MAX` o si hay una escritura interna en curso (no se espera). Con 0 quien llama lee la entrada en la 93LC66B; no lo hace esta función para no sumar un nivel a la pila de hardware en la búsqueda del índice.
+ */
+unsigned char caracterIndiceCacheGlifos(unsigned char posicion);
+/**
+ * @brief Busca un glifo en las ranuras de la EEPROM interna.
+ *
+ * @param dat Carácter a buscar.
+ * @param patrones Arreglo de `ANCHO_MAX_GLIFO` bytes donde se copian las columnas si el glifo está guardado.
+ *
+ * @details Si lo encuentra cuenta un acierto y un uso del carácter. No accede a la 93LC66B: cada byte interno se lee en un ciclo de instrucción. Mientras hay una escritura interna en curso (`escribiendoEEInterna()`) no espera y regresa 0, de modo que el glifo se lee de la 93LC66B.
+ *
+ * @return El ancho del glifo, o 0 si no está en ninguna ranura (`patrones` no se modifica).
+ */
+unsigned char leeCacheGlifos(char dat, uint8_t *patrones);
+/**
+ * @brief Informa un glifo que se tuvo que leer de la 93LC66B y decide si se guarda en una ranura.
+ *
+ * @param dat Carácter leído.
+ * @param patrones Sus `ANCHO_MAX_GLIFO` columnas.
+ * @param ancho Su ancho en columnas.
+ *
+ * @details Cuenta un fallo y un uso del carácter. Si hay una ranura libre el glifo se guarda ahí; si no, reemplaza al glifo guardado con menos usos cuando el nuevo lo supera por `CACHE_HISTERESIS` y ya pasaron `CACHE_PERIODO_REEMPLAZO` cargas desde el último reemplazo. No graba nada: copia el glifo en RAM y `pasoCacheGlifos()` lo escribe después, así que no bloquea la carga. Solo hay una ranura en espera; mientras se graba (unos 40 ms, 10 bytes de 4 ms) los demás glifos no se guardan.
+ */
+void guardaCacheGlifos(char dat, const uint8_t *patrones, unsigned char ancho);
+/**
+ * @brief Graba un byte de la ranura en espera, si la EEPROM interna está libre.
+ *
+ * @details Regresa de inmediato si no hay ranura en espera o si sigue la escritura anterior (`escribiendoEEInterna()`); si no, arranca la escritura del siguiente byte y regresa sin esperarla. Primero borra el carácter de la ranura, después graba el ancho y las columnas y al final el carácter nuevo, de modo que una ranura a medio grabar (o un reinicio en medio) la deja libre. Se llama como tarea del ciclo principal (ver `main.c`).
+ *
+ * @code
+ * while (1) {
+ *     pasoCacheGlifos();
+ *     // ...
+ * }
+ * @endcode
+ */
+void pasoCacheGlifos(void);
+/** @brief Glifos que se encontraron en la EEPROM interna. */
+unsigned int aciertosCacheGlifos(void);
+/** @brief Glifos que se tuvieron que leer de la 93LC66B. */
+unsigned int fallosCacheGlifos(void);
+
+#endif	/* XC_HEADER_TEMPLATE_H */
@@ -0,0 +1,421 @@
+#include "comandos.h"
+
+//Estados de la recepcion de tramas
+#define ESPERA_SYNC 0
+#define ESPERA_LONGITUD 1
+#define ESPERA_TIPO 2
+#define ESPERA_DATOS 3
+#define ESPERA_CRC 4
+
+static uint8_t estado = ESPERA_SYNC;
+static uint8_t longitud;
+static uint8_t tipo;
+//Los DATOS de 'M' y 'P' se reciben en datos y el texto de 'M' se muestra
+//desde ahi sin copiarlo; los demas comandos usan argumentos para no borrar el
+//mensaje. La interrupcion nunca escribe datos[COMANDO_MAX_DATOS]: aun a medio
+//recibir otra trama el texto termina en un nulo.
+static uint8_t datos[MENSAJE_MAX];
+static uint8_t argumentos[COMANDO_MAX_ARGUMENTOS];
+static uint8_t indice;
+static uint8_t crc;         //CRC recibido; se revisa en atiendeComandos()
+static volatile uint8_t tramaPendiente = 0;
+
+#define DATOS_LARGOS(t) ((t) == COMANDO_MENSAJE || (t) == COMANDO_PROGRAMA)
+
+//Trama 'P' en curso: se revisa o graba una palabra por llamada
+#define PROGRAMA_LIBRE 0xFF
+//Resultado de pasoPrograma()
+#define PROGRAMA_SIGUE 0
+#define PROGRAMA_TERMINA 1
+#define PROGRAMA_FALLA 2
+static uint8_t palabraPrograma = PROGRAMA_LIBRE;    //siguiente palabra de la trama
+static uint8_t escritasPrograma;
+static uint8_t verificaPrograma;    //la palabra actual ya se escribio una vez
+static uint16_t inicioEscritura;    //Timer1 al empezar la escritura en curso
+
+//Respuesta 'D', 'E' o 'T' en curso: partes que faltan por encolar (0:
+//ninguna; palabras en 'D' y 'E', tareas mas las paradas en 'T')
+static uint8_t partesRespuesta = 0;
+//Palabras de la respuesta 'E'
+#define ESTADISTICAS_PALABRAS 7
+
+static unsigned int tramasValidas = 0;
+static unsigned int erroresCRC = 0;
+static volatile unsigned int tramasPerdidas = 0;
+
+//En la interrupcion se cuenta sin llamar a incrementa(): cada llamada gasta
+//un nivel de la pila de hardware
+#define CUENTA_PERDIDA() do { if (tramasPerdidas != 0xFFFF) tramasPerdidas++; } while (0)
+
+static void incrementa(unsigned int *contador)
+{
+    if (*contador != 0xFFFF)
+        (*contador)++;
+}
+
+void init_comandos(void)
+{
+    estado = ESPERA_SYNC;
+    tramaPendiente = 0;
+}
+
+void procesaByteComando(uint8_t dat)
+{
+    if (tramaPendiente)
+    {
+        if (dat == COMANDO_SYNC)
+            CUENTA_PERDIDA();
+        return;
+    }
+    switch (estado)
+    {
+        case ESPERA_SYNC:
+            if (dat == COMANDO_SYNC)
+                estado = ESPERA_LONGITUD;
+            break;
+        case ESPERA_LONGITUD:
+            if (dat > COMANDO_MAX_DATOS)
+            {
+                CUENTA_PERDIDA();
+                estado = (dat == COMANDO_SYNC) ? ESPERA_LONGITUD : ESPERA_SYNC;
+                break;
+            }
+            longitud = dat;
+            estado = ESPERA_TIPO;
+            break;
+        case ESPERA_TIPO:
+            tipo = dat;
+            indice = 0;
+            if (longitud > COMANDO_MAX_ARGUMENTOS && !DATOS_LARGOS(dat))
+            {
+                CUENTA_PERDIDA();
+                estado = ESPERA_SYNC;
+                break;
+            }
+            estado = (longitud == 0) ? ESPERA_CRC : ESPERA_DATOS;
+            break;
+        case ESPERA_DATOS:
+            if (DATOS_LARGOS(tipo))
+                datos[indice] = dat;
+            else
+                argumentos[indice] = dat;
+            indice++;
+            if (indice == longitud)
+                estado = ESPERA_CRC;
+            break;
+        default:
+            crc = dat;
+            tramaPendiente = 1;
+            estado = ESPERA_SYNC;
+            break;
+    }
+}
+
+static void respondeNAK(void)
+{
+    iniciaTrama(COMANDO_NAK, 1);
+    enviaDatoTrama(tipo);
+    terminaTrama();
+}
+
+//Solo envia el encabezado; las palabras las envia pasoVolcado() en las
+//siguientes llamadas a atiendeComandos()
+static void ejecutaVolcado(void)
+{
+    if (longitud != 3 || argumentos[2] == 0 || argumentos[2] > VOLCADO_MAX_PALABRAS)
+    {
+        respondeNAK();
+        return;
+    }
+    partesRespuesta = argumentos[2];
+    iniciaTrama(COMANDO_VOLCADO, partesRespuesta * 2);
+}
+
+//Envia hasta VOLCADO_PALABRAS_PASO palabras del volcado en curso si caben en
+//el buffer de transmision; si no caben regresa sin esperar. La lectura se
+//reinicia en cada parte porque entre llamadas la marquesina usa la EEPROM; la
+//interrupcion no toca argumentos mientras la trama esta pendiente, y de ahi
+//salen la direccion inicial y el total de palabras. Regresa 1 cuando se envio
+//la ultima palabra y el CRC.
+static uint8_t pasoVolcado(void)
+{
+    uint8_t k, n = VOLCADO_PALABRAS_PASO;
+    
+    if (partesRespuesta < n)
+        n = partesRespuesta;
+    if (espacioTxRS232() < 2 * n + (partesRespuesta == n))
+        return 0;
+    iniciaLectura93LC66B((argumentos[0] | ((unsigned int)argumentos[1] << 8))
+                         + 2 * (argumentos[2] - partesRespuesta));
+    for (k = 0; k < n; k++)
+        enviaPalabraTrama(leeMemoria());
+    terminaLectura93LC66B();
+    partesRespuesta -= n;
+    if (partesRespuesta != 0)
+        return 0;
+    terminaTrama();
+    return 1;
+}
+
+static void iniciaPrograma(void)
+{
+    if (longitud < 4 || (longitud & 1) != 0)
+    {
+        respondeNAK();
+        return;
+    }
+    habilitaEscritura93LC66B();
+    palabraPrograma = 0;
+    escritasPrograma = 0;
+    verificaPrograma = 0;
+}
+
+static void terminaPrograma(uint8_t error)
+{
+    protegeEscritura93LC66B();
+    palabraPrograma = PROGRAMA_LIBRE;
+    if (error)
+    {
+        respondeNAK();
+        return;
+    }
+    iniciaTrama(COMANDO_PROGRAMA, 1);
+    enviaDatoTrama(escritasPrograma);
+    terminaTrama();
+}
+
+//Igual que programaImagen93LC66B(), pero sin esperar el ciclo de escritura:
+//mientras la memoria esta ocupada regresa PROGRAMA_SIGUE y la tarea de
+//comandos cede el procesador. Al terminar regresa PROGRAMA_TERMINA o
+//PROGRAMA_FALLA y atiendeComandos() responde con terminaPrograma(), un nivel
+//de la pila de hardware mas arriba.
+static uint8_t pasoPrograma(void)
+{
+    unsigned int direccion, dato;
+    
+    if (ocupado93LC66B())
+    {
+        if ((uint16_t)(leeTimer1() - inicioEscritura) < COMANDO_ESPERA_ESCRITURA)
+            return PROGRAMA_SIGUE;
+        return PROGRAMA_FALLA;
+    }
+    direccion = 2 * palabraPrograma;
+    dato = datos[2 + direccion] | ((unsigned int)datos[3 + direccion] << 8);
+    direccion += datos[0] | ((unsigned int)datos[1] << 8);
+    //Las palabras que ya tienen el valor no gastan un ciclo de escritura
+    if (lee93LC66B(direccion) != dato)
+    {
+        if (verificaPrograma)
+        {
+            //Ya se escribio y no quedo
+            return PROGRAMA_FALLA;
+        }
+        escribe93LC66B(direccion, dato);
+        inicioEscritura = leeTimer1();
+        escritasPrograma++;
+        verificaPrograma = 1;
+        return PROGRAMA_SIGUE;
+    }
+    verificaPrograma = 0;
+    palabraPrograma++;
+    if (palabraPrograma < (longitud - 2) / 2)
+        return PROGRAMA_SIGUE;
+    return PROGRAMA_TERMINA;
+}
+
+//Como 'D': solo envia el encabezado y pasoTareas() encola el resto
+static void ejecutaTareas(void)
+{
+    partesRespuesta = numTareas() + 1;
+    iniciaTrama(COMANDO_TAREAS, 3 * partesRespuesta - 1);
+}
+
+//Encola las tareas que quepan en el buffer de transmision y al final las
+//paradas de la ventana y el CRC; regresa 1 cuando se envio todo. Cada tarea se
+//lee al encolarla.
+static uint8_t pasoTareas(void)
+{
+    uint8_t k;
+    
+    while (espacioTxRS232() >= 3)
+    {
+        if (partesRespuesta == 1)
+        {
+            enviaPalabraTrama(paradasVentana());
+            terminaTrama();
+            partesRespuesta = 0;
+            return 1;
+        }
+        k = numTareas() + 1 - partesRespuesta;
+        enviaPalabraTrama(peorTarea(k));
+        enviaDatoTrama(excesosTarea(k));
+        partesRespuesta--;
+    }
+    return 0;
+}
+
+#if PERFIL_ACTIVO
+static void ejecutaPerfil(void)
+{
+    RegistroPerfil registro;
+    uint8_t r;
+    
+    if (longitud > 1)
+    {
+        respondeNAK();
+        return;
+    }
+    iniciaTrama(COMANDO_PERFIL, 3 + 10 * PERFIL_REGIONES);
+    enviaDatoTrama(PERFIL_REGIONES);
+    enviaPalabraTrama(TIMER1_CUENTAS_MS);
+    for (r = 0; r < PERFIL_REGIONES; r++)
+    {
+        leePerfil(r, &registro);
+        enviaPalabraTrama(registro.cuenta);
+        enviaPalabraTrama(registro.minimo);
+        enviaPalabraTrama(registro.maximo);
+        enviaPalabraTrama(registro.suma & 0xFFFF);
+        enviaPalabraTrama(registro.suma >> 16);
+    }
+    terminaTrama();
+    if (longitud == 1 && argumentos[0] != 0)
+        limpiaPerfil();
+}
+#endif
+
+//Encola las palabras de la respuesta 'E' que quepan en el buffer de
+//transmision; regresa 1 cuando se envio la ultima y el CRC. Cada contador se
+//lee al encolarlo.
+static uint8_t pasoEstadisticas(void)
+{
+    unsigned int palabra;
+    
+    while (espacioTxRS232() >= 2 + (partesRespuesta == 1))
+    {
+        switch (ESTADISTICAS_PALABRAS - partesRespuesta)
+        {
+            case 0: palabra = tramasValidas; break;
+            case 1: palabra = erroresCRC; break;
+            case 2: palabra = tramasPerdidas; break;
+            case 3: palabra = desbordesRS232(); break;
+            case 4: palabra = descartadosRS232(); break;
+            case 5: palabra = aciertosCacheGlifos(); break;
+            default: palabra = fallosCacheGlifos(); break;
+        }
+        enviaPalabraTrama(palabra);
+        partesRespuesta--;
+        if (partesRespuesta == 0)
+        {
+            terminaTrama();
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void atiendeComandos(void)
+{
+    uint8_t k, c;
+    
+    if (!tramaPendiente)
+        return;
+    if (palabraPrograma != PROGRAMA_LIBRE)
+    {
+        //Trama 'P' a medias: sigue donde se quedo
+        k = pasoPrograma();
+        if (k != PROGRAMA_SIGUE)
+        {
+            terminaPrograma(k == PROGRAMA_FALLA);
+            tramaPendiente = 0;
+        }
+        return;
+    }
+    if (partesRespuesta != 0)
+    {
+        //Respuesta 'D', 'E' o 'T' a medias. Sin una funcion que reparta: seria
+        //un nivel mas de la pila de hardware.
+        if (tipo == COMANDO_VOLCADO)
+            k = pasoVolcado();
+        else if (tipo == COMANDO_ESTADISTICAS)
+            k = pasoEstadisticas();
+        else
+            k = pasoTareas();
+        if (k)
+            tramaPendiente = 0;
+        return;
+    }
+    //El CRC se revisa aqui y no byte por byte en la interrupcion, que asi
+    //queda sin llamadas (ver procesaByteComando())
+    c = actualizaCRC8(actualizaCRC8(0, longitud), tipo);
+    for (k = 0; k < longitud; k++)
+        c = actualizaCRC8(c, DATOS_LARGOS(tipo) ? datos[k] : argumentos[k]);
+    if (c != crc)
+    {
+        //Una 'M' o 'P' invalida ya sobreescribio el mensaje
+        if (DATOS_LARGOS(tipo))
+            cambiaMensajeMarquesina("");
+        incrementa(&erroresCRC);
+        tramaPendiente = 0;
+        return;
+    }
+    incrementa(&tramasValidas);
+    switch (tipo)
+    {
+        case COMANDO_MENSAJE:
+            datos[longitud] = 0;
+            cambiaMensajeMarquesina((const char *)datos);
+            iniciaTrama(COMANDO_MENSAJE, 0);
+            terminaTrama();
+            break;
+        case COMANDO_VELOCIDAD:
+            if (longitud != 1)
+            {
+                respondeNAK();
+                break;
+            }
+            cambiaVelocidadMarquesina(argumentos[0]);
+            iniciaTrama(COMANDO_VELOCIDAD, 0);
+            terminaTrama();
+            break;
+        case COMANDO_VOLCADO:
+            ejecutaVolcado();
+            //La trama ocupa el buffer hasta que se envien todas sus palabras
+            if (partesRespuesta != 0)
+                return;
+            break;
+        case COMANDO_ESTADISTICAS:
+            //Las palabras salen en las siguientes llamadas
+            iniciaTrama(COMANDO_ESTADISTICAS, 2 * ESTADISTICAS_PALABRAS);
+            partesRespuesta = ESTADISTICAS_PALABRAS;
+            return;
+        case COMANDO_PROGRAMA:
+            //Los datos de la trama estan donde estaba el mensaje
+            cambiaMensajeMarquesina("");
+            iniciaPrograma();
+            //La trama ocupa el buffer hasta que se graben todas sus palabras
+            if (palabraPrograma != PROGRAMA_LIBRE)
+                return;
+            break;
+        case COMANDO_TAREAS:
+            ejecutaTareas();
+            return;
+#if PERFIL_ACTIVO
+        case COMANDO_PERFIL:
+            ejecutaPerfil();
+            break;
+#endif
+        case COMANDO_RECARGA:
+            //Los glifos de la tira y del cache son de la fuente anterior
+            init_matrizLed();
+            redibujaMarquesina();
+            iniciaTrama(COMANDO_RECARGA, 1);
+            enviaDatoTrama(glifosFuente());
+            terminaTrama();
+            break;
+        default:
+            respondeNAK();
+            break;
+    }
+    //Libera el buffer de la trama para la interrupcion
+    tramaPendiente = 0;
+}
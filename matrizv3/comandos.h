@@ -0,0 +1,156 @@
+/* 
+ * File:   comandos.h
+ * Author: 
+ * Comments: Protocolo de comandos por RS-232 para cambiar el mensaje en tiempo de ejecucion
+ * Revision history: 
+ */
+
+// This is a guard condition so that contents of this file are not included
+// more than once.  
+#ifndef COMANDOS_H
+#define	COMANDOS_H
+
+#include <xc.h> // include processor files - each processor file is guarded.  
+#include <stdint.h>
+#include "rs232.h"
+#include "telemetria.h"
+#include "m93lc66b.h"
+#include "marquesina.h"
+#include "cacheGlifos.h"
+#include "timer1.h"
+#include "tareas.h"
+
+/*
+ * Formato de trama (comandos y respuestas; las respuestas se arman con las
+ * funciones de telemetria.h):
+ *
+ *   0x7E | LONGITUD | TIPO | DATOS[LONGITUD] | CRC8
+ *
+ * LONGITUD es el numero de bytes de DATOS. El CRC-8 (polinomio 0x07, valor
+ * inicial 0) se calcula sobre LONGITUD, TIPO y DATOS. Los valores de 16 bits
+ * se envian con el byte menos significativo primero.
+ *
+ * Comandos:
+ *   'M' texto             Cambia el mensaje de la marquesina. Responde 'M' sin datos.
+ *                         El texto se muestra desde el buffer de la trama, sin
+ *                         copiarlo: mientras llega otra trama 'M' o 'P' el
+ *                         mensaje se sobreescribe, y si esa trama no es valida
+ *                         o es una 'P' la marquesina queda en blanco hasta el
+ *                         siguiente 'M'.
+ *   'V' velocidad         Columnas por segundo. Responde 'V' sin datos.
+ *   'D' dir(2) palabras   Lee palabras de la EEPROM desde la direccion dir
+ *                         (misma convencion que lee93LC66B). Responde 'D' con
+ *                         las palabras, LSB primero, como en tabla_leds.bin.
+ *   'E'                   Estadisticas. Responde 'E' con tramas validas,
+ *                         errores de CRC, tramas perdidas, desbordes de RX,
+ *                         bytes descartados de TX, aciertos y fallos del
+ *                         cache de glifos de la EEPROM interna (16 bits cada
+ *                         uno). Como 'D' y 'T', la respuesta se encola por
+ *                         partes y cada contador se lee al encolarlo.
+ *   'P' dir(2) palabras   Graba en la EEPROM las palabras (LSB primero, como
+ *                         en tabla_leds.bin) a partir de la direccion dir y
+ *                         verifica cada una. Responde 'P' con el numero de
+ *                         palabras que cambiaron, o COMANDO_NAK si alguna no
+ *                         se pudo grabar. Las palabras se graban sin bloquear
+ *                         el ciclo principal (ver atiendeComandos()).
+ *   'T'                   Tareas. Responde 'T' con el peor tiempo de
+ *                         ejecucion (16 bits, cuentas del Timer1) y las
+ *                         ejecuciones fuera de presupuesto (8 bits) de cada
+ *                         tarea del planificador, en el orden de su tabla, y
+ *                         al final las paradas de la ventana de la pantalla
+ *                         (16 bits, ver paradasVentana()).
+ *   'F' [limpia(1)]       Perfil (solo si se compila con PERFIL_ACTIVO).
+ *                         Responde 'F' con el numero de regiones (8 bits),
+ *                         las cuentas del Timer1 por ms (16 bits) y, por
+ *                         cada region de perfil.h, cuenta, minimo y maximo
+ *                         (16 bits) y suma (32 bits). Si limpia no es 0 la
+ *                         tabla se pone en cero despues de enviarla.
+ *                         herramientas/perfil.py la muestra como reporte.
+ *   'R'                   Recarga la fuente de la EEPROM y reinicia la
+ *                         marquesina. Responde 'R' con el numero de glifos
+ *                         (0 si la imagen no es valida).
+ *
+ * Para grabar una imagen completa (herramientas/programa.py) se envia en
+ * tramas 'P' de hasta PROGRAMA_MAX_PALABRAS palabras, se termina con 'R' y se
+ * compara la imagen con volcados 'D'.
+ *
+ * Cualquier otro comando o argumento invalido responde COMANDO_NAK con el tipo
+ * recibido como dato. Una trama de otro tipo con mas de COMANDO_MAX_ARGUMENTOS
+ * bytes de DATOS se descarta sin respuesta, como la que rebasa
+ * COMANDO_MAX_DATOS.
+ */
+#define COMANDO_SYNC TRAMA_SYNC
+#define COMANDO_MENSAJE 'M'
+#define COMANDO_VELOCIDAD 'V'
+#define COMANDO_VOLCADO 'D'
+#define COMANDO_ESTADISTICAS 'E'
+#define COMANDO_PROGRAMA 'P'
+#define COMANDO_RECARGA 'R'
+#define COMANDO_TAREAS 'T'
+#define COMANDO_PERFIL 'F'
+#define COMANDO_NAK 0x15
+
+//Longitud maxima de DATOS en un comando y del mensaje (incluye el nulo)
+#define COMANDO_MAX_DATOS 16
+#define MENSAJE_MAX (COMANDO_MAX_DATOS + 1)
+//Longitud maxima de DATOS de los comandos que no son 'M' ni 'P'
+#define COMANDO_MAX_ARGUMENTOS 3
+//Palabras maximas por volcado de EEPROM (la respuesta usa 2 bytes por palabra)
+#define VOLCADO_MAX_PALABRAS 127
+//Palabras del volcado que se leen y encolan en cada llamada a atiendeComandos();
+//la ultima parte lleva ademas el CRC y debe caber en el buffer de transmision
+#ifndef VOLCADO_PALABRAS_PASO
+#define VOLCADO_PALABRAS_PASO 3
+#endif
+#if 2 * VOLCADO_PALABRAS_PASO + 1 > RS232_TX_TAM
+#error "VOLCADO_PALABRAS_PASO no cabe en el buffer de transmision"
+#endif
+//Palabras maximas por trama de programacion (2 bytes de DATOS son la direccion)
+#define PROGRAMA_MAX_PALABRAS ((COMANDO_MAX_DATOS - 2) / 2)
+//Tiempo maximo de un ciclo de escritura de la EEPROM durante una trama 'P'
+//antes de responder COMANDO_NAK (cuentas del Timer1)
+#define COMANDO_ESPERA_ESCRITURA (20 * TIMER1_CUENTAS_MS)
+
+/**
+ * @brief Inicializa el intérprete de comandos.
+ *
+ * @pre `init_rs232()` debe haberse llamado previamente; la recepción por interrupción queda habilitada ahí.
+ *
+ * @code
+ * init_rs232();
+ * init_comandos();
+ * @endcode
+ */
+void init_comandos(void);
+/**
+ * @brief Alimenta la máquina de estados del intérprete con un byte recibido.
+ *
+ * @param dat Byte recibido por el puerto serial.
+ *
+ * @details Busca el byte de sincronía y acumula longitud, tipo, datos y CRC-8. Los datos de 'M' y 'P' se guardan en el buffer del que la marquesina lee el mensaje; los de los demás comandos, en uno de `COMANDO_MAX_ARGUMENTOS` bytes, para no borrar el mensaje. Cuando la trama está completa queda pendiente para `atiendeComandos()`, que revisa el CRC; así la rutina de interrupción no llama a ninguna otra función y no gasta niveles de la pila de hardware. Mientras haya una trama pendiente, los bytes recibidos se descartan y cuentan como tramas perdidas, de modo que la rutina de interrupción nunca espera al programa principal.
+ *
+ * @code
+ * if (PIE1bits.RCIE && PIR1bits.RCIF)
+ *     procesaByteComando(recibeRS232());
+ * @endcode
+ *
+ * @remark Se llama desde la interrupción de recepción, pero no depende del hardware: puede alimentarse con cualquier flujo de bytes.
+ */
+void procesaByteComando(uint8_t dat);
+/**
+ * @brief Ejecuta la trama pendiente, si la hay, y envía su respuesta.
+ *
+ * @details Se llama desde el ciclo principal. Primero revisa el CRC-8 de la trama; si no coincide la descarta sin responder y la cuenta como error de CRC. Cambiar el mensaje o la velocidad solo modifica la marquesina, que sigue mostrándose por interrupción. Las respuestas cortas usan `enviaRS232()`, que solo espera cuando el buffer de transmisión está lleno. El volcado 'D' se envía por partes, como la trama 'P': cada llamada lee `VOLCADO_PALABRAS_PASO` palabras con una lectura secuencial y las encola solo si caben (`espacioTxRS232()`); si no caben regresa de inmediato, de modo que un volcado de `VOLCADO_MAX_PALABRAS` palabras (unos 265 ms a 9600 bps) no detiene a las demás tareas. Una trama 'P' se graba en varias llamadas: cada una revisa o escribe una palabra y, mientras la EEPROM termina su ciclo de escritura (unos 2 ms), regresa de inmediato para que corran las demás tareas; la trama ocupa el buffer hasta que se responde, y el programa de carga espera la respuesta antes de enviar la siguiente.
+ *
+ * @pre `init_timer1()` debe haberse llamado previamente (mide el tiempo máximo de escritura `COMANDO_ESPERA_ESCRITURA`).
+ *
+ * @code
+ * static const Tarea tareas[] = {
+ *     { atiendeComandos, 1, 5000 },
+ *     { actualizaMarquesina, 1, 2000 },
+ * };
+ * @endcode
+ */
+void atiendeComandos(void);
+
+#endif	/* XC_HEADER_TEMPLATE_H */
@@ -0,0 +1,36 @@
+#include "eeinterna.h"
+
+//Sin llamadas internas: el indice de la EEPROM interna se lee desde la
+//marquesina a varios niveles de la pila de hardware
+#define LEE_EE(direccion) do { while (EECON1bits.WR) NOP(); EEADR = (direccion); EECON1bits.RD = 1; } while (0)
+
+uint8_t leeEEInterna(uint8_t direccion)
+{
+    LEE_EE(direccion);
+    return EEDATA;
+}
+
+void escribeEEInterna(uint8_t direccion, uint8_t dato)
+{
+    uint8_t gie;
+    
+    LEE_EE(direccion);
+    if (EEDATA == dato)
+        return;
+    EEADR = direccion;
+    EEDATA = dato;
+    EECON1bits.WREN = 1;
+    //Secuencia obligatoria; una interrupcion en medio la invalida
+    gie = INTCONbits.GIE;
+    INTCONbits.GIE = 0;
+    EECON2 = 0x55;
+    EECON2 = 0xAA;
+    EECON1bits.WR = 1;
+    INTCONbits.GIE = gie;
+    EECON1bits.WREN = 0;
+}
+
+uint8_t escribiendoEEInterna(void)
+{
+    return EECON1bits.WR;
+}
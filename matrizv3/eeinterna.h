@@ -0,0 +1,57 @@
+/*
+ * File:   eeinterna.h
+ * Author:
+ * Comments: EEPROM de datos interna del PIC16F628A (128 bytes)
+ * Revision history:
+ */
+
+// This is a guard condition so that contents of this file are not included
+// more than once.
+#ifndef EEINTERNA_H
+#define	EEINTERNA_H
+
+#include <xc.h> // include processor files - each processor file is guarded.
+#include <stdint.h>
+
+//Bytes de la EEPROM de datos del PIC16F628A
+#define EEINTERNA_BYTES 128
+
+/**
+ * @brief Lee un byte de la EEPROM de datos interna.
+ *
+ * @param direccion Dirección del byte (0 a `EEINTERNA_BYTES` - 1).
+ *
+ * @details La lectura tarda un ciclo de instrucción, por lo que leer un byte interno cuesta lo mismo que leer una variable en RAM, mientras que una palabra de la 93LC66B cuesta decenas de microsegundos. Si hay una escritura en curso, primero espera a que termine.
+ *
+ * @return El byte leído.
+ *
+ * @code
+ * uint8_t firma = leeEEInterna(0);
+ * @endcode
+ */
+uint8_t leeEEInterna(uint8_t direccion);
+/**
+ * @brief Escribe un byte en la EEPROM de datos interna si su valor cambió.
+ *
+ * @param direccion Dirección del byte (0 a `EEINTERNA_BYTES` - 1).
+ * @param dato Valor que se graba.
+ *
+ * @details Si el byte ya tiene el valor no hace nada, lo que ahorra tiempo y ciclos de vida de la memoria. En otro caso espera a que termine la escritura anterior, arranca la nueva con la secuencia 0x55/0xAA en `EECON2` (con las interrupciones deshabilitadas durante la secuencia) y regresa sin esperarla: cada byte tarda unos 4 ms, que corren mientras el programa continúa.
+ *
+ * @code
+ * escribeEEInterna(0, 0xC6);
+ * @endcode
+ *
+ * @remark Cada byte soporta del orden de un millón de escrituras; quien llama debe evitar reescribir los mismos datos con frecuencia.
+ */
+void escribeEEInterna(uint8_t direccion, uint8_t dato);
+/**
+ * @brief Indica si hay una escritura de la EEPROM interna en curso.
+ *
+ * @details Mientras dura (unos 4 ms) `leeEEInterna()` y `escribeEEInterna()` esperan; quien no puede bloquearse debe consultar esta función antes de llamarlas.
+ *
+ * @return 1 si `EECON1bits.WR` está activo, 0 si la EEPROM interna está libre.
+ */
+uint8_t escribiendoEEInterna(void);
+
+#endif	/* XC_HEADER_TEMPLATE_H */
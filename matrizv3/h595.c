@@ -8,42 +8,59 @@
 
 #include "h595.h"
 
+#if H595_MSB_PRIMERO
+#define shift595 shiftMSB
+#else
+#define shift595 shiftLSB
+#endif
+
 
 void H595 (int cat , int an)
 {
-    int y;
-    shift(an,0);
-    shift(cat,0);
+    shift595(an);
+    shift595(cat);
     latch();
 }
 
 
+void H595Paneles(const uint8_t *cat, uint8_t an)
+{
+    //Lo ultimo que se desplaza queda en los registros del panel 0
+    H595_PANELES(cat, an);
+}
+
+
+void shiftMSB(uint8_t val)
+{
+    H595_BYTE_MSB(val);
+}
+
+
+void shiftLSB(uint8_t val)
+{
+    H595_BYTE_LSB(val);
+}
+
+
 void shift(int val, int dir){
-    int y;
-    if (dir == 1){  // Desplazamiento hacia la derecha (MSB primero)
-        for (y = 7; y >= 0; y--){
-            DATA = (val >> y) & 0x01;  // Extrae el bit correspondiente desde el MSB
-            clock();
-        }
-    }
-    else {  // Desplazamiento hacia la izquierda (LSB primero)
-        for (y = 0; y < 8; y++){
-            DATA = (val >> (7 - y)) & 0x01;  // Extrae el bit correspondiente desde el LSB
-            clock();
-        }
-    }
+    if (dir == 1)   // Desplazamiento hacia la derecha (MSB primero)
+        shiftMSB(val);
+    else            // Desplazamiento hacia la izquierda (LSB primero)
+        shiftLSB(val);
 }
 
 
 void clock(void){
     CLK  = 1;
-    __delay_us(5);
+#if H595_RETARDO_RELOJ_US > 0
+    __delay_us(H595_RETARDO_RELOJ_US);
+#endif
     CLK = 0;
-    __delay_us(5);
+#if H595_RETARDO_RELOJ_US > 0
+    __delay_us(H595_RETARDO_RELOJ_US);
+#endif
 }
 
 void latch(void){
-    LATCH = 1;
-    __delay_us(10);
-    LATCH = 0;
+    H595_PULSO_LATCH();
 }
@@ -11,6 +11,7 @@
 #define	H595_H
 
 #include <xc.h> // include processor files - each processor file is guarded.  
+#include <stdint.h>
 
 
 
@@ -19,47 +20,142 @@
 // Comment a function and leverage automatic documentation with slash star star
 
 
+#ifndef _XTAL_FREQ
 #define _XTAL_FREQ 4000000
+#endif
 
 #define CLK PORTBbits.RB7
 #define LATCH PORTBbits.RB6
 #define DATA PORTBbits.RB5
 #define LED PORTBbits.RB3
 
+//Paneles de 8x8 en cascada. Cada panel usa dos 74HC595 (catodos y anodos) y
+//todos comparten DATA, CLK y LATCH; el panel 0 es el mas cercano al
+//microcontrolador y queda a la izquierda del letrero.
+#ifndef PANELES
+#define PANELES 1
+#endif
+
+//Orden de los bits en la cadena: 1 envia primero el MSB (como esta cableada
+//la matriz), 0 envia primero el LSB
+#ifndef H595_MSB_PRIMERO
+#define H595_MSB_PRIMERO 1
+#endif
+//Retardos del bus en us despues de cada flanco de CLK y del pulso de LATCH. El
+//74HC595 solo necesita decenas de ns, asi que 0 (sin retardo) basta en la
+//mayoria de las tarjetas; se aumentan si el cableado es largo o con ruido.
+#ifndef H595_RETARDO_RELOJ_US
+#define H595_RETARDO_RELOJ_US 0
+#endif
+#ifndef H595_RETARDO_LATCH_US
+#define H595_RETARDO_LATCH_US 0
+#endif
+
+//Envio sin llamadas a funciones: la interrupcion de la pantalla envia la fila
+//con H595_PANELES() para no gastar niveles de la pila de hardware (8 en el
+//PIC16F628A, compartidos con el ciclo principal)
+#if H595_RETARDO_RELOJ_US > 0
+#define H595_PULSO_CLK() do { CLK = 1; __delay_us(H595_RETARDO_RELOJ_US); \
+                              CLK = 0; __delay_us(H595_RETARDO_RELOJ_US); } while (0)
+#else
+#define H595_PULSO_CLK() do { CLK = 1; CLK = 0; } while (0)
+#endif
+#if H595_RETARDO_LATCH_US > 0
+#define H595_PULSO_LATCH() do { LATCH = 1; __delay_us(H595_RETARDO_LATCH_US); LATCH = 0; } while (0)
+#else
+#define H595_PULSO_LATCH() do { LATCH = 1; LATCH = 0; } while (0)
+#endif
+//Un bit de posicion fija: se compila como una prueba de bit, sin corrimientos
+#define H595_BIT(val, b) do { DATA = 0; if ((val) & (1 << (b))) DATA = 1; H595_PULSO_CLK(); } while (0)
+#define H595_BYTE_MSB(val) do { H595_BIT(val, 7); H595_BIT(val, 6); H595_BIT(val, 5); H595_BIT(val, 4); \
+                                H595_BIT(val, 3); H595_BIT(val, 2); H595_BIT(val, 1); H595_BIT(val, 0); } while (0)
+#define H595_BYTE_LSB(val) do { H595_BIT(val, 0); H595_BIT(val, 1); H595_BIT(val, 2); H595_BIT(val, 3); \
+                                H595_BIT(val, 4); H595_BIT(val, 5); H595_BIT(val, 6); H595_BIT(val, 7); } while (0)
+#if H595_MSB_PRIMERO
+#define H595_BYTE H595_BYTE_MSB
+#else
+#define H595_BYTE H595_BYTE_LSB
+#endif
+//Cuerpo de H595Paneles(); p_ es un contador propio de la macro
+#define H595_PANELES(cat, an) do { uint8_t p_ = PANELES; \
+                                   while (p_ > 0) { p_--; H595_BYTE(an); H595_BYTE((cat)[p_]); } \
+                                   H595_PULSO_LATCH(); } while (0)
+
 /**
  * @brief Controla dos registros de desplazamiento 74HC595 conectados en cascada.
  *
- * @param cat Valor a enviar al primer registro 74HC595 (generalmente para los ctodos de un display).
- * @param an Valor a enviar al segundo registro 74HC595 (generalmente para los nodos de un display).
+ * @param cat Valor a enviar al primer registro 74HC595 (generalmente para los cátodos de un display).
+ * @param an Valor a enviar al segundo registro 74HC595 (generalmente para los ánodos de un display).
  *
  * @pre Los pines DATA, CLOCK y LATCH deben estar configurados como salidas. Las funciones shift() y latch() deben estar definidas.
  *
- * @details Esta funcin enva dos valores a travs de la funcin shift() a dos registros 74HC595 conectados en cascada. Primero se enva el valor 'an' y luego el valor 'cat'. Finalmente, se llama a la funcin latch() para transferir los datos a las salidas de los registros.
+ * @details Esta función envía dos valores a dos registros 74HC595 conectados en cascada, con `shiftMSB()` o `shiftLSB()` según `H595_MSB_PRIMERO`. Primero se envía el valor 'an' y luego el valor 'cat'. Finalmente, se llama a la función latch() para transferir los datos a las salidas de los registros.
  *
  * @code
- * // Ejemplo de uso: enviar 0xFF al registro de ctodos y 0x01 al registro de nodos.
+ * // Ejemplo de uso: enviar 0xFF al registro de cátodos y 0x01 al registro de ánodos.
  * H595(0xFF, 0x01);
  * @endcode
  *
- * @remark El orden en que se envan los datos (primero 'an' y luego 'cat') depende de la conexin fsica de los registros en cascada. Asegrate de que este orden corresponda con tu hardware.
+ * @remark El orden en que se envían los datos (primero 'an' y luego 'cat') depende de la conexión física de los registros en cascada. Asegúrate de que este orden corresponda con tu hardware.
  */
 void H595 (int cat , int an);
+/**
+ * @brief Envía una fila a todos los paneles de la cadena con un solo latch.
+ *
+ * @param cat Arreglo de `PANELES` bytes con el valor de los cátodos de cada panel (`cat[0]` para el panel 0).
+ * @param an Valor de los ánodos, el mismo para todos los paneles.
+ *
+ * @pre Los pines DATA, CLK y LATCH deben estar configurados como salidas.
+ *
+ * @details Recorre los paneles del más lejano al más cercano enviando, como `H595()` y en el orden de bits de `H595_MSB_PRIMERO`, primero los ánodos y luego los cátodos de cada uno, de modo que al terminar cada par de registros queda frente a su panel. Al final se genera un solo pulso de `latch()`, por lo que todos los paneles cambian de fila al mismo tiempo.
+ *
+ * @code
+ * uint8_t catodos[PANELES];
+ * // ... llenar catodos[] ...
+ * H595Paneles(catodos, 0x01);
+ * @endcode
+ *
+ * @remark Con `PANELES` igual a 1 equivale a `H595(cat[0], an)`. `refrescaPantalla()` usa directamente la macro `H595_PANELES()`, que es el cuerpo de esta función, para no ocupar otro nivel de la pila de hardware dentro de la interrupción.
+ */
+void H595Paneles(const uint8_t *cat, uint8_t an);
 
 /**
- * @brief Realiza el desplazamiento de un valor bit a bit a travs del pin DATA.
+ * @brief Envía un byte por el pin DATA empezando por el bit más significativo.
+ *
+ * @param val Byte a desplazar.
+ *
+ * @pre Los pines DATA y CLK deben estar configurados como salidas.
+ *
+ * @details El ciclo está desenrollado: cada bit se toma de una posición fija de `val` (una prueba de bit, sin corrimientos variables) y se genera su pulso de reloj directamente sobre CLK. Si `H595_RETARDO_RELOJ_US` es 0 cada bit cuesta unas cuantas instrucciones en lugar de los 10 us de `clock()` original.
+ *
+ * @code
+ * shiftMSB(0b10101010);
+ * @endcode
+ */
+void shiftMSB(uint8_t val);
+/**
+ * @brief Envía un byte por el pin DATA empezando por el bit menos significativo.
+ *
+ * @param val Byte a desplazar.
+ *
+ * @pre Los pines DATA y CLK deben estar configurados como salidas.
+ *
+ * @details Igual que `shiftMSB()`, con el orden de los bits invertido.
+ */
+void shiftLSB(uint8_t val);
+/**
+ * @brief Realiza el desplazamiento de un valor bit a bit a través del pin DATA.
  *
  * @param val Valor entero de 8 bits a desplazar.
- * @param dir Direccin del desplazamiento:
+ * @param dir Dirección del desplazamiento:
  *            - 1: Desplazamiento a la derecha (MSB primero).
  *            - 0: Desplazamiento a la izquierda (LSB primero).
  *
- * @pre El pin DATA debe estar configurado como salida. La funcin clock() debe estar definida y generar un pulso de reloj.
+ * @pre El pin DATA debe estar configurado como salida.
  *
  * @return Ninguno.
  *
- * @details Esta funcin implementa un desplazamiento bit a bit de un valor entero de 8 bits a travs del pin DATA. 
- *          Dependiendo del parmetro 'dir', el desplazamiento se realiza hacia la derecha (MSB primero) o hacia la izquierda (LSB primero).
- *          Despus de cada bit enviado, se llama a la funcin clock() para generar un pulso de reloj.
+ * @details Se conserva por compatibilidad; según `dir` llama a `shiftMSB()` o a `shiftLSB()`. Cuando el orden se conoce al compilar conviene llamar directamente a la función correspondiente y evitar la decisión en cada byte.
  *
  * @code
  * // Ejemplo de uso: desplazar el valor 0b10101010 hacia la derecha
@@ -68,8 +164,6 @@ void H595 (int cat , int an);
  * // Ejemplo de uso: desplazar el valor 0b01010101 hacia la izquierda
  * shift(0b01010101, 0);
  * @endcode
- *
- * @remark Es crucial que la funcin clock() genere un pulso de reloj con la duracin correcta para el dispositivo receptor.
  */
 void shift(int val,int dir);
 /**
@@ -77,15 +171,15 @@ void shift(int val,int dir);
  *
  * @pre El pin CLK debe estar configurado como salida.
  *
- * @details Esta funcin genera un pulso de reloj de onda cuadrada en el pin CLK. El pulso consiste en un flanco ascendente (CLK = 1) seguido de un retardo de 5 microsegundos, y luego un flanco descendente (CLK = 0) seguido de otro retardo de 5 microsegundos. Esto resulta en un ciclo completo de 10 microsegundos.
+ * @details Esta función genera un pulso de reloj de onda cuadrada en el pin CLK. El pulso consiste en un flanco ascendente (CLK = 1) seguido de un retardo de `H595_RETARDO_RELOJ_US` microsegundos, y luego un flanco descendente (CLK = 0) seguido de otro retardo igual. Con el retardo en 0 el pulso dura un par de ciclos de instrucción.
  *
  * @code
- * clock(); // Genera un pulso de reloj de 10 microsegundos.
+ * clock(); // Genera un pulso de reloj en CLK.
  * @endcode
  *
- * @note La precisin del retardo depende de la frecuencia del oscilador del microcontrolador. Asegrate de que la macro __delay_us() est configurada correctamente para tu configuracin de hardware.
+ * @note La precisión del retardo depende de la frecuencia del oscilador del microcontrolador. Asegúrate de que la macro __delay_us() esté configurada correctamente para tu configuración de hardware.
  *
- * @remark Es importante que la duracin del pulso de reloj sea compatible con las especificaciones del dispositivo al que se est enviando la seal de reloj (por ejemplo, el 74HC595).
+ * @remark Es importante que la duración del pulso de reloj sea compatible con las especificaciones del dispositivo al que se está enviando la señal de reloj (por ejemplo, el 74HC595).
  */
 void clock(void);
 /**
@@ -93,15 +187,15 @@ void clock(void);
  *
  * @pre El pin LATCH debe estar configurado como salida.
  *
- * @details Esta funcin genera un pulso positivo (de bajo a alto y luego a bajo) en el pin LATCH. Este pulso transfiere los datos que se han desplazado previamente a travs de la funcin `shift()` a las salidas del registro 74HC595. El pulso en alto tiene una duracin de aproximadamente 10 microsegundos.
+ * @details Esta función genera un pulso positivo (de bajo a alto y luego a bajo) en el pin LATCH. Este pulso transfiere los datos que se han desplazado previamente a través de la función `shift()` a las salidas del registro 74HC595. El pulso en alto dura `H595_RETARDO_LATCH_US` microsegundos más un ciclo de instrucción.
  *
  * @code
  * latch(); // Transfiere los datos a las salidas del registro 74HC595.
  * @endcode
  *
- * @note La precisin del retardo depende de la frecuencia del oscilador del microcontrolador. Asegrese de que la macro `__delay_us()` est configurada correctamente para su configuracin de hardware.
+ * @note La precisión del retardo depende de la frecuencia del oscilador del microcontrolador. Asegúrese de que la macro `__delay_us()` esté configurada correctamente para su configuración de hardware.
  *
- * @remark La duracin del pulso en LATCH debe cumplir con las especificaciones del 74HC595 para asegurar una transferencia correcta de los datos. Consultar la hoja de datos del 74HC595 para obtener informacin precisa sobre los tiempos de latch.
+ * @remark La duración del pulso en LATCH debe cumplir con las especificaciones del 74HC595 para asegurar una transferencia correcta de los datos. Consultar la hoja de datos del 74HC595 para obtener información precisa sobre los tiempos de latch.
  */
 void latch(void);
 
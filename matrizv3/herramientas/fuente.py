@@ -0,0 +1,241 @@
+#!/usr/bin/env python3
+"""Compilador de fuentes para la EEPROM 93LC66B de matrizv3.
+
+Convierte una descripcion de texto de la fuente (ver fuente.txt) en la imagen
+tabla_leds.bin que se graba en la EEPROM, y permite revisar una imagen ya
+generada.
+
+Formato de la imagen (direcciones en bytes, valores de 16 bits LSB primero,
+igual que las palabras de la 93LC66B en modo x16; en x8 cada byte de la
+imagen se graba en su propia celda y la imagen es la misma):
+
+    0   firma 'F' 'M' (0x4D46)
+    2   numero de glifos N
+    3   version del formato
+    4   longitud total de la imagen en bytes
+    6   suma de verificacion: suma de 16 bits de todas las palabras a partir
+        del byte 8 (indice y patrones)
+    8   indice, N entradas de 4 bytes ordenadas por caracter:
+            caracter
+            mascara de repeticion: el bit j indica que la columna j es igual
+                a la columna j-1 y no se guarda (antes de la primera columna
+                se toma una columna en blanco)
+            16 bits: direccion de los patrones (bits 0-11) y ancho en
+                columnas (bits 12-15)
+    ... patrones: solo las columnas que no se repiten, una por byte (bit 0 =
+        renglon superior), sin alinear; dos glifos pueden compartir bytes
+        si los patrones de uno aparecen dentro de los del otro
+
+Uso:
+    fuente.py compila [--memoria 46|56|66|76|86] fuente.txt tabla_leds.bin
+    fuente.py muestra tabla_leds.bin
+"""
+
+import argparse
+import struct
+import sys
+
+FIRMA = 0x4D46
+VERSION = 2
+CABECERA = 8
+ENTRADA = 4
+RENGLONES = 8
+ANCHO_MAX = 8
+CAPACIDAD = 512     # bytes de la 93LC66B
+# Bytes de cada modelo de la familia 93xx (M93_MODELO en m93lc66b.h)
+MEMORIAS = {46: 128, 56: 256, 66: 512, 76: 1024, 86: 2048}
+
+
+class ErrorFuente(Exception):
+    pass
+
+
+def lee_caracter(texto, linea):
+    if len(texto) == 1:
+        return ord(texto)
+    try:
+        valor = int(texto, 0)
+    except ValueError:
+        raise ErrorFuente("linea %d: caracter invalido '%s'" % (linea, texto))
+    if not 0 < valor < 256:
+        raise ErrorFuente("linea %d: caracter fuera de rango '%s'" % (linea, texto))
+    return valor
+
+
+def lee_fuente(ruta):
+    """Regresa un diccionario caracter -> lista de columnas."""
+    glifos = {}
+    with open(ruta, encoding="latin-1") as archivo:
+        lineas = archivo.read().splitlines()
+    i = 0
+    while i < len(lineas):
+        linea = lineas[i].rstrip()
+        i += 1
+        if not linea or linea.startswith("#"):
+            continue
+        partes = linea.split(None, 1)
+        if partes[0] != "glifo" or len(partes) != 2:
+            raise ErrorFuente("linea %d: se esperaba 'glifo <caracter>'" % i)
+        caracter = lee_caracter(partes[1].strip(), i)
+        if caracter in glifos:
+            raise ErrorFuente("linea %d: glifo repetido %r" % (i, chr(caracter)))
+        renglones = [r.rstrip() for r in lineas[i:i + RENGLONES]]
+        if len(renglones) < RENGLONES:
+            raise ErrorFuente("linea %d: el glifo necesita %d renglones" % (i, RENGLONES))
+        ancho = len(renglones[0])
+        for n, renglon in enumerate(renglones):
+            if len(renglon) != ancho or set(renglon) - set("#."):
+                raise ErrorFuente("linea %d: renglon invalido '%s'" % (i + n + 1, renglon))
+        if not 1 <= ancho <= ANCHO_MAX:
+            raise ErrorFuente("linea %d: ancho %d fuera de 1..%d" % (i, ancho, ANCHO_MAX))
+        columnas = []
+        for x in range(ancho):
+            columna = 0
+            for y in range(RENGLONES):
+                if renglones[y][x] == "#":
+                    columna |= 1 << y
+            columnas.append(columna)
+        glifos[caracter] = columnas
+        i += RENGLONES
+    if not glifos:
+        raise ErrorFuente("la fuente no tiene glifos")
+    if len(glifos) > 255:
+        raise ErrorFuente("la fuente tiene mas de 255 glifos")
+    return glifos
+
+
+def suma_verificacion(datos):
+    suma = 0
+    for (palabra,) in struct.iter_unpack("<H", datos):
+        suma = (suma + palabra) & 0xFFFF
+    return suma
+
+
+def comprime(columnas):
+    """Regresa (mascara, literales): las columnas iguales a la anterior se omiten."""
+    mascara = 0
+    literales = bytearray()
+    anterior = 0
+    for j, columna in enumerate(columnas):
+        if columna == anterior:
+            mascara |= 1 << j
+        else:
+            literales.append(columna)
+        anterior = columna
+    return mascara, bytes(literales)
+
+
+def expande(mascara, ancho, literales):
+    columnas = []
+    k = 0
+    anterior = 0
+    for j in range(ancho):
+        if not mascara >> j & 1:
+            anterior = literales[k]
+            k += 1
+        columnas.append(anterior)
+    return columnas
+
+
+def compila(glifos, capacidad=CAPACIDAD):
+    caracteres = sorted(glifos)
+    indice = bytearray()
+    patrones = bytearray()
+    direccion = CABECERA + ENTRADA * len(caracteres)
+    for caracter in caracteres:
+        columnas = glifos[caracter]
+        mascara, literales = comprime(columnas)
+        # Se reutilizan los bytes de otro glifo si ya estan en los patrones
+        posicion = patrones.find(literales) if literales else 0
+        if posicion < 0:
+            posicion = len(patrones)
+            patrones += literales
+        inicio = direccion + posicion
+        if inicio > 0x0FFF:
+            raise ErrorFuente("patrones de %r fuera del alcance del indice" % chr(caracter))
+        indice += struct.pack("<BBH", caracter, mascara, inicio | len(columnas) << 12)
+    if len(patrones) % 2:
+        patrones.append(0)
+    cuerpo = bytes(indice + patrones)
+    longitud = CABECERA + len(cuerpo)
+    if longitud > capacidad:
+        raise ErrorFuente("la imagen ocupa %d bytes, la EEPROM tiene %d" % (longitud, capacidad))
+    cabecera = struct.pack("<HBBHH", FIRMA, len(caracteres), VERSION, longitud,
+                           suma_verificacion(cuerpo))
+    return cabecera + cuerpo
+
+
+def revisa(imagen):
+    """Valida una imagen y regresa su lista de (caracter, columnas)."""
+    if len(imagen) < CABECERA:
+        raise ErrorFuente("imagen demasiado corta")
+    firma, cantidad, version, longitud, suma = struct.unpack_from("<HBBHH", imagen)
+    if firma != FIRMA:
+        raise ErrorFuente("firma 0x%04X, se esperaba 0x%04X" % (firma, FIRMA))
+    if version != VERSION:
+        raise ErrorFuente("version de formato %d no soportada" % version)
+    if longitud > len(imagen) or longitud < CABECERA + ENTRADA * cantidad:
+        raise ErrorFuente("longitud %d invalida" % longitud)
+    if suma_verificacion(imagen[CABECERA:longitud]) != suma:
+        raise ErrorFuente("suma de verificacion incorrecta")
+    glifos = []
+    anterior = -1
+    for k in range(cantidad):
+        caracter, mascara, direccion = struct.unpack_from("<BBH", imagen, CABECERA + ENTRADA * k)
+        ancho = direccion >> 12
+        direccion &= 0x0FFF
+        if caracter <= anterior:
+            raise ErrorFuente("indice desordenado en la entrada %d" % k)
+        if not 1 <= ancho <= ANCHO_MAX:
+            raise ErrorFuente("ancho %d invalido para %r" % (ancho, chr(caracter)))
+        literales = ancho - bin(mascara & ((1 << ancho) - 1)).count("1")
+        if direccion < CABECERA + ENTRADA * cantidad or direccion + literales > longitud:
+            raise ErrorFuente("direccion 0x%03X invalida para %r" % (direccion, chr(caracter)))
+        glifos.append((caracter, expande(mascara, ancho, imagen[direccion:direccion + literales])))
+        anterior = caracter
+    return glifos
+
+
+def nombre(caracter):
+    if 0x20 < caracter < 0x7F and chr(caracter) not in "#'":
+        return chr(caracter)
+    return "0x%02X" % caracter
+
+
+def muestra(imagen, salida):
+    glifos = revisa(imagen)
+    firma, cantidad, version, longitud, suma = struct.unpack_from("<HBBHH", imagen)
+    salida.write("# %d glifos, %d bytes, suma 0x%04X\n" % (cantidad, longitud, suma))
+    for caracter, columnas in glifos:
+        salida.write("\nglifo %s\n" % nombre(caracter))
+        for y in range(RENGLONES):
+            salida.write("".join("#" if c >> y & 1 else "." for c in columnas) + "\n")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    ordenes = parser.add_subparsers(dest="orden", required=True)
+    orden = ordenes.add_parser("compila", help="genera la imagen de la EEPROM")
+    orden.add_argument("--memoria", type=int, choices=sorted(MEMORIAS), default=66,
+                       help="modelo 93xx de la EEPROM (por omision 66)")
+    orden.add_argument("fuente")
+    orden.add_argument("imagen")
+    orden = ordenes.add_parser("muestra", help="valida una imagen y la imprime como texto")
+    orden.add_argument("imagen")
+    args = parser.parse_args()
+
+    try:
+        if args.orden == "compila":
+            imagen = compila(lee_fuente(args.fuente), MEMORIAS[args.memoria])
+            with open(args.imagen, "wb") as archivo:
+                archivo.write(imagen)
+            print("%s: %d glifos, %d bytes" % (args.imagen, imagen[2], len(imagen)))
+        else:
+            with open(args.imagen, "rb") as archivo:
+                muestra(archivo.read(), sys.stdout)
+    except (ErrorFuente, OSError) as error:
+        sys.exit("fuente.py: %s" % error)
+
+
+if __name__ == "__main__":
+    main()
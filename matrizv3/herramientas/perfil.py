@@ -0,0 +1,97 @@
+#!/usr/bin/env python3
+"""Muestra la tabla del perfilador de matrizv3 (comando 'F') como reporte.
+
+El firmware debe compilarse con -DPERFIL_ACTIVO=1 (ver perfil.h); si no, el
+comando 'F' responde NAK. La respuesta tiene el numero de regiones, las
+cuentas del Timer1 por milisegundo y, por region, cuenta, minimo y maximo
+(16 bits) y suma (32 bits), todo LSB primero.
+
+Tambien decodifica una trama de respuesta guardada en un archivo (por ejemplo
+con un analizador logico), con --archivo.
+
+Necesita pyserial (pip install pyserial) para leer del puerto.
+
+Uso:
+    perfil.py /dev/ttyUSB0 [--limpia]
+    perfil.py --archivo respuesta.bin
+"""
+
+import argparse
+import struct
+import sys
+
+from programa import ErrorEnlace, SYNC, comando, crc8
+
+# Mismo orden que las regiones de perfil.h
+REGIONES = ["indice", "glifo", "fila", "uart"]
+
+
+def decodifica(datos):
+    """Regresa (cuentas por ms, [(nombre, cuenta, minimo, maximo, suma), ...])."""
+    if len(datos) < 3:
+        raise ErrorEnlace("respuesta 'F' demasiado corta")
+    regiones, cuentas_ms = struct.unpack_from("<BH", datos, 0)
+    if len(datos) != 3 + 10 * regiones:
+        raise ErrorEnlace("la respuesta 'F' dice %d regiones pero trae %d bytes" % (regiones, len(datos)))
+    tabla = []
+    for r in range(regiones):
+        cuenta, minimo, maximo, suma = struct.unpack_from("<HHHI", datos, 3 + 10 * r)
+        nombre = REGIONES[r] if r < len(REGIONES) else "region %d" % r
+        tabla.append((nombre, cuenta, minimo, maximo, suma))
+    return cuentas_ms, tabla
+
+
+def reporte(cuentas_ms, tabla):
+    us = 1000.0 / cuentas_ms
+    lineas = ["%-8s %8s %10s %10s %10s %12s" % ("region", "cuenta", "min us", "prom us", "max us", "total ms")]
+    for nombre, cuenta, minimo, maximo, suma in tabla:
+        if cuenta == 0:
+            lineas.append("%-8s %8d %10s %10s %10s %12s" % (nombre, 0, "-", "-", "-", "-"))
+            continue
+        lineas.append("%-8s %8d %10.0f %10.1f %10.0f %12.1f"
+                      % (nombre, cuenta, minimo * us, suma * us / cuenta, maximo * us, suma * us / 1000))
+    return "\n".join(lineas)
+
+
+def lee_archivo(nombre):
+    """Datos de la primera trama 'F' valida del archivo."""
+    with open(nombre, "rb") as archivo:
+        crudo = archivo.read()
+    k = 0
+    while k + 4 <= len(crudo):
+        if crudo[k] == SYNC and crudo[k + 2] == ord("F"):
+            n = crudo[k + 1]
+            trama = crudo[k + 1:k + 4 + n]
+            if len(trama) == n + 3 and crc8(trama[:-1]) == trama[-1]:
+                return trama[2:-1]
+        k += 1
+    raise ErrorEnlace("%s no contiene una respuesta 'F' valida" % nombre)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("puerto", nargs="?", help="puerto serial, por ejemplo /dev/ttyUSB0 o COM3")
+    parser.add_argument("--baudios", type=int, default=9600)
+    parser.add_argument("--limpia", action="store_true", help="pone la tabla en cero despues de leerla")
+    parser.add_argument("--archivo", help="decodifica una respuesta guardada en lugar de usar el puerto")
+    args = parser.parse_args()
+
+    try:
+        if args.archivo:
+            datos = lee_archivo(args.archivo)
+        elif args.puerto:
+            try:
+                import serial
+            except ImportError:
+                sys.exit("perfil.py: se necesita pyserial (pip install pyserial)")
+            with serial.Serial(args.puerto, args.baudios, timeout=1) as puerto:
+                datos = comando(puerto, "F", bytes([1]) if args.limpia else b"")
+        else:
+            parser.error("falta el puerto o --archivo")
+        print(reporte(*decodifica(datos)))
+    except (ErrorEnlace, OSError) as error:
+        sys.exit("perfil.py: %s" % error)
+
+
+if __name__ == "__main__":
+    main()
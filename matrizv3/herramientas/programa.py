@@ -0,0 +1,171 @@
+#!/usr/bin/env python3
+"""Graba una imagen tabla_leds.bin en la EEPROM de matrizv3 por el puerto serial.
+
+Usa el protocolo de comandos del firmware (ver comandos.h):
+
+    'P' dir(2) palabras   graba y verifica hasta 7 palabras por trama
+    'R'                   recarga la fuente; responde el numero de glifos
+    'D' dir(2) n          lee n palabras para comparar la imagen grabada
+
+El firmware salta las palabras que ya tienen el valor, asi que regrabar una
+fuente con pocos cambios tarda poco mas que enviarla. Al final se compara la
+imagen completa con volcados 'D'.
+
+Con un firmware compilado con RS232_AUTOBAUDIOS=1, --autobaudios envia un
+0x7E suelto para que el firmware mida la velocidad al arrancar (reiniciar la
+tarjeta justo antes); asi se puede grabar a 19200 bps o mas sin recompilar.
+
+Necesita pyserial (pip install pyserial).
+
+Uso:
+    programa.py /dev/ttyUSB0 tabla_leds.bin
+    programa.py --baudios 19200 --autobaudios /dev/ttyUSB0 tabla_leds.bin
+"""
+
+import argparse
+import struct
+import sys
+import time
+
+from fuente import ErrorFuente, revisa
+
+SYNC = 0x7E
+NAK = 0x15
+MAX_DATOS = 16
+PROGRAMA_PALABRAS = (MAX_DATOS - 2) // 2
+VOLCADO_PALABRAS = 64
+REINTENTOS = 3
+INTENTOS_AUTOBAUDIOS = 5
+
+
+class ErrorEnlace(Exception):
+    pass
+
+
+def crc8(datos):
+    crc = 0
+    for dato in datos:
+        crc ^= dato
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+    return crc
+
+
+def trama(tipo, datos=b""):
+    cuerpo = bytes([len(datos), ord(tipo)]) + bytes(datos)
+    return bytes([SYNC]) + cuerpo + bytes([crc8(cuerpo)])
+
+
+def lee_respuesta(puerto):
+    """Regresa (tipo, datos) de la siguiente trama valida."""
+    while True:
+        dato = puerto.read(1)
+        if not dato:
+            raise ErrorEnlace("sin respuesta")
+        if dato[0] != SYNC:
+            continue
+        cabecera = puerto.read(2)
+        if len(cabecera) < 2:
+            raise ErrorEnlace("respuesta incompleta")
+        datos = puerto.read(cabecera[0] + 1)
+        if len(datos) < cabecera[0] + 1:
+            raise ErrorEnlace("respuesta incompleta")
+        if crc8(cabecera + datos[:-1]) != datos[-1]:
+            raise ErrorEnlace("CRC incorrecto en la respuesta")
+        return chr(cabecera[1]), datos[:-1]
+
+
+def comando(puerto, tipo, datos=b""):
+    """Envia un comando y regresa los datos de su respuesta; reintenta si se pierde."""
+    for intento in range(REINTENTOS):
+        puerto.reset_input_buffer()
+        puerto.write(trama(tipo, datos))
+        try:
+            respuesta, contenido = lee_respuesta(puerto)
+        except ErrorEnlace as error:
+            if intento == REINTENTOS - 1:
+                raise ErrorEnlace("comando '%s': %s" % (tipo, error))
+            continue
+        if respuesta == chr(NAK):
+            raise ErrorEnlace("el firmware rechazo el comando '%s'" % tipo)
+        if respuesta != tipo:
+            raise ErrorEnlace("respuesta '%s' al comando '%s'" % (respuesta, tipo))
+        return contenido
+    return b""
+
+
+def autobaudios(puerto):
+    """Envia 0x7E sueltos hasta que el firmware, que mide uno al arrancar, responde 'E'."""
+    for _ in range(INTENTOS_AUTOBAUDIOS):
+        puerto.reset_input_buffer()
+        puerto.write(bytes([SYNC]))
+        puerto.flush()
+        # Silencio para que el siguiente byte no se confunda con el que se mide
+        time.sleep(0.05)
+        try:
+            comando(puerto, "E")
+            return
+        except ErrorEnlace:
+            continue
+    raise ErrorEnlace("el firmware no midio la velocidad (se reinicio la tarjeta? tiene RS232_AUTOBAUDIOS?)")
+
+
+def graba(puerto, imagen, salida):
+    escritas = 0
+    for direccion in range(0, len(imagen), 2 * PROGRAMA_PALABRAS):
+        bloque = imagen[direccion:direccion + 2 * PROGRAMA_PALABRAS]
+        respuesta = comando(puerto, "P", struct.pack("<H", direccion) + bloque)
+        escritas += respuesta[0]
+        salida.write("\r%4d/%d bytes" % (direccion + len(bloque), len(imagen)))
+        salida.flush()
+    salida.write("\n")
+    return escritas
+
+
+def verifica(puerto, imagen):
+    for direccion in range(0, len(imagen), 2 * VOLCADO_PALABRAS):
+        bloque = imagen[direccion:direccion + 2 * VOLCADO_PALABRAS]
+        leido = comando(puerto, "D", struct.pack("<HB", direccion, len(bloque) // 2))
+        if leido != bloque:
+            for k, (a, b) in enumerate(zip(bloque, leido)):
+                if a != b:
+                    raise ErrorEnlace("la EEPROM difiere en el byte 0x%03X" % (direccion + k))
+            raise ErrorEnlace("volcado incompleto en 0x%03X" % direccion)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("puerto", help="puerto serial, por ejemplo /dev/ttyUSB0 o COM3")
+    parser.add_argument("imagen", help="imagen generada con fuente.py compila")
+    parser.add_argument("--baudios", type=int, default=9600)
+    parser.add_argument("--autobaudios", action="store_true",
+                        help="sincroniza la velocidad con un firmware recien reiniciado")
+    args = parser.parse_args()
+
+    try:
+        import serial
+    except ImportError:
+        sys.exit("programa.py: se necesita pyserial (pip install pyserial)")
+
+    try:
+        with open(args.imagen, "rb") as archivo:
+            imagen = archivo.read()
+        revisa(imagen)
+        longitud = struct.unpack_from("<H", imagen, 4)[0]
+        imagen = imagen[:longitud]
+        with serial.Serial(args.puerto, args.baudios, timeout=1) as puerto:
+            if args.autobaudios:
+                autobaudios(puerto)
+            escritas = graba(puerto, imagen, sys.stdout)
+            glifos = comando(puerto, "R")[0]
+            if glifos != imagen[2]:
+                raise ErrorEnlace("el firmware cargo %d glifos, la imagen tiene %d" % (glifos, imagen[2]))
+            verifica(puerto, imagen)
+        print("%s: %d bytes verificados, %d palabras escritas, %d glifos"
+              % (args.imagen, longitud, escritas, glifos))
+    except (ErrorFuente, ErrorEnlace, OSError, serial.SerialException) as error:
+        sys.exit("programa.py: %s" % error)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,371 @@
+#!/usr/bin/env python3
+"""Estima la pila de hardware y la RAM que usa el firmware de matrizv3 en el PIC16F628A.
+
+El PIC16F628A tiene una pila de 8 direcciones de regreso que se desborda sin
+aviso, y 224 bytes de RAM: 80 en el banco 0, 80 en el banco 1, 48 en el banco
+2 y 16 comunes. XC8 no usa pila de datos: las variables locales y los
+parametros van en una "pila compilada" donde las funciones que nunca estan
+activas a la vez comparten los mismos bytes.
+
+Sin XC8 a la mano, este programa compila las fuentes con el gcc de la PC
+(con el xc.h del simulador) y obtiene de ellas:
+
+  - el grafo de llamadas (gcc -fcallgraph-info). Las llamadas por apuntador
+    (la tabla de tareas) se suponen hacia toda funcion cuyo nombre se usa sin
+    llamarla. Las multiplicaciones y divisiones que no son corrimientos
+    cuentan como una llamada a una rutina de XC8.
+  - los tamanos de las variables globales y estaticas, y de los parametros y
+    locales de cada funcion (informacion de depuracion), convertidos a los
+    tipos de XC8: int de 2 bytes, long de 4 y apuntadores de 2. Las
+    variables const van en la memoria de programa y no cuentan.
+
+La pila de hardware que se usa es la llamada mas profunda desde main() mas la
+interrupcion (1) y la llamada mas profunda desde isr(). La RAM es la de las
+variables mas la pila compilada de main() y la de isr() (la suma de los
+parametros y locales en el camino de llamadas mas pesado de cada una), mas
+una reserva para los temporales del compilador y el contexto de la
+interrupcion. Son estimaciones: el mapa de memoria de XC8 (el archivo .map)
+es la referencia.
+
+Uso (desde matrizv3/):
+    herramientas/recursos.py [-D NOMBRE=VALOR ...]
+    herramientas/recursos.py -DPANTALLA_BITS=4 -DPANELES=4
+"""
+
+import argparse
+import glob
+import os
+import re
+import subprocess
+import sys
+import tempfile
+
+PILA_NIVELES = 8
+RAM_BYTES = 224
+BANCO_BYTES = 80
+# Temporales de XC8 (btemp) y copia de W, STATUS, PCLATH y FSR en la interrupcion
+RESERVA_BYTES = 8
+# Pila compilada de una rutina de multiplicacion o division de XC8 (16 bits)
+AYUDA_BYTES = 6
+AYUDA = "(rutina de XC8 para * / %)"
+
+TAMANOS_BASE = {
+    "char": 1, "signed char": 1, "unsigned char": 1, "_Bool": 1,
+    "short int": 2, "short unsigned int": 2, "int": 2, "unsigned int": 2,
+    "long int": 4, "long unsigned int": 4, "float": 4, "double": 4,
+    "long long int": 8, "long long unsigned int": 8,
+}
+APUNTADOR_BYTES = 2
+
+
+class ErrorRecursos(Exception):
+    pass
+
+
+def compila(fuentes, directorio, definiciones):
+    """Compila cada fuente sin optimizar; regresa [(fuente, objeto, ci, gimple)]."""
+    sim = os.path.join(directorio, "sim")
+    salida = []
+    with tempfile.TemporaryDirectory() as tmp:
+        for fuente in fuentes:
+            base = os.path.join(tmp, os.path.splitext(os.path.basename(fuente))[0])
+            orden = ["gcc", "-std=gnu99", "-O0", "-g", "-fcallgraph-info", "-fdump-tree-gimple",
+                     "-Wno-unknown-pragmas", "-Dmain=main_firmware", "-I" + sim] + definiciones + \
+                    ["-c", fuente, "-o", base + ".o"]
+            resultado = subprocess.run(orden, capture_output=True, text=True, cwd=tmp)
+            if resultado.returncode != 0:
+                raise ErrorRecursos("no compila %s:\n%s" % (fuente, resultado.stderr))
+            fuente_e = subprocess.run(["gcc", "-std=gnu99", "-E", "-P", "-Dmain=main_firmware", "-I" + sim] +
+                                      definiciones + [fuente], capture_output=True, text=True).stdout
+            #Sin funciones (un modulo apagado por sus parametros) gcc no escribe el volcado
+            volcado = glob.glob(base + ".c.*.gimple")
+            gimple = open(volcado[0]).read() if volcado else ""
+            with open(base + ".ci") as ci:
+                dwarf = subprocess.run(["readelf", "--debug-dump=info", base + ".o"],
+                                       capture_output=True, text=True).stdout
+                salida.append((fuente, dwarf, ci.read(), gimple, fuente_e))
+    return salida
+
+
+# --- Informacion de depuracion -------------------------------------------
+
+ENTRADA = re.compile(r"^\s*<(\d+)><([0-9a-f]+)>: Abbrev Number: \d+ \((\w+)\)")
+ATRIBUTO = re.compile(r"^\s*<[0-9a-f]+>\s+(DW_AT_\w+)\s*:\s*(.*)$")
+
+
+def lee_dwarf(texto):
+    """Regresa {desplazamiento: nodo}; cada nodo tiene tag, atributos e hijos."""
+    nodos = {}
+    pila = []
+    actual = None
+    for linea in texto.splitlines():
+        m = ENTRADA.match(linea)
+        if m:
+            nivel, desplazamiento, tag = int(m.group(1)), int(m.group(2), 16), m.group(3)
+            actual = {"tag": tag, "at": {}, "hijos": [], "desp": desplazamiento}
+            nodos[desplazamiento] = actual
+            del pila[nivel:]
+            if pila:
+                pila[-1]["hijos"].append(actual)
+            pila.append(actual)
+            continue
+        m = ATRIBUTO.match(linea)
+        if m and actual is not None:
+            actual["at"][m.group(1)] = m.group(2).strip()
+    return nodos
+
+
+def nombre(nodo):
+    valor = nodo["at"].get("DW_AT_name")
+    if valor is None:
+        return None
+    return valor.split("): ")[-1] if valor.startswith("(") else valor
+
+
+def referencia(nodo):
+    valor = nodo["at"].get("DW_AT_type")
+    return int(valor.strip("<>"), 16) if valor else None
+
+
+def entero(nodo, atributo):
+    valor = nodo["at"].get(atributo)
+    return int(valor.split()[0], 0) if valor else None
+
+
+def tamano(nodos, desplazamiento):
+    """Bytes que ocupa un tipo con los tamanos de XC8."""
+    if desplazamiento is None:
+        return 0
+    nodo = nodos[desplazamiento]
+    tag = nodo["tag"]
+    if tag == "DW_TAG_base_type":
+        return TAMANOS_BASE.get(nombre(nodo), entero(nodo, "DW_AT_byte_size"))
+    if tag in ("DW_TAG_pointer_type", "DW_TAG_subroutine_type"):
+        return APUNTADOR_BYTES
+    if tag in ("DW_TAG_typedef", "DW_TAG_const_type", "DW_TAG_volatile_type"):
+        return tamano(nodos, referencia(nodo))
+    if tag == "DW_TAG_enumeration_type":
+        return entero(nodo, "DW_AT_byte_size") and 1
+    if tag == "DW_TAG_array_type":
+        elementos = 1
+        for hijo in nodo["hijos"]:
+            if hijo["tag"] == "DW_TAG_subrange_type":
+                cuenta = entero(hijo, "DW_AT_count")
+                if cuenta is None:
+                    alto = entero(hijo, "DW_AT_upper_bound")
+                    cuenta = 0 if alto is None else alto + 1
+                elementos *= cuenta
+        return elementos * tamano(nodos, referencia(nodo))
+    if tag in ("DW_TAG_structure_type", "DW_TAG_union_type"):
+        total = bits = 0
+        for hijo in nodo["hijos"]:
+            if hijo["tag"] != "DW_TAG_member":
+                continue
+            ancho_bits = entero(hijo, "DW_AT_bit_size")
+            if ancho_bits is not None:
+                bits += ancho_bits
+                continue
+            t = tamano(nodos, referencia(hijo))
+            total = max(total, t) if tag == "DW_TAG_union_type" else total + t
+        return total + (bits + 7) // 8
+    raise ErrorRecursos("tipo desconocido %s" % tag)
+
+
+def es_constante(nodos, desplazamiento):
+    """El objeto es const (XC8 lo pone en la memoria de programa)."""
+    while desplazamiento is not None:
+        nodo = nodos[desplazamiento]
+        if nodo["tag"] == "DW_TAG_const_type":
+            return True
+        if nodo["tag"] not in ("DW_TAG_typedef", "DW_TAG_volatile_type", "DW_TAG_array_type"):
+            return False
+        desplazamiento = referencia(nodo)
+    return False
+
+
+def es_estatica(nodo):
+    return "DW_OP_addr" in nodo["at"].get("DW_AT_location", "")
+
+
+def locales(nodos, nodo):
+    """Bytes de las variables automaticas de una funcion, incluidos sus bloques."""
+    total = 0
+    for hijo in nodo["hijos"]:
+        if hijo["tag"] == "DW_TAG_variable" and not es_estatica(hijo):
+            total += tamano(nodos, referencia(hijo))
+        elif hijo["tag"] == "DW_TAG_lexical_block":
+            total += locales(nodos, hijo)
+    return total
+
+
+def estaticas_de(nodos, nodo, fuente, variables):
+    for hijo in nodo["hijos"]:
+        if hijo["tag"] == "DW_TAG_variable" and es_estatica(hijo) and not es_constante(nodos, referencia(hijo)):
+            variables.append((os.path.basename(fuente), nombre(hijo), tamano(nodos, referencia(hijo))))
+        elif hijo["tag"] in ("DW_TAG_lexical_block", "DW_TAG_subprogram"):
+            estaticas_de(nodos, hijo, fuente, variables)
+
+
+# --- Grafo de llamadas ---------------------------------------------------
+
+ARISTA = re.compile(r'edge: \{ sourcename: "([^"]+)" targetname: "([^"]+)"')
+NODO = re.compile(r'node: \{ title: "([^"]+)" label: "[^"]*"( shape)?')
+CABECERA_GIMPLE = re.compile(r"^[A-Za-z_].*?\b(\w+) \((.*)\)$")
+OPERACION = re.compile(r"= (\S+) ([*/%]) (\S+);")
+
+
+def potencia_de_2(texto):
+    try:
+        n = int(texto.rstrip("uUlL"))
+    except ValueError:
+        return False
+    return n > 0 and (n & (n - 1)) == 0
+
+
+def usa_ayuda(gimple):
+    """Funciones con multiplicaciones o divisiones que XC8 no hace con corrimientos."""
+    funciones = set()
+    actual = None
+    for linea in gimple.splitlines():
+        m = CABECERA_GIMPLE.match(linea)
+        if m:
+            actual = m.group(1)
+            continue
+        m = OPERACION.search(linea)
+        if m and actual and not (potencia_de_2(m.group(3)) or (m.group(2) == "*" and potencia_de_2(m.group(1)))):
+            funciones.add(actual)
+    return funciones
+
+
+def analiza(compilados):
+    definidas = {}      # clave -> nombre
+    marcos = {}         # clave -> bytes de parametros y locales
+    llamadas = {}       # clave -> conjunto de claves
+    indirectas = set()  # claves que llaman por apuntador
+    variables = []
+    por_nombre = {}
+    fuentes_e = []
+
+    for fuente, dwarf, ci, gimple, fuente_e in compilados:
+        nodos = lee_dwarf(dwarf)
+        fuentes_e.append(fuente_e)
+        ayuda = usa_ayuda(gimple)
+        unidad = next(n for n in nodos.values() if n["tag"] == "DW_TAG_compile_unit")
+        estaticas_de(nodos, unidad, fuente, variables)
+        for nodo in unidad["hijos"]:
+            if nodo["tag"] != "DW_TAG_subprogram" or "DW_AT_low_pc" not in nodo["at"]:
+                continue
+            n = nombre(nodo)
+            clave = n if "DW_AT_external" in nodo["at"] else "%s:%s" % (fuente, n)
+            parametros = sum(tamano(nodos, referencia(h)) for h in nodo["hijos"]
+                             if h["tag"] == "DW_TAG_formal_parameter")
+            regreso = tamano(nodos, referencia(nodo))
+            marcos[clave] = max(parametros, regreso if regreso > 1 else 0) + locales(nodos, nodo)
+            definidas[clave] = n
+            por_nombre.setdefault(n, []).append(clave)
+            llamadas.setdefault(clave, set())
+            if n in ayuda:
+                llamadas[clave].add(AYUDA)
+        for origen, destino in ARISTA.findall(ci):
+            if destino.startswith("sim_") or destino.startswith("__builtin"):
+                continue
+            if destino == "__indirect_call":
+                indirectas.add(origen)
+            else:
+                llamadas.setdefault(origen, set()).add(destino)
+
+    # Funciones usadas como valor (la tabla de tareas): destino de las llamadas por apuntador
+    texto = "\n".join(fuentes_e)
+    apuntadas = set()
+    for n, claves in por_nombre.items():
+        if re.search(r"\b%s\b\s*(?!\s*\()[,}=;)]" % re.escape(n), texto):
+            apuntadas.update(claves)
+    for origen in indirectas:
+        llamadas[origen].update(apuntadas)
+
+    marcos[AYUDA] = AYUDA_BYTES
+    definidas[AYUDA] = AYUDA
+    llamadas[AYUDA] = set()
+    return definidas, marcos, llamadas, variables
+
+
+def mas_profundo(llamadas, marcos, raiz, peso):
+    """Camino desde raiz que maximiza la suma de peso(funcion); regresa (valor, camino)."""
+    memoria = {}
+    visitando = set()
+
+    def visita(clave):
+        if clave in memoria:
+            return memoria[clave]
+        if clave in visitando:
+            raise ErrorRecursos("llamada recursiva en %s" % clave)
+        visitando.add(clave)
+        mejor, camino = 0, []
+        for destino in llamadas.get(clave, ()):
+            if destino not in marcos:
+                continue    # funcion de la biblioteca de la PC
+            valor, resto = visita(destino)
+            if valor > mejor or not camino:
+                mejor, camino = valor, resto
+        visitando.discard(clave)
+        memoria[clave] = (peso(clave) + mejor, [clave] + camino)
+        return memoria[clave]
+
+    return visita(raiz)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("-D", dest="definiciones", action="append", default=[],
+                        help="parametro de compilacion, como en gcc")
+    parser.add_argument("--variables", type=int, default=10, help="variables mas grandes que se listan")
+    args = parser.parse_args()
+
+    directorio = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+    fuentes = sorted(glob.glob(os.path.join(directorio, "*.c")))
+    try:
+        definidas, marcos, llamadas, variables = analiza(compila(fuentes, directorio, ["-D" + d for d in args.definiciones]))
+        if "main_firmware" not in definidas or "isr" not in definidas:
+            raise ErrorRecursos("no se encontraron main() e isr()")
+        niveles_main, camino_main = mas_profundo(llamadas, marcos, "main_firmware", lambda c: 1)
+        niveles_isr, camino_isr = mas_profundo(llamadas, marcos, "isr", lambda c: 1)
+        pila_main, pesado_main = mas_profundo(llamadas, marcos, "main_firmware", lambda c: marcos[c])
+        pila_isr, pesado_isr = mas_profundo(llamadas, marcos, "isr", lambda c: marcos[c])
+    except (ErrorRecursos, OSError) as error:
+        sys.exit("recursos.py: %s" % error)
+
+    def ruta(camino):
+        return " > ".join(definidas[c].replace("main_firmware", "main") for c in camino)
+
+    # main() y isr() no ocupan un nivel: a main se llega con un salto y la
+    # interrupcion ocupa uno por si misma
+    pila = (niveles_main - 1) + 1 + (niveles_isr - 1)
+    estaticas = sum(t for _, _, t in variables)
+    ram = estaticas + pila_main + pila_isr + RESERVA_BYTES
+    mayor = max(variables, key=lambda v: v[2])
+
+    print("Pila de hardware: %d de %d niveles" % (pila, PILA_NIVELES))
+    print("  main  %d: %s" % (niveles_main - 1, ruta(camino_main)))
+    print("  isr 1+%d: %s" % (niveles_isr - 1, ruta(camino_isr)))
+    print("RAM: %d de %d bytes" % (ram, RAM_BYTES))
+    print("  variables      %4d" % estaticas)
+    print("  pila de main   %4d: %s" % (pila_main, ruta(pesado_main)))
+    print("  pila de isr    %4d: %s" % (pila_isr, ruta(pesado_isr)))
+    print("  reserva        %4d" % RESERVA_BYTES)
+    print("Variables mas grandes (un objeto debe caber en un banco de %d bytes):" % BANCO_BYTES)
+    for archivo, n, t in sorted(variables, key=lambda v: -v[2])[:args.variables]:
+        print("  %4d  %s:%s" % (t, archivo, n))
+
+    errores = []
+    if pila > PILA_NIVELES:
+        errores.append("la pila de hardware se desborda")
+    if ram > RAM_BYTES:
+        errores.append("la RAM no alcanza")
+    if mayor[2] > BANCO_BYTES:
+        errores.append("%s no cabe en un banco" % mayor[1])
+    if errores:
+        sys.exit("recursos.py: " + "; ".join(errores))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,112 @@
+#!/usr/bin/env python3
+"""Decodifica las tramas binarias de matrizv3 (ver telemetria.h) en lineas de texto.
+
+Cada trama es 0x7E | LONGITUD | TIPO | DATOS | CRC8. Las tramas con CRC
+incorrecto se cuentan y se descartan, y el decodificador vuelve a buscar la
+sincronia en el byte siguiente, asi que un byte perdido solo cuesta la trama
+donde ocurrio.
+
+    'L' (id, valor)...   muestras: una linea "id valor" por muestra
+    'E'                  estadisticas (respuesta al comando 'E')
+    otras                tipo y datos en hexadecimal
+
+Lee del puerto serial hasta Ctrl-C, o de un archivo con --archivo.
+
+Necesita pyserial (pip install pyserial) para leer del puerto.
+
+Uso:
+    telemetria.py /dev/ttyUSB0
+    telemetria.py --archivo captura.bin
+"""
+
+import argparse
+import struct
+import sys
+
+from programa import SYNC, crc8
+
+ESTADISTICAS = ["tramas", "errores CRC", "perdidas", "desbordes RX", "descartados TX",
+                "aciertos glifos", "fallos glifos"]
+
+
+class Decodificador:
+    """Separa tramas de un flujo de bytes que puede llegar en pedazos."""
+
+    def __init__(self):
+        self.pendiente = bytearray()
+        self.errores = 0
+
+    def agrega(self, datos):
+        """Agrega bytes recibidos y regresa la lista de (tipo, datos) completas."""
+        self.pendiente += datos
+        tramas = []
+        while True:
+            inicio = self.pendiente.find(SYNC)
+            if inicio < 0:
+                self.pendiente.clear()
+                return tramas
+            del self.pendiente[:inicio]
+            if len(self.pendiente) < 4:
+                return tramas
+            n = self.pendiente[1]
+            if len(self.pendiente) < n + 4:
+                return tramas
+            cuerpo = bytes(self.pendiente[1:n + 3])
+            if crc8(cuerpo) == self.pendiente[n + 3]:
+                tramas.append((chr(cuerpo[1]), cuerpo[2:]))
+                del self.pendiente[:n + 4]
+            else:
+                # Sincronia falsa o trama danada: se busca desde el siguiente byte
+                self.errores += 1
+                del self.pendiente[:1]
+
+
+def describe(tipo, datos):
+    """Lineas de texto de una trama."""
+    if tipo == "L":
+        return ["%3d %3d" % (datos[k], datos[k + 1]) for k in range(0, len(datos) - 1, 2)]
+    if tipo == "E" and len(datos) == 2 * len(ESTADISTICAS):
+        valores = struct.unpack("<%dH" % len(ESTADISTICAS), datos)
+        return ["E " + ", ".join("%s %d" % par for par in zip(ESTADISTICAS, valores))]
+    return ["%s %s" % (repr(tipo), datos.hex(" "))]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("puerto", nargs="?", help="puerto serial, por ejemplo /dev/ttyUSB0 o COM3")
+    parser.add_argument("--baudios", type=int, default=9600)
+    parser.add_argument("--archivo", help="decodifica una captura en lugar de usar el puerto")
+    args = parser.parse_args()
+
+    decodificador = Decodificador()
+
+    def muestra(datos):
+        for tipo, contenido in decodificador.agrega(datos):
+            for linea in describe(tipo, contenido):
+                print(linea)
+        sys.stdout.flush()
+
+    try:
+        if args.archivo:
+            with open(args.archivo, "rb") as archivo:
+                muestra(archivo.read())
+        elif args.puerto:
+            try:
+                import serial
+            except ImportError:
+                sys.exit("telemetria.py: se necesita pyserial (pip install pyserial)")
+            with serial.Serial(args.puerto, args.baudios, timeout=0.1) as puerto:
+                while True:
+                    muestra(puerto.read(256))
+        else:
+            parser.error("falta el puerto o --archivo")
+    except KeyboardInterrupt:
+        pass
+    except OSError as error:
+        sys.exit("telemetria.py: %s" % error)
+    if decodificador.errores:
+        print("%d tramas descartadas (CRC incorrecto o sincronia falsa)" % decodificador.errores, file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
@@ -1,5 +1,61 @@
 #include "m93lc66b.h"
 
+const unsigned char OPcode_Lectura = 0b00000010;
+const unsigned char OPcode_Escritura = 0b00000001;
+const unsigned char OPcode_Borrado = 0b00000011;
+const unsigned char OPcode_Especial = 0b00000000;
+
+//Los comandos especiales (OPcode_Especial) se distinguen por los dos bits
+//altos de la direccion
+#define M93_EWDS (0u << (M93_BITS_DIRECCION - 2))
+#define M93_WRAL (1u << (M93_BITS_DIRECCION - 2))
+#define M93_ERAL (2u << (M93_BITS_DIRECCION - 2))
+#define M93_EWEN (3u << (M93_BITS_DIRECCION - 2))
+
+#if M93LC66B_RETARDO_US > 0
+#define RETARDO_93() __delay_us(M93LC66B_RETARDO_US)
+#else
+#define RETARDO_93()
+#endif
+
+//Los pasos internos de cada comando son macros y no funciones: una lectura
+//del indice llega aqui desde la marquesina a varios niveles de profundidad y
+//la pila de hardware del PIC16F628A es de solo 8 niveles, compartidos con la
+//interrupcion
+
+//Cierra la transaccion en curso
+#define FIN_COMANDO() do { SK = 0; DI = 0; CS = 0; } while (0)
+//Consulta una vez si termino el ciclo de escritura: tras el ciclo DO indica
+//el estado mientras CS esta en alto
+#define CONSULTA_LISTO() do { SK = 0; DI = 0; CS = 0; RETARDO_93(); CS = 1; RETARDO_93(); \
+                              if (DO) { programando = 0; } CS = 0; } while (0)
+//Envia bit de inicio, codigo de lectura y direccion de la celda
+#define ARRANCA_LECTURA(direccion) do { startBit(); escribe(OPcode_Lectura, 2); \
+                                        escribe(M93_CELDA(direccion), M93_BITS_DIRECCION); \
+                                        /* Un pulso mas para el bit ficticio en 0 que precede a los datos */ \
+                                        escribe(0, 1); } while (0)
+//El bus es de uno solo: antes de cada comando se interrumpe la lectura no
+//bloqueante, que se reanuda desde su siguiente palabra en el proximo paso, y
+//se espera el fin de la escritura anterior
+#define LIBERA_BUS() do { if (estadoLectura == M93_PALABRAS) { FIN_COMANDO(); estadoLectura = M93_ARRANQUE; } \
+                          esperaListo93LC66B(); } while (0)
+//Cuerpo de iniciaLectura93LC66B(), que las lecturas de esta biblioteca usan
+//directamente
+#define INICIA_LECTURA(direccion) do { LIBERA_BUS(); ARRANCA_LECTURA(direccion); } while (0)
+//Cierra un comando de programacion; el ciclo interno ya empezo y una lectura
+//no bloqueante interrumpida debe esperarlo
+#define TERMINA_PROGRAMACION() do { FIN_COMANDO(); programando = 1; \
+                                    if (estadoLectura == M93_ARRANQUE) estadoLectura = M93_ESPERA_LISTO; } while (0)
+
+//Lectura no bloqueante en curso (ver pasoLectura93LC66B())
+static unsigned char estadoLectura = M93_LIBRE;
+static unsigned int direccionLectura;
+static unsigned int *destinoLectura;
+static unsigned char palabrasLectura;
+//Hay un ciclo de escritura interno en curso; antes del siguiente comando se
+//consulta DO hasta que la memoria indique que esta lista
+static unsigned char programando = 0;
+
 void init_93lc66b(void)
 {
     TRISAbits.TRISA0 =0;
@@ -12,19 +68,15 @@ void init_93lc66b(void)
 unsigned int shiftIn16(){
     int i;
     int temp = 0;
-    int pinState;
     unsigned int myDataIn = 0;
     
     for (i = 15; i>=0; i--)
     {
         SK = 0;
-        __delay_us(1);
+        RETARDO_93();
         temp = DO;
         if(temp){
-            pinState = 1;
             myDataIn = myDataIn | (1 << i);
-        }else{
-            pinState = 0;
         }
         SK = 1;
     }
@@ -33,25 +85,56 @@ unsigned int shiftIn16(){
 
 void startBit(void){
     CS = 0;
-    __delay_us(1);
+    RETARDO_93();
     SK = 0;
     DI = 0;
     CS = 1;
-    __delay_us(1);
+    RETARDO_93();
     DI = 1;
-    __delay_us(1);
+    RETARDO_93();
     SK = 1;   //flanco de subida 
-    __delay_us(1);
+    RETARDO_93();
     SK = 0;
-    __delay_us(1);
+    RETARDO_93();
+}
+
+unsigned char shiftIn8(void)
+{
+    unsigned char i;
+    unsigned char dato = 0;
+    
+    for (i = 0; i < 8; i++)
+    {
+        SK = 0;
+        RETARDO_93();
+        dato <<= 1;
+        if (DO)
+            dato |= 1;
+        SK = 1;
+    }
+    return dato;
 }
 
 unsigned int leeMemoria(){
     
     unsigned int Buffer = 0;
-    SK = 0;
-    Buffer = shiftIn16();
-    //Buffer = (Buffer >> 8) | (Buffer << 8);
+    unsigned char i;
+    
+    //Los 16 pulsos aqui mismo, como en shiftIn16(): es la ultima llamada de
+    //las lecturas y no debe gastar otro nivel de la pila
+    for (i = 0; i < 16; i++)
+    {
+        SK = 0;
+        RETARDO_93();
+        Buffer <<= 1;
+        if (DO)
+            Buffer |= 1;
+        SK = 1;
+    }
+#if M93_ORG == 8
+    //Dos bytes consecutivos, el de la direccion menor es el menos significativo
+    Buffer = (Buffer >> 8) | (Buffer << 8);
+#endif
     return Buffer;
 }
 
@@ -67,56 +150,265 @@ void escribe(unsigned int dato, unsigned char contador)
 {
     while(contador > 0)
     {
-        __delay_us(1);  
+        RETARDO_93();
         //Posicionamos el bit a leer de dato y lo copiamos a DI
-        DI = bitRead(dato,(contador - 1));
-        __delay_us(1);
+        DI = (dato >> (contador - 1)) & 0x01;
+        RETARDO_93();
         SK = 1;
-        __delay_us(1);
+        RETARDO_93();
         SK = 0;
-        __delay_us(1);
+        RETARDO_93();
         contador--;
     }
     DI = 0;
 }
 
-void leeAutomatico(unsigned int inicio, int alcance)
+unsigned char listo93LC66B(void)
+{
+    CONSULTA_LISTO();
+    return !programando;
+}
+
+unsigned char ocupado93LC66B(void)
+{
+    //Con una escritura pendiente no hay lecturas a medias en el bus
+    return programando && !listo93LC66B();
+}
+
+unsigned char esperaListo93LC66B(void)
 {
-    unsigned int direccion = inicio;
+    unsigned int consultas = M93LC66B_CONSULTAS_MAX;
+    
+    while (programando)
+    {
+        CONSULTA_LISTO();
+        if (!programando)
+            return 1;
+        if (--consultas == 0)
+        {
+            //La memoria no respondio; no se vuelve a esperar en cada comando
+            programando = 0;
+            return 0;
+        }
+    }
+    return 1;
+}
+
+//Envia bit de inicio, codigo de operacion y direccion de la celda
+static void enviaComando(unsigned char opcode, unsigned int celda)
+{
+    LIBERA_BUS();
     startBit();
-    escribe(OPcode_Lectura,2);
-    escribe(direccion, 9);
-    if (alcance > direccion)
+    escribe(opcode, 2);
+    escribe(celda, M93_BITS_DIRECCION);
+}
+
+#define ESCRIBE_CELDA(celda, dato) do { enviaComando(OPcode_Escritura, celda); escribe(dato, M93_ORG); \
+                                        TERMINA_PROGRAMACION(); } while (0)
+
+void habilitaEscritura93LC66B(void)
+{
+    enviaComando(OPcode_Especial, M93_EWEN);
+    FIN_COMANDO();
+}
+
+void protegeEscritura93LC66B(void)
+{
+    enviaComando(OPcode_Especial, M93_EWDS);
+    FIN_COMANDO();
+}
+
+static void borraCelda(unsigned int celda)
+{
+    enviaComando(OPcode_Borrado, celda);
+    TERMINA_PROGRAMACION();
+}
+
+void escribe93LC66B(unsigned int direccion, unsigned int dato)
+{
+#if M93_ORG == 16
+    ESCRIBE_CELDA(M93_CELDA(direccion), dato);
+#else
+    //El siguiente comando espera a que termine el primer byte
+    ESCRIBE_CELDA(direccion, dato & 0x00FF);
+    ESCRIBE_CELDA(direccion + 1, dato >> 8);
+#endif
+}
+
+void borra93LC66B(unsigned int direccion)
+{
+#if M93_ORG == 16
+    borraCelda(M93_CELDA(direccion));
+#else
+    borraCelda(direccion);
+    borraCelda(direccion + 1);
+#endif
+}
+
+void escribeTodo93LC66B(unsigned int dato)
+{
+    enviaComando(OPcode_Especial, M93_WRAL);
+    escribe(dato, M93_ORG);
+    TERMINA_PROGRAMACION();
+}
+
+void borraTodo93LC66B(void)
+{
+    enviaComando(OPcode_Especial, M93_ERAL);
+    TERMINA_PROGRAMACION();
+}
+
+unsigned char programaImagen93LC66B(unsigned int inicio, const uint8_t *imagen, unsigned char cantidad)
+{
+    unsigned int dato;
+    unsigned char escritas = 0;
+    
+    habilitaEscritura93LC66B();
+    while (cantidad > 0)
     {
-        while(direccion <= alcance)
+        dato = imagen[0] | ((unsigned int)imagen[1] << 8);
+        //Las palabras que ya tienen el valor no gastan un ciclo de escritura
+        if (lee93LC66B(inicio) != dato)
         {
-            Buf = leeMemoria();
-            __delay_ms(10);
-            SK = 0;
-            __delay_us(1);
-            DI = 0;
-            direccion++;
+            escribe93LC66B(inicio, dato);
+            if (!esperaListo93LC66B() || lee93LC66B(inicio) != dato)
+            {
+                escritas = M93_ERROR_PROGRAMA;
+                break;
+            }
+            escritas++;
         }
-    }else{
-        Buf = leeMemoria();
-        __delay_ms(10);
-        SK = 0;
-        __delay_us(1);
-        DI = 0;
-        
+        inicio += 2;
+        imagen += 2;
+        cantidad--;
+    }
+    protegeEscritura93LC66B();
+    return escritas;
+}
+
+void iniciaLectura93LC66B(unsigned int direccion)
+{
+    INICIA_LECTURA(direccion);
+}
+
+void pideLectura93LC66B(unsigned int inicio, unsigned int *destino, unsigned char cantidad)
+{
+    while (pasoLectura93LC66B())
+        ;
+    direccionLectura = inicio;
+    destinoLectura = destino;
+    palabrasLectura = cantidad;
+    if (cantidad == 0)
+        return;
+    estadoLectura = programando ? M93_ESPERA_LISTO : M93_ARRANQUE;
+}
+
+unsigned char pasoLectura93LC66B(void)
+{
+    switch (estadoLectura)
+    {
+        case M93_ESPERA_LISTO:
+            CONSULTA_LISTO();
+            if (!programando)
+                estadoLectura = M93_ARRANQUE;
+            return 1;
+        case M93_ARRANQUE:
+            ARRANCA_LECTURA(direccionLectura);
+            estadoLectura = M93_PALABRAS;
+            return 1;
+        case M93_PALABRAS:
+            *destinoLectura = leeMemoria();
+            destinoLectura++;
+            //Por si otro comando la interrumpe y hay que volver a arrancarla
+            direccionLectura += 2;
+            palabrasLectura--;
+            if (palabrasLectura != 0)
+                return 1;
+            FIN_COMANDO();
+            estadoLectura = M93_LIBRE;
+            return 0;
+        default:
+            return 0;
     }
 }
 
+unsigned char lecturaLista93LC66B(void)
+{
+    //Una lectura interrumpida queda en M93_ARRANQUE o M93_ESPERA_LISTO
+    return estadoLectura == M93_LIBRE;
+}
+
+void terminaLectura93LC66B(void)
+{
+    FIN_COMANDO();
+}
+
+void leeAutomatico(unsigned int inicio, unsigned int *destino, unsigned char cantidad)
+{
+    if (cantidad == 0)
+    {
+        return;
+    }
+    INICIA_LECTURA(inicio);
+    while(cantidad > 0)
+    {
+        *destino = leeMemoria();
+        destino++;
+        cantidad--;
+    }
+    FIN_COMANDO();
+}
+
 unsigned int lee93LC66B(unsigned int direccion)
 {
-    unsigned int data=0;
-    startBit();
-    escribe(OPcode_Lectura,2);
-    escribe(direccion, 9);
-    data = leeMemoria();
-    __delay_ms(10);
-    SK = 0;
-    __delay_us(1);
-    DI = 0;
-    return data;
+    //La direccion ya no se usa y guarda el dato: un int menos en la pila
+    //compilada, en el camino de la busqueda de glifos
+    INICIA_LECTURA(direccion);
+    direccion = leeMemoria();
+    FIN_COMANDO();
+    return direccion;
+}
+
+void leeBytes93LC66B(unsigned int inicio, uint8_t *destino, unsigned char cantidad)
+{
+#if M93_ORG == 16
+    unsigned int palabra = 0;
+    unsigned char pendiente = 0;    //el byte alto de palabra falta por copiar
+#endif
+    
+    if (cantidad == 0)
+    {
+        return;
+    }
+    INICIA_LECTURA(inicio);
+#if M93_ORG == 16
+    //En x16 cada palabra trae dos bytes; una direccion impar empieza en el alto
+    if (inicio & 1)
+    {
+        palabra = leeMemoria() >> 8;
+        pendiente = 1;
+    }
+#endif
+    while (cantidad > 0)
+    {
+#if M93_ORG == 8
+        *destino = shiftIn8();
+#else
+        if (pendiente)
+        {
+            *destino = palabra & 0x00FF;
+            pendiente = 0;
+        }
+        else
+        {
+            palabra = leeMemoria();
+            *destino = palabra & 0x00FF;
+            palabra >>= 8;
+            pendiente = 1;
+        }
+#endif
+        destino++;
+        cantidad--;
+    }
+    FIN_COMANDO();
 }
@@ -1,7 +1,9 @@
 /* 
  * File:   
  * Author: 
- * Comments:
+ * Comments: Controlador Microwire para las EEPROM 93xx46 a 93xx86. Conserva el
+ *           nombre de la 93LC66B, que es la memoria de la tarjeta; el modelo y
+ *           la organizacion se eligen con M93_MODELO y M93_ORG.
  * Revision history: 
  */
 
@@ -11,7 +13,10 @@
 #define	M93LC66B_H
 
 #include <xc.h> // include processor files - each processor file is guarded.  
+#include <stdint.h>
+#ifndef _XTAL_FREQ
 #define _XTAL_FREQ 4000000
+#endif
 
 // Definiciones de pines
 // Interfaz 93LC66B
@@ -20,12 +25,75 @@
 #define DI PORTAbits.RA2
 #define DO PORTAbits.RA3
  
-const unsigned char OPcode_Lectura = 0b00000010;
-//Numero de elementos guardos en la EEPROM
-//Este valor puede cambiar de acuerdo al numero de 
-//patrones que hayan sido guardados
-const unsigned char NUM_OF_CHARACTERS = 37;
-unsigned int Buf; //variable que recibe el contenido de la memoria
+//Modelo de la memoria: 46, 56, 66, 76 u 86 (93xx46 ... 93xx86)
+#ifndef M93_MODELO
+#define M93_MODELO 66
+#endif
+//Organizacion: 16 (pin ORG en alto) u 8 (ORG en bajo). La 93LC66B solo
+//existe en x16; para x8 se usa una 93LC66A, o una 93LC66C con ORG a tierra.
+#ifndef M93_ORG
+#define M93_ORG 16
+#endif
+
+//Capacidad en bytes y bits de direccion en x16 (en x8 se agrega uno)
+#if M93_MODELO == 46
+#define M93_BYTES 128
+#define M93_BITS_X16 6
+#elif M93_MODELO == 56
+#define M93_BYTES 256
+#define M93_BITS_X16 8
+#elif M93_MODELO == 66
+#define M93_BYTES 512
+#define M93_BITS_X16 8
+#elif M93_MODELO == 76
+#define M93_BYTES 1024
+#define M93_BITS_X16 10
+#elif M93_MODELO == 86
+#define M93_BYTES 2048
+#define M93_BITS_X16 10
+#else
+#error "M93_MODELO debe ser 46, 56, 66, 76 u 86"
+#endif
+
+#if M93_ORG == 16
+#define M93_BITS_DIRECCION M93_BITS_X16
+#define M93_BYTES_CELDA 2
+#elif M93_ORG == 8
+#define M93_BITS_DIRECCION (M93_BITS_X16 + 1)
+#define M93_BYTES_CELDA 1
+#else
+#error "M93_ORG debe ser 8 o 16"
+#endif
+//Celda de la memoria (palabra en x16, byte en x8) que contiene un byte de la imagen
+#define M93_CELDA(direccion) ((direccion) / M93_BYTES_CELDA)
+
+extern const unsigned char OPcode_Lectura;
+extern const unsigned char OPcode_Escritura;
+extern const unsigned char OPcode_Borrado;
+extern const unsigned char OPcode_Especial;
+
+//Retardo en us alrededor de los flancos de SK y CS. A 4 MHz cada instruccion
+//ya dura 1 us y la 93LC66B acepta relojes de 2 MHz o mas, asi que 0 (sin
+//retardo) basta; se aumenta con cables largos o alimentacion baja.
+#ifndef M93LC66B_RETARDO_US
+#define M93LC66B_RETARDO_US 0
+#endif
+
+//Consultas de DO antes de dar por fallida una escritura. Cada consulta dura
+//entre 5 y 20 us a 4 MHz; la 93LC66B tarda a lo sumo 6 ms por palabra y
+//15 ms en WRAL, asi que 10000 consultas dejan margen de sobra.
+#ifndef M93LC66B_CONSULTAS_MAX
+#define M93LC66B_CONSULTAS_MAX 10000
+#endif
+
+//Valor de programaImagen93LC66B() cuando una palabra no se pudo grabar
+#define M93_ERROR_PROGRAMA 0xFF
+
+//Estados de la lectura no bloqueante (pasoLectura93LC66B())
+#define M93_LIBRE 0
+#define M93_ESPERA_LISTO 1
+#define M93_ARRANQUE 2
+#define M93_PALABRAS 3
 
 
 /**
@@ -33,108 +101,118 @@ unsigned int Buf; //variable que recibe el contenido de la memoria
  *
  * @pre Ninguna.
  *
- * @details Esta funcin configura los pines del microcontrolador para la comunicacin con la EEPROM 93LC66B. Configura los pines RA0 (CS), RA1 (CLK) y RA2 (DI) como salidas, y el pin RA3 (DO) como entrada. Adems, deshabilita los comparadores analgicos configurando el registro CMCON.
+ * @details Esta función configura los pines del microcontrolador para la comunicación con la EEPROM 93LC66B. Configura los pines RA0 (CS), RA1 (CLK) y RA2 (DI) como salidas, y el pin RA3 (DO) como entrada. Además, deshabilita los comparadores analógicos configurando el registro CMCON.
  *
  * @code
  * init_93lc66b(); // Inicializa la EEPROM 93LC66B
  * @endcode
  *
- * @note Es crucial que los pines del microcontrolador se configuren correctamente para evitar conflictos y asegurar una comunicacin adecuada con la EEPROM.
+ * @note Es crucial que los pines del microcontrolador se configuren correctamente para evitar conflictos y asegurar una comunicación adecuada con la EEPROM.
  *
- * @remark La configuracin `CMCON = 0x07` deshabilita los comparadores analgicos en el PIC. Si necesitas usar los comparadores, debers modificar esta configuracin y asegurarte de que no interfieran con la comunicacin con la EEPROM.
+ * @remark La configuración `CMCON = 0x07` deshabilita los comparadores analógicos en el PIC. Si necesitas usar los comparadores, deberás modificar esta configuración y asegurarte de que no interfieran con la comunicación con la EEPROM.
  */
 void init_93lc66b(void);
 
 /**
  * @brief Lee 16 bits de datos desde un dispositivo externo utilizando un protocolo de desplazamiento.
  *
- * @pre Los pines SK (reloj) y DO (datos de entrada) deben estar configurados correctamente. El dispositivo externo debe estar enviando los datos sincronizados con la seal de reloj.
+ * @pre Los pines SK (reloj) y DO (datos de entrada) deben estar configurados correctamente. El dispositivo externo debe estar enviando los datos sincronizados con la señal de reloj.
  *
- * @details Esta funcin implementa un protocolo de desplazamiento para leer 16 bits de datos desde un dispositivo externo. Funciona de la siguiente manera:
+ * @details Esta función implementa un protocolo de desplazamiento para leer 16 bits de datos desde un dispositivo externo. Funciona de la siguiente manera:
  *   1. Se inicializa una variable `myDataIn` a 0 para almacenar los datos recibidos.
  *   2. Se itera 16 veces (para leer 16 bits).
- *   3. En cada iteracin:
+ *   3. En cada iteración:
  *     a. Se pone el pin SK (reloj) a bajo.
- *     b. Se espera 1 microsegundo.
+ *     b. Se espera `M93LC66B_RETARDO_US` microsegundos (sin retardo si es 0).
  *     c. Se lee el estado del pin DO (datos de entrada) y se guarda en la variable `temp`.
  *     d. Si `temp` es 1, se establece el bit correspondiente en `myDataIn` usando un OR bit a bit y un desplazamiento a la izquierda.
  *     e. Se pone el pin SK (reloj) a alto.
- *   4. Finalmente, se retorna el valor de `myDataIn`, que contiene los 16 bits ledos.
+ *   4. Finalmente, se retorna el valor de `myDataIn`, que contiene los 16 bits leídos.
  *
- * @return Un valor entero sin signo de 16 bits (`unsigned int`) que contiene los datos ledos.
+ * @return Un valor entero sin signo de 16 bits (`unsigned int`) que contiene los datos leídos.
  *
  * @code
  * unsigned int receivedData = shiftIn16(); // Lee 16 bits de datos.
  * @endcode
  *
- * @note La precisin del retardo depende de la frecuencia del oscilador del microcontrolador. Asegrese de que la macro `__delay_us()` est configurada correctamente para su configuracin de hardware.
+ * @note La precisión del retardo depende de la frecuencia del oscilador del microcontrolador. Los retardos se ajustan con `M93LC66B_RETARDO_US`.
  *
- * @remark Es crucial que el dispositivo externo genere una seal de reloj y datos compatible con este protocolo de lectura. Consultar la hoja de datos del dispositivo externo para obtener informacin precisa sobre los tiempos y el protocolo de comunicacin. La variable `pinState` no es necesaria y puede ser eliminada para optimizar el cdigo.
+ * @remark Es crucial que el dispositivo externo genere una señal de reloj y datos compatible con este protocolo de lectura. Consultar la hoja de datos del dispositivo externo para obtener información precisa sobre los tiempos y el protocolo de comunicación. La variable `pinState` no es necesaria y puede ser eliminada para optimizar el código.
  */
 unsigned int shiftIn16();
 /**
- * @brief Genera la secuencia de bits de inicio para la comunicacin con la EEPROM 93LC66B.
+ * @brief Genera la secuencia de bits de inicio para la comunicación con la EEPROM 93LC66B.
  *
  * @pre Los pines CS (Chip Select), SK (Clock) y DI (Data In) deben estar configurados como salidas.
  *
- * @details Esta funcin genera la secuencia de bits necesaria para iniciar una comunicacin con la EEPROM 93LC66B. La secuencia consiste en los siguientes pasos:
- *   1. Se pone CS a bajo (seleccin del chip).
- *   2. Se espera 1 microsegundo.
+ * @details Esta función genera la secuencia de bits necesaria para iniciar una comunicación con la EEPROM 93LC66B. La secuencia consiste en los siguientes pasos:
+ *   1. Se pone CS a bajo (selección del chip).
+ *   2. Se espera `M93LC66B_RETARDO_US` microsegundos (sin retardo si es 0).
  *   3. Se pone SK a bajo.
  *   4. Se pone DI a bajo.
  *   5. Se pone CS a alto.
- *   6. Se espera 1 microsegundo.
+ *   6. Se espera `M93LC66B_RETARDO_US` microsegundos (sin retardo si es 0).
  *   7. Se pone DI a alto.
- *   8. Se espera 1 microsegundo.
+ *   8. Se espera `M93LC66B_RETARDO_US` microsegundos (sin retardo si es 0).
  *   9. Se genera un flanco de subida en SK (SK pasa a alto).
- *   10. Se espera 1 microsegundo.
+ *   10. Se espera `M93LC66B_RETARDO_US` microsegundos (sin retardo si es 0).
  *   11. Se pone SK a bajo.
- *   12. Se espera 1 microsegundo.
+ *   12. Se espera `M93LC66B_RETARDO_US` microsegundos (sin retardo si es 0).
  *
  * @code
- * startBit(); // Inicia la comunicacin con la EEPROM.
+ * startBit(); // Inicia la comunicación con la EEPROM.
  * @endcode
  *
- * @note La precisin de los retardos depende de la frecuencia del oscilador del microcontrolador. Asegrese de que la macro `__delay_us()` est configurada correctamente para su configuracin de hardware.
+ * @note La precisión de los retardos depende de la frecuencia del oscilador del microcontrolador. Los retardos se ajustan con `M93LC66B_RETARDO_US`.
  *
- * @remark Esta secuencia de bits es especfica para la EEPROM 93LC66B y debe consultarse la hoja de datos para verificar los tiempos y la secuencia exacta. Un error en esta secuencia impedir la correcta comunicacin con la EEPROM.
+ * @remark Esta secuencia de bits es específica para la EEPROM 93LC66B y debe consultarse la hoja de datos para verificar los tiempos y la secuencia exacta. Un error en esta secuencia impedirá la correcta comunicación con la EEPROM.
  */
 void startBit(void);
 /**
  * @brief Lee 16 bits de datos desde la EEPROM 93LC66B.
  *
- * @pre Los pines CS, SK y DO deben estar configurados correctamente. La EEPROM debe haber sido inicializada correctamente con la funcin `init_93lc66b()`. Se debe haber enviado previamente el cdigo de operacin y la direccin de lectura.
+ * @pre Los pines CS, SK y DO deben estar configurados correctamente. La EEPROM debe haber sido inicializada correctamente con la función `init_93lc66b()`. Se debe haber enviado previamente el código de operación y la dirección de lectura.
  *
- * @details Esta funcin lee 16 bits de datos desde la EEPROM 93LC66B utilizando la funcin `shiftIn16()`. El valor ledo se almacena en la variable `Buffer` y se retorna.
+ * @details Esta función lee 16 bits de datos desde la EEPROM 93LC66B con los mismos pulsos de reloj que `shiftIn16()`, generados aquí mismo para no ocupar otro nivel de la pila de hardware. El valor leído se almacena en la variable `Buffer` y se retorna. Con `M93_ORG` igual a 8 los 16 bits son dos bytes consecutivos y el primero se pone en la parte baja, de modo que la palabra es la misma que se obtiene en x16 de una imagen `tabla_leds.bin`.
  *
- * @return Un valor entero sin signo de 16 bits (`unsigned int`) que contiene los datos ledos desde la EEPROM.
+ * @return Un valor entero sin signo de 16 bits (`unsigned int`) que contiene los datos leídos desde la EEPROM.
  *
  * @code
  * unsigned int data = leeMemoria(); // Lee 16 bits de datos desde la EEPROM.
  * @endcode
  *
- * @remark Esta funcin asume que ya se ha enviado el cdigo de operacin de lectura y la direccin a la EEPROM. Consultar la hoja de datos de la 93LC66B para obtener informacin sobre el protocolo de comunicacin completo. El cdigo comentado `//Buffer = (Buffer >> 8) | (Buffer << 8);` se ha eliminado porque no se utiliza. Si se necesitara invertir el orden de los bytes, se debera volver a incluir y documentar adecuadamente.
+ * @remark Esta función asume que ya se ha enviado el código de operación de lectura y la dirección a la EEPROM. Consultar la hoja de datos de la 93LC66B para obtener información sobre el protocolo de comunicación completo. En x8 el intercambio `(Buffer >> 8) | (Buffer << 8)` deja el byte de la dirección menor en la parte baja.
  */
 unsigned int leeMemoria();
 /**
- * @brief Lee el valor de un bit especfico dentro de un dato de 16 bits.
+ * @brief Lee 8 bits de la EEPROM, el más significativo primero.
  *
- * @param data Dato de 16 bits del cual se leer el bit.
- * @param numeroBit Nmero del bit que se desea leer (0 para el bit menos significativo, 15 para el ms significativo).
+ * @pre Igual que `shiftIn16()`: la lectura ya debe estar iniciada.
  *
- * @pre `numeroBit` debe estar dentro del rango vlido de 0 a 15.
+ * @details Es la lectura de una celda en organización x8. En x16 entrega la mitad alta o baja de la palabra en curso, según cuántos bits se hayan leído antes.
  *
- * @details Esta funcin extrae el valor de un bit especfico dentro de un dato de 16 bits. Utiliza un desplazamiento a la derecha (`>>`) para mover el bit deseado a la posicin menos significativa y luego una mscara AND (`& 0x01`) para obtener su valor (0 o 1).
+ * @return El byte leído.
+ */
+unsigned char shiftIn8(void);
+/**
+ * @brief Lee el valor de un bit específico dentro de un dato de 16 bits.
+ *
+ * @param data Dato de 16 bits del cual se leerá el bit.
+ * @param numeroBit Número del bit que se desea leer (0 para el bit menos significativo, 15 para el más significativo).
+ *
+ * @pre `numeroBit` debe estar dentro del rango válido de 0 a 15.
  *
- * @return Un valor de tipo `unsigned char` que representa el valor del bit ledo (0 o 1).
+ * @details Esta función extrae el valor de un bit específico dentro de un dato de 16 bits. Utiliza un desplazamiento a la derecha (`>>`) para mover el bit deseado a la posición menos significativa y luego una máscara AND (`& 0x01`) para obtener su valor (0 o 1).
+ *
+ * @return Un valor de tipo `unsigned char` que representa el valor del bit leído (0 o 1).
  *
  * @code
  * unsigned int myData = 0xABCD; // Dato de ejemplo
  * unsigned char bit5 = bitRead(myData, 5); // Lee el bit 5 (sexto bit desde la derecha)
- * unsigned char bit15 = bitRead(myData, 15); // Lee el bit 15 (bit ms significativo)
+ * unsigned char bit15 = bitRead(myData, 15); // Lee el bit 15 (bit más significativo)
  * @endcode
  *
- * @remark Es importante asegurarse de que el valor de `numeroBit` est dentro del rango vlido (0-15) para evitar comportamientos indefinidos.
+ * @remark Es importante asegurarse de que el valor de `numeroBit` esté dentro del rango válido (0-15) para evitar comportamientos indefinidos.
  */
 unsigned char bitRead(unsigned int data, unsigned char numeroBit);
 
@@ -143,22 +221,22 @@ unsigned char bitRead(unsigned int data, unsigned char numeroBit);
  * @brief Escribe una secuencia de bits en un dispositivo externo utilizando un protocolo de desplazamiento.
  *
  * @param dato Dato de 16 bits que se va a escribir.
- * @param contador Nmero de bits que se van a escribir.
+ * @param contador Número de bits que se van a escribir.
  *
  * @pre Los pines SK (reloj) y DI (datos de entrada) deben estar configurados como salidas. `contador` debe estar dentro del rango de 1 a 16.
  *
- * @details Esta funcin escribe una secuencia de bits desde la variable `dato` al pin `DI`, sincronizada con la seal de reloj `SK`. El nmero de bits que se escriben est determinado por el parmetro `contador`. El proceso es el siguiente:
+ * @details Esta función escribe una secuencia de bits desde la variable `dato` al pin `DI`, sincronizada con la señal de reloj `SK`. El número de bits que se escriben está determinado por el parámetro `contador`. El proceso es el siguiente:
  *   1. Se itera mientras `contador` sea mayor que 0.
- *   2. En cada iteracin:
- *     a. Se espera 1 microsegundo.
- *     b. Se lee el bit correspondiente de `dato` usando la funcin `bitRead()` y se escribe en el pin `DI`. El bit que se lee est determinado por `(contador - 1)`.
- *     c. Se espera 1 microsegundo.
+ *   2. En cada iteración:
+ *     a. Se espera `M93LC66B_RETARDO_US` microsegundos (sin retardo si es 0).
+ *     b. Se lee el bit correspondiente de `dato` (lo mismo que `bitRead()`, sin llamarla) y se escribe en el pin `DI`. El bit que se lee está determinado por `(contador - 1)`.
+ *     c. Se espera `M93LC66B_RETARDO_US` microsegundos (sin retardo si es 0).
  *     d. Se genera un flanco de subida en `SK` (SK pasa a 1).
- *     e. Se espera 1 microsegundo.
+ *     e. Se espera `M93LC66B_RETARDO_US` microsegundos (sin retardo si es 0).
  *     f. Se genera un flanco de bajada en `SK` (SK pasa a 0).
- *     g. Se espera 1 microsegundo.
+ *     g. Se espera `M93LC66B_RETARDO_US` microsegundos (sin retardo si es 0).
  *     h. Se decrementa `contador`.
- *   3. Despus del bucle, se pone `DI` a 0.
+ *   3. Después del bucle, se pone `DI` a 0.
  *
  * @code
  * unsigned int dataToWrite = 0x1234;
@@ -166,77 +244,254 @@ unsigned char bitRead(unsigned int data, unsigned char numeroBit);
  * escribe(dataToWrite, 16); // Escribe los 16 bits de dataToWrite.
  * @endcode
  *
- * @note La precisin de los retardos depende de la frecuencia del oscilador del microcontrolador. Asegrese de que la macro `__delay_us()` est configurada correctamente para su configuracin de hardware.
+ * @note La precisión de los retardos depende de la frecuencia del oscilador del microcontrolador. Los retardos se ajustan con `M93LC66B_RETARDO_US`.
  *
- * @remark Es fundamental que el dispositivo externo est configurado para recibir datos con este mismo protocolo de desplazamiento. Consultar la hoja de datos del dispositivo externo para obtener informacin precisa sobre los tiempos y el protocolo de comunicacin. El ltimo paso de poner `DI` a 0 podra no ser necesario dependiendo del protocolo especfico del dispositivo.
+ * @remark Es fundamental que el dispositivo externo esté configurado para recibir datos con este mismo protocolo de desplazamiento. Consultar la hoja de datos del dispositivo externo para obtener información precisa sobre los tiempos y el protocolo de comunicación. El último paso de poner `DI` a 0 podría no ser necesario dependiendo del protocolo específico del dispositivo.
  */
 void escribe(unsigned int dato, unsigned char contador);
 /**
- * @brief Lee un rango de direcciones de la EEPROM 93LC66B de forma automtica.
+ * @brief Inicia una lectura en la EEPROM 93LC66B dejando el dispositivo listo para entregar palabras consecutivas.
+ *
+ * @param direccion Dirección de inicio de la lectura.
+ *
+ * @pre La EEPROM debe haber sido inicializada correctamente con la función `init_93lc66b()`.
+ *
+ * @details Si hay una lectura no bloqueante a la mitad (`pideLectura93LC66B()`), primero la interrumpe: la siguiente llamada a `pasoLectura93LC66B()` la vuelve a arrancar desde la palabra que le falta. Si la memoria está en un ciclo de escritura espera con `esperaListo93LC66B()` a que termine. Después genera la secuencia de inicio con `startBit()`, escribe el código de operación de lectura (2 bits), la dirección de la celda (`M93_BITS_DIRECCION` bits) y un pulso más para el bit ficticio que la memoria envía antes de los datos. A partir de este punto cada llamada a `leeMemoria()` entrega la siguiente palabra de 16 bits de la imagen, ya que la 93LC66B incrementa su apuntador interno mientras `CS` se mantenga en alto. La lectura se cierra con `terminaLectura93LC66B()`.
+ *
+ * @code
+ * iniciaLectura93LC66B(0x00);
+ * unsigned int cabecera = leeMemoria();
+ * unsigned int patrones = leeMemoria();
+ * terminaLectura93LC66B();
+ * @endcode
+ *
+ * @remark `direccion` es el desplazamiento en bytes dentro de la imagen `tabla_leds.bin` con cualquier modelo y organización. En x16 la celda es `direccion / 2`, así que una dirección impar empieza en la palabra que contiene ese byte; en x8 la celda es la propia dirección.
+ */
+void iniciaLectura93LC66B(unsigned int direccion);
+/**
+ * @brief Consulta en DO si la 93LC66B terminó su ciclo interno de escritura.
+ *
+ * @details Después de un comando de escritura o borrado la memoria indica su estado en DO al volver a seleccionarla: 0 mientras está ocupada y 1 cuando está lista. Esta función genera un pulso de selección, lee DO y deja `CS` en bajo, por lo que puede llamarse repetidamente en lugar de esperar el tiempo máximo de escritura de la hoja de datos.
+ *
+ * @return 1 si la memoria está lista o no había ninguna escritura pendiente, 0 si sigue ocupada.
+ *
+ * @code
+ * while (!listo93LC66B())
+ *     atiendeComandos();
+ * @endcode
+ */
+unsigned char listo93LC66B(void);
+/**
+ * @brief Indica sin esperar si sigue en curso un ciclo de escritura o borrado.
+ *
+ * @details Solo accede al bus si hay una escritura pendiente, y entonces consulta DO una vez con `listo93LC66B()`. Sirve para que una tarea ceda el procesador mientras la memoria termina, en lugar de bloquearse en `esperaListo93LC66B()`.
+ *
+ * @return 1 si la memoria sigue ocupada, 0 si está lista para el siguiente comando.
+ *
+ * @code
+ * if (ocupado93LC66B())
+ *     return; // Se reintenta en la siguiente ejecución de la tarea.
+ * @endcode
+ */
+unsigned char ocupado93LC66B(void);
+/**
+ * @brief Espera, consultando DO, a que termine el ciclo de escritura en curso.
+ *
+ * @details Si no hay ninguna escritura o borrado pendiente regresa de inmediato. En otro caso consulta DO como `listo93LC66B()` hasta que la memoria indique que está lista, de modo que cada escritura tarda lo que realmente tarda la memoria (unos 2 ms) en lugar del tiempo máximo de la hoja de datos. Todos los comandos del controlador la llaman antes de seleccionar la memoria, así que solo hace falta llamarla directamente para conocer el resultado de una escritura.
+ *
+ * @return 1 si la memoria terminó, 0 si no respondió después de `M93LC66B_CONSULTAS_MAX` consultas.
+ *
+ * @code
+ * escribe93LC66B(0x10, 0x1234);
+ * if (!esperaListo93LC66B()) {
+ *     // La memoria no terminó la escritura.
+ * }
+ * @endcode
+ */
+unsigned char esperaListo93LC66B(void);
+/**
+ * @brief Habilita la escritura en la 93LC66B (comando EWEN).
+ *
+ * @details Al encenderse la memoria rechaza todos los comandos de escritura y borrado hasta recibir EWEN; la habilitación dura hasta que se recibe EWDS (`protegeEscritura93LC66B()`) o se quita la alimentación.
+ *
+ * @code
+ * habilitaEscritura93LC66B();
+ * escribe93LC66B(0x00, 0x4D46);
+ * protegeEscritura93LC66B();
+ * @endcode
+ */
+void habilitaEscritura93LC66B(void);
+/**
+ * @brief Vuelve a proteger la 93LC66B contra escrituras (comando EWDS).
+ *
+ * @remark Conviene llamarla al terminar de programar, para que el ruido en los pines al apagar o al arrancar no pueda modificar la fuente.
+ */
+void protegeEscritura93LC66B(void);
+/**
+ * @brief Escribe una palabra de 16 bits en la 93LC66B (comando WRITE).
+ *
+ * @param direccion Dirección de la palabra (misma convención que `lee93LC66B()`: desplazamiento en bytes, par).
+ * @param dato Palabra que se graba.
+ *
+ * @pre La escritura debe estar habilitada con `habilitaEscritura93LC66B()`.
+ *
+ * @details Envía el comando y el dato y regresa sin esperar: la memoria borra y graba la palabra por sí sola mientras el programa continúa. El siguiente comando, o `esperaListo93LC66B()`, espera a que el ciclo interno termine. En x8 se escriben los dos bytes (LSB en `direccion`) con dos comandos, y el segundo espera al primero.
+ *
+ * @code
+ * escribe93LC66B(0x04, 386);
+ * @endcode
+ */
+void escribe93LC66B(unsigned int direccion, unsigned int dato);
+/**
+ * @brief Borra una palabra de la 93LC66B (comando ERASE); la palabra queda en 0xFFFF.
+ *
+ * @param direccion Dirección de la palabra (desplazamiento en bytes, par).
+ *
+ * @pre La escritura debe estar habilitada con `habilitaEscritura93LC66B()`.
+ *
+ * @remark No hace falta borrar antes de `escribe93LC66B()`: la 93LC66B borra la palabra automáticamente al escribirla. En x8 se borran los dos bytes de la palabra.
+ */
+void borra93LC66B(unsigned int direccion);
+/**
+ * @brief Escribe el mismo valor en todas las palabras de la 93LC66B (comando WRAL).
+ *
+ * @param dato Palabra que se graba en toda la memoria; en x8 solo se usa el byte bajo.
+ *
+ * @pre La escritura debe estar habilitada con `habilitaEscritura93LC66B()`.
+ */
+void escribeTodo93LC66B(unsigned int dato);
+/**
+ * @brief Borra toda la 93LC66B (comando ERAL); todas las palabras quedan en 0xFFFF.
+ *
+ * @pre La escritura debe estar habilitada con `habilitaEscritura93LC66B()`.
+ */
+void borraTodo93LC66B(void);
+/**
+ * @brief Graba un bloque de una imagen `tabla_leds.bin` y verifica cada palabra.
+ *
+ * @param inicio Dirección de la primera palabra (desplazamiento en bytes dentro de la imagen, par).
+ * @param imagen Bytes de la imagen a partir de `inicio`, con las palabras LSB primero, igual que en `tabla_leds.bin`.
+ * @param cantidad Número de palabras de 16 bits a grabar (1 a 254).
+ *
+ * @pre La EEPROM debe haber sido inicializada con `init_93lc66b()`.
+ *
+ * @details Habilita la escritura, y para cada palabra lee primero el valor actual: si ya es igual se salta, y si no se escribe, se espera el fin del ciclo con `esperaListo93LC66B()` y se vuelve a leer para comprobarla. Al terminar, o al primer error, vuelve a proteger la memoria. Saltar las palabras que no cambian hace que regrabar una fuente con pocas diferencias tarde solo lo que cuesta leerla.
+ *
+ * @return Número de palabras que se escribieron, o `M93_ERROR_PROGRAMA` si alguna no terminó su ciclo o no se leyó igual después de grabarla.
+ *
+ * @code
+ * if (programaImagen93LC66B(0x08, bloque, 4) == M93_ERROR_PROGRAMA) {
+ *     // Memoria protegida, dañada o desconectada.
+ * }
+ * @endcode
+ *
+ * @note El índice de la fuente en RAM no se actualiza; después de grabar la imagen completa se vuelve a cargar con `init_matrizLed()`.
+ */
+unsigned char programaImagen93LC66B(unsigned int inicio, const uint8_t *imagen, unsigned char cantidad);
+/**
+ * @brief Programa una lectura secuencial que se realiza paso a paso con `pasoLectura93LC66B()`.
  *
- * @param inicio Direccin de inicio de la lectura.
- * @param alcance Direccin final de la lectura.
+ * @param inicio Dirección de inicio de la lectura (misma convención que `lee93LC66B()`).
+ * @param destino Arreglo donde se guardan las palabras; debe seguir siendo válido hasta que la lectura termine.
+ * @param cantidad Número de palabras de 16 bits a leer.
  *
- * @pre Los pines CS, SK y DO deben estar configurados correctamente. La EEPROM debe haber sido inicializada correctamente con la funcin `init_93lc66b()`. `OPcode_Lectura` debe estar definido con el cdigo de operacin correcto para la lectura. `inicio` y `alcance` deben ser direcciones vlidas dentro del rango de la EEPROM. `alcance` debe ser mayor o igual a `inicio`.
+ * @pre La EEPROM debe haber sido inicializada con `init_93lc66b()`.
  *
- * @details Esta funcin lee un rango de direcciones consecutivas de la EEPROM 93LC66B. El proceso es el siguiente:
- *   1. Se inicializa la variable `direccion` con el valor de `inicio`.
- *   2. Se genera la secuencia de inicio con `startBit()`.
- *   3. Se escribe el cdigo de operacin de lectura (`OPcode_Lectura`) con `escribe()`. Se escriben 2 bits para el cdigo de operacin.
- *   4. Se escribe la direccin de inicio (`direccion`) con `escribe()`. Se escriben 9 bits para la direccin.
- *   5. Se verifica si `alcance` es mayor que `direccion`.
- *   6. Si `alcance` es mayor que `direccion` (lectura de un rango):
- *     a. Se entra en un bucle `while` que se ejecuta mientras `direccion` sea menor o igual a `alcance`.
- *     b. Dentro del bucle:
- *       i. Se lee el dato de la direccin actual con `leeMemoria()` y se guarda en `Buf`.
- *       ii. Se espera 10 milisegundos.
- *       iii. Se asegura que `SK` est en bajo.
- *       iv. Se espera 1 microsegundo.
- *       v. Se pone `DI` a 0.
- *       vi. Se incrementa `direccion`.
- *   7. Si `alcance` no es mayor que `direccion` (lectura de una sola direccin, lo cual es un caso que no debera ocurrir dado que se espera que alcance sea mayor o igual a inicio):
- *      a. Se lee el dato de la direccin actual con `leeMemoria()` y se guarda en `Buf`.
- *      b. Se espera 10 milisegundos.
- *      c. Se asegura que `SK` est en bajo.
- *      d. Se espera 1 microsegundo.
- *      e. Se pone `DI` a 0.
+ * @details No accede al bus: solo guarda los parámetros; con `cantidad` 0 la lectura queda lista de inmediato. Si otra lectura no bloqueante seguía en curso, primero la termina.
  *
  * @code
- * leeAutomatico(0x00, 0x0F); // Lee desde la direccin 0x00 hasta la 0x0F.
+ * unsigned int palabras[4];
+ * pideLectura93LC66B(0x20, palabras, 4);
+ * while (pasoLectura93LC66B()) {
+ *     atiendeComandos(); // Otro trabajo entre pasos.
+ * }
  * @endcode
+ */
+void pideLectura93LC66B(unsigned int inicio, unsigned int *destino, unsigned char cantidad);
+/**
+ * @brief Avanza un paso la lectura programada con `pideLectura93LC66B()`.
  *
- * @note La precisin de los retardos depende de la frecuencia del oscilador del microcontrolador. Asegrese de que las macros `__delay_ms()` y `__delay_us()` estn configuradas correctamente para su configuracin de hardware. `Buf` debe ser una variable global o accesible dentro del mbito de esta funcin.
+ * @details Cada llamada hace una sola de estas etapas y regresa: consultar una vez si la memoria está lista (`M93_ESPERA_LISTO`, solo si hay un ciclo de escritura en curso), enviar el bit de inicio, el código de operación y la dirección (`M93_ARRANQUE`), o leer una palabra (`M93_PALABRAS`). Al leer la última palabra cierra la transacción y `lecturaLista93LC66B()` empieza a regresar 1. Cada paso dura a lo sumo el tiempo de 16 pulsos de reloj, por lo que puede llamarse desde el ciclo principal sin detener la atención de comandos.
  *
- * @remark Es fundamental que el valor de `alcance` sea mayor o igual a `inicio`. De lo contrario, el comportamiento no ser el esperado. Consultar la hoja de datos de la 93LC66B para obtener informacin precisa sobre el protocolo de comunicacin completo. El cdigo asume que la EEPROM est configurada para palabras de 16 bits.
+ * @return 1 si la lectura sigue en curso, 0 si terminó o no había ninguna.
+ *
+ * @remark Las funciones bloqueantes (`iniciaLectura93LC66B()`, `leeAutomatico()`, `lee93LC66B()`) y las escrituras interrumpen la lectura pendiente en lugar de terminarla, sin llamar a esta función: el siguiente paso la vuelve a arrancar en `direccion` más las palabras ya leídas (y tras una escritura espera primero a que la memoria esté lista). Así pueden mezclarse con la versión no bloqueante sin corromper ninguna de las dos y sin sumar niveles a la pila de hardware.
+ */
+unsigned char pasoLectura93LC66B(void);
+/**
+ * @brief Indica si terminó la última lectura programada con `pideLectura93LC66B()`.
+ *
+ * @return 1 si las palabras ya están en el destino (o no se ha pedido ninguna lectura), 0 si la lectura sigue en curso.
+ */
+unsigned char lecturaLista93LC66B(void);
+/**
+ * @brief Termina una lectura iniciada con `iniciaLectura93LC66B()`.
+ *
+ * @details Pone `SK` y `DI` en bajo y deselecciona la memoria (`CS` = 0), con lo que la 93LC66B abandona la lectura secuencial y vuelve a esperar un bit de inicio.
+ *
+ * @code
+ * terminaLectura93LC66B();
+ * @endcode
+ */
+void terminaLectura93LC66B(void);
+/**
+ * @brief Lee un bloque de palabras consecutivas de la EEPROM 93LC66B con un solo comando de lectura.
+ *
+ * @param inicio Dirección de inicio de la lectura (misma convención que `lee93LC66B()`).
+ * @param destino Arreglo proporcionado por quien llama donde se guardan las palabras leídas.
+ * @param cantidad Número de palabras de 16 bits a leer.
+ *
+ * @pre La EEPROM debe haber sido inicializada correctamente con la función `init_93lc66b()`. `destino` debe tener espacio para al menos `cantidad` palabras.
+ *
+ * @details Esta función aprovecha la lectura secuencial de la 93LC66B: envía una sola vez el bit de inicio, el código de operación y la dirección, y después obtiene `cantidad` palabras seguidas con `leeMemoria()`, sin retardos entre ellas. Cada palabra adicional cuesta únicamente los 16 pulsos de reloj de `shiftIn16()`, en lugar de una transacción completa como ocurre al llamar `lee93LC66B()` en un ciclo.
+ *
+ * @code
+ * unsigned int glifo[5];
+ * leeAutomatico(10, glifo, 5); // Lee la cabecera y los patrones del segundo carácter.
+ * @endcode
+ *
+ * @remark Si `cantidad` es 0 no se realiza ninguna transacción. La lectura secuencial continúa de forma circular al llegar a la última dirección de la memoria.
+ */
+void leeAutomatico(unsigned int inicio, unsigned int *destino, unsigned char cantidad);
+/**
+ * @brief Lee un bloque de bytes consecutivos de la imagen con un solo comando de lectura.
+ *
+ * @param inicio Desplazamiento en bytes del primer byte; puede ser impar.
+ * @param destino Arreglo donde se guardan los bytes.
+ * @param cantidad Número de bytes a leer.
+ *
+ * @pre La EEPROM debe haber sido inicializada con `init_93lc66b()`.
+ *
+ * @details En x8 cada byte es una celda y se lee directamente con `shiftIn8()`, sin separar palabras. En x16 se leen las palabras necesarias y se copian sus bytes en orden, descartando el byte bajo de la primera si `inicio` es impar. Sirve para leer los patrones de un glifo directamente como columnas.
+ *
+ * @code
+ * uint8_t columnas[5];
+ * leeBytes93LC66B(0x9C, columnas, 5);
+ * @endcode
  */
-void leeAutomatico(unsigned int inicio, int alcance);
+void leeBytes93LC66B(unsigned int inicio, uint8_t *destino, unsigned char cantidad);
 /**
- * @brief Lee una palabra de 16 bits desde una direccin especfica de la EEPROM 93LC66B.
+ * @brief Lee una palabra de 16 bits desde una dirección específica de la EEPROM 93LC66B.
  *
- * @param direccion Direccin de memoria de la EEPROM desde la que se leer la palabra.
+ * @param direccion Dirección de memoria de la EEPROM desde la que se leerá la palabra.
  *
- * @pre Los pines CS, SK y DO deben estar configurados correctamente. La EEPROM debe haber sido inicializada correctamente con la funcin `init_93lc66b()`. `OPcode_Lectura` debe estar definido con el cdigo de operacin correcto para la lectura. `direccion` debe ser una direccin vlida dentro del rango de la EEPROM.
+ * @pre Los pines CS, SK y DO deben estar configurados correctamente. La EEPROM debe haber sido inicializada correctamente con la función `init_93lc66b()`. `OPcode_Lectura` debe estar definido con el código de operación correcto para la lectura. `direccion` debe ser una dirección válida dentro del rango de la EEPROM.
  *
- * @details Esta funcin realiza una lectura de una palabra de 16 bits desde una direccin especfica de la EEPROM 93LC66B. El proceso es el siguiente:
- *   1. Se genera la secuencia de inicio con `startBit()`.
- *   2. Se escribe el cdigo de operacin de lectura (`OPcode_Lectura`) utilizando la funcin `escribe()`. Se escriben 2 bits para el cdigo de operacin.
- *   3. Se escribe la direccin de memoria (`direccion`) utilizando la funcin `escribe()`. Se escriben 9 bits para la direccin.
- *   4. Se leen los datos de la EEPROM utilizando la funcin `leeMemoria()` y se guardan en la variable `data`.
- *   5. Se espera 10 milisegundos.
- *   6. Se asegura que el pin `SK` est en bajo.
- *   7. Se espera 1 microsegundo.
- *   8. Se pone el pin `DI` a bajo.
- *   9. Se retorna el valor ledo (`data`).
+ * @details Esta función realiza una lectura de una palabra de 16 bits desde una dirección específica de la EEPROM 93LC66B. El proceso es el siguiente:
+ *   1. Se inicia la lectura con `iniciaLectura93LC66B()` (bit de inicio, código de operación y dirección).
+ *   2. Se leen los datos de la EEPROM utilizando la función `leeMemoria()` y se guardan en la variable `data`.
+ *   3. Se termina la lectura con `terminaLectura93LC66B()`.
+ *   4. Se retorna el valor leído (`data`).
  *
- * @return Un valor entero sin signo de 16 bits (`unsigned int`) que contiene la palabra leda desde la EEPROM.
+ * @return Un valor entero sin signo de 16 bits (`unsigned int`) que contiene la palabra leída desde la EEPROM.
  *
  * @code
- * unsigned int dataRead = lee93LC66B(0x0A); // Lee la palabra en la direccin 0x0A.
+ * unsigned int dataRead = lee93LC66B(0x0A); // Lee la palabra en la dirección 0x0A.
  * @endcode
  *
- * @note La precisin de los retardos depende de la frecuencia del oscilador del microcontrolador. Asegrese de que las macros `__delay_ms()` y `__delay_us()` estn configuradas correctamente para su configuracin de hardware.
+ * @note La lectura no requiere tiempo de espera al terminar: el retardo de 10 ms que se usaba aquí solo es necesario después de los ciclos de escritura. Para leer varias palabras consecutivas conviene usar `leeAutomatico()`.
  *
- * @remark Consultar la hoja de datos de la 93LC66B para obtener informacin precisa sobre el protocolo de comunicacin completo, incluyendo los tiempos de acceso y los cdigos de operacin. El cdigo asume que la EEPROM est configurada para palabras de 16 bits.
+ * @remark Consultar la hoja de datos de la 93LC66B para obtener información precisa sobre el protocolo de comunicación completo, incluyendo los tiempos de acceso y los códigos de operación. El código asume que la EEPROM está configurada para palabras de 16 bits.
  */
 unsigned int lee93LC66B(unsigned int direccion);
 
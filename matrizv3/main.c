@@ -14,34 +14,76 @@
 #pragma config CP = OFF         // Flash Program Memory Code Protection bit (Code protection off)
 
 #include <xc.h>
+#ifndef _XTAL_FREQ
 #define _XTAL_FREQ 4000000
+#endif
 
 #include "h595.h"
 #include "m93lc66b.h"
 #include "rs232.h"
 #include "matrizLed.h"
+#include "cacheGlifos.h"
+#include "pantalla.h"
+#include "marquesina.h"
+#include "comandos.h"
+#include "timer1.h"
+#include "tareas.h"
+
+#define VELOCIDAD_MARQUESINA 20 //columnas por segundo
+#define PERIODO_LATIDO 250      //ms entre cambios del LED
+
+static void latido(void)
+{
+    LED = !LED;
+}
+
+//Tareas del ciclo principal, en orden de prioridad. Los presupuestos (en us)
+//son el tiempo que cada una puede tardar sin retrasar a las demas; peorTarea()
+//y el comando 'T' muestran cuanto tardan en realidad.
+const Tarea tareasPrincipales[] = {
+    { atiendeComandos, 1, 5000 },
+    { actualizaMarquesina, 1, 2000 },
+    { pasoCacheGlifos, 1, 200 },
+    { latido, PERIODO_LATIDO, 50 },
+};
+const uint8_t numTareasPrincipales = sizeof(tareasPrincipales) / sizeof(tareasPrincipales[0]);
+
+void __interrupt() isr(void)
+{
+    if (INTCONbits.T0IE && INTCONbits.T0IF)
+        refrescaPantalla();
+    if (PIE1bits.TXIE && PIR1bits.TXIF)
+        atiendeTxRS232();
+    if (PIE1bits.RCIE && PIR1bits.RCIF)
+        procesaByteComando(recibeRS232());
+}
 
 void main(void) {
     
-    PCONbits.OSCF = 1; // IMPORTANTE! Establecer OSCF para 4MHz
+    PCONbits.OSCF = 1; // ¡IMPORTANTE! Establecer OSCF para 4MHz
     
     TRISB = 0x00;
     init_93lc66b();
     init_rs232();
+    init_comandos();
+    init_timer1();
+#if RS232_AUTOBAUDIOS
+    autobaudiosRS232(RS232_AUTOBAUDIOS_MS);
+#endif
     
     LED = 1;
     //Condiciones de inicio
     CS = 0;
     DI = 0;
     SK = 0;
+    init_matrizLed();
+    init_pantalla();
     //printCad("Iniciando test de comunicacion\r\n");
     
+    iniciaMarquesina("MONTY 2025 ", VELOCIDAD_MARQUESINA);
+    init_tareas(tareasPrincipales, numTareasPrincipales);
     while(1){
-        printCad93LC66B("MONTY");
-        __delay_ms(500);
-        printCad93LC66B("2025");
-        __delay_ms(500);
-        
+        despachaTareas();
     }
     
     
@@ -0,0 +1,119 @@
+#include "marquesina.h"
+
+#define MASCARA_TIRA (TIRA_COLUMNAS - 1)
+
+static uint8_t *tira;               //RAM de los buffers de cuadro
+static const char *mensaje;
+static uint8_t posicion = 0;        //siguiente caracter del mensaje
+static uint8_t escritura = 0;       //siguiente columna a escribir en la tira
+static uint8_t longitudMensaje = 0; //columnas de una vuelta completa
+static uint8_t columnasVuelta = 0;  //columnas escritas en la vuelta actual
+static uint8_t velocidad = 0;       //columnas por segundo
+//El mensaje completo esta en la tira: se necesitan la vuelta completa y la
+//ventana de todos los paneles
+#define COMPLETO() (longitudMensaje != 0 && longitudMensaje <= TIRA_COLUMNAS - FILAS_PANTALLA)
+//Caracter en curso: su glifo (0: en blanco), su ancho con la separacion y la
+//siguiente columna por agregar
+#define CARACTER_PIDE 0             //falta pedir el glifo
+#define CARACTER_CARGA 1            //el glifo esta en carga no bloqueante
+#define CARACTER_COLUMNAS 2         //se estan agregando sus columnas
+static uint8_t caracter = CARACTER_PIDE;
+static const uint8_t *dibujo;
+static uint8_t anchoCaracter;
+static uint8_t columna;
+
+//Las columnas se escriben directo en la tira, sin un arreglo intermedio en
+//la pila compilada
+#define AGREGA_COLUMNA(c) do { tira[escritura & MASCARA_TIRA] = (c); escritura++; } while (0)
+
+void iniciaMarquesina(const char *cad, uint8_t pxPorSegundo)
+{
+    uint8_t k;
+    tira = tiraPantalla();
+    for (k = 0; k < TIRA_COLUMNAS; k++)
+        tira[k] = 0;
+    mensaje = cad;
+    posicion = 0;
+    escritura = 0;
+    longitudMensaje = 0;
+    columnasVuelta = 0;
+    velocidad = pxPorSegundo;
+    caracter = CARACTER_PIDE;
+    cancelaGlifo();
+    //Sin mensaje la ventana no avanza: cada avance contaria como una parada
+    ventanaPantalla(tira, MASCARA_TIRA, cad[0] != 0 ? pxPorSegundo : 0);
+}
+
+void cambiaMensajeMarquesina(const char *cad)
+{
+    iniciaMarquesina(cad, velocidad);
+}
+
+void redibujaMarquesina(void)
+{
+    if (mensaje != 0)
+        iniciaMarquesina(mensaje, velocidad);
+}
+
+void cambiaVelocidadMarquesina(uint8_t pxPorSegundo)
+{
+    velocidad = pxPorSegundo;
+    if (mensaje != 0 && mensaje[0] != 0)
+        velocidadPantalla(pxPorSegundo);
+}
+
+void actualizaMarquesina(void)
+{
+    if (mensaje == 0 || mensaje[0] == 0)
+        return;
+    //La ventana nueva de iniciaMarquesina() reinicia el limite al aplicarse
+    if (cambioPendientePantalla())
+        return;
+    //Espacio libre: columnas que la ventana ya no va a mostrar
+    while ((uint8_t)(escritura - desplazamientoVentana()) < TIRA_COLUMNAS)
+    {
+        if (COMPLETO())
+        {
+            //Copia de la vuelta anterior, sin acceso a la EEPROM; la columna
+            //de origen siempre se escribio antes que la de destino
+            AGREGA_COLUMNA(tira[(uint8_t)(escritura - longitudMensaje) & MASCARA_TIRA]);
+        }
+        else
+        {
+            if (caracter != CARACTER_COLUMNAS)
+            {
+                //Carga no bloqueante: un paso por llamada, las columnas se
+                //agregan cuando el glifo esta completo
+                dibujo = 0;
+                anchoCaracter = ANCHO_SIN_GLIFO;
+                if (caracter == CARACTER_PIDE && pideGlifo(mensaje[posicion]))
+                    caracter = CARACTER_CARGA;
+                if (caracter == CARACTER_CARGA)
+                {
+                    dibujo = glifoListo(&anchoCaracter);
+                    if (dibujo == 0)
+                        return;
+                }
+                anchoCaracter += SEPARACION_GLIFOS;
+                columna = 0;
+                caracter = CARACTER_COLUMNAS;
+            }
+            AGREGA_COLUMNA((dibujo != 0 && columna < anchoCaracter - SEPARACION_GLIFOS) ? dibujo[columna] : 0);
+            columna++;
+            if (columna == anchoCaracter)
+            {
+                caracter = CARACTER_PIDE;
+                posicion++;
+                columnasVuelta += anchoCaracter;
+                if (mensaje[posicion] == 0)
+                {
+                    posicion = 0;
+                    if (longitudMensaje == 0)
+                        longitudMensaje = columnasVuelta;
+                    columnasVuelta = 0;
+                }
+            }
+        }
+        limiteVentana(escritura - FILAS_PANTALLA);
+    }
+}
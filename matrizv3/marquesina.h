@@ -0,0 +1,91 @@
+/* 
+ * File:   marquesina.h
+ * Author: 
+ * Comments: Desplazamiento horizontal de mensajes sobre la matriz de LEDs
+ * Revision history: 
+ */
+
+// This is a guard condition so that contents of this file are not included
+// more than once.  
+#ifndef MARQUESINA_H
+#define	MARQUESINA_H
+
+#include <xc.h> // include processor files - each processor file is guarded.  
+#include <stdint.h>
+#include "matrizLed.h"
+#include "pantalla.h"
+
+//Columnas de la tira circular (potencia de 2), que ocupa la RAM de los
+//buffers de cuadro (tiraPantalla()). Los mensajes que caben completos en la
+//tira se leen de la EEPROM una sola vez; los mas largos se van leyendo de la
+//EEPROM conforme avanza la ventana. Las columnas se agregan de una en una,
+//asi que basta con la ventana de todos los paneles mas una columna.
+#if FILAS_PANTALLA < 16
+#define TIRA_COLUMNAS 16
+#elif FILAS_PANTALLA < 32
+#define TIRA_COLUMNAS 32
+#elif FILAS_PANTALLA < 64
+#define TIRA_COLUMNAS 64
+#else
+#define TIRA_COLUMNAS 128
+#endif
+#if TIRA_COLUMNAS > PANTALLA_BYTES_TIRA
+#error "La tira de la marquesina no cabe en los buffers de cuadro"
+#endif
+
+/**
+ * @brief Inicia la marquesina con un mensaje que se desplaza de derecha a izquierda de forma continua.
+ *
+ * @param cad Mensaje terminado en nulo. Debe permanecer válido mientras se muestre (por ejemplo, una constante o un buffer global).
+ * @param pxPorSegundo Velocidad de desplazamiento en columnas por segundo.
+ *
+ * @pre `init_matrizLed()` e `init_pantalla()` deben haberse llamado previamente.
+ *
+ * @details Reinicia la tira (la RAM de los buffers de cuadro, que dejan de mostrarse) y cambia el origen de la pantalla a la ventana de `FILAS_PANTALLA` columnas (todos los paneles) sobre la tira (`ventanaPantalla()`), que la interrupción aplica al comenzar el siguiente cuadro. No llena la tira: eso lo hace la siguiente llamada a `actualizaMarquesina()`, de modo que cambiar el mensaje desde un comando no suma a la pila de hardware los niveles de la carga de glifos (mientras tanto la ventana está en blanco y detenida en el límite). Cada carácter ocupa su ancho real más `SEPARACION_GLIFOS` columnas en blanco; los que no están en la tabla se muestran como `ANCHO_SIN_GLIFO` columnas en blanco.
+ *
+ * @code
+ * iniciaMarquesina("MONTY 2025 ", 20);
+ * while (1) {
+ *     actualizaMarquesina();
+ * }
+ * @endcode
+ */
+void iniciaMarquesina(const char *cad, uint8_t pxPorSegundo);
+/**
+ * @brief Reinicia la marquesina con otro mensaje, conservando la velocidad actual.
+ *
+ * @param cad Mensaje terminado en nulo. Debe permanecer válido mientras se muestre.
+ *
+ * @code
+ * cambiaMensajeMarquesina(buffer);
+ * @endcode
+ */
+void cambiaMensajeMarquesina(const char *cad);
+/**
+ * @brief Cambia la velocidad de la marquesina sin reiniciar el mensaje.
+ *
+ * @param pxPorSegundo Velocidad de desplazamiento en columnas por segundo; 0 detiene el mensaje.
+ *
+ * @details Con el mensaje vacío la ventana queda detenida y la velocidad se aplica con el siguiente mensaje.
+ */
+void cambiaVelocidadMarquesina(uint8_t pxPorSegundo);
+/**
+ * @brief Vuelve a dibujar el mensaje actual desde el principio, con la misma velocidad.
+ *
+ * @details Descarta las columnas ya dibujadas en la tira y la carga de glifo en curso. Se llama después de recargar la fuente con `init_matrizLed()`, porque esas columnas y las direcciones del glifo pendiente corresponden a la imagen anterior.
+ */
+void redibujaMarquesina(void);
+/**
+ * @brief Rellena la tira de la marquesina conforme la ventana la va consumiendo.
+ *
+ * @details Mientras haya en la tira columnas que la ventana ya dejó atrás, agrega en ellas las columnas del mensaje, de una en una (cada carácter con su ancho real y su separación), y actualiza el límite de la ventana. Mientras la ventana pedida por `iniciaMarquesina()` no se aplica (`cambioPendientePantalla()`) regresa sin hacer nada, porque al aplicarse la ventana el límite vuelve a 0. La primera vuelta del mensaje se lee de la EEPROM sin bloquear con `pideGlifo()` y `glifoListo()`: cada llamada avanza un paso de la lectura y regresa, y las columnas del carácter se empiezan a agregar en la llamada en que su glifo queda completo (se toman del glifo cargado, que no cambia hasta pedir el siguiente); si el mensaje completo cabe en la tira, las vueltas siguientes se copian de las columnas ya dibujadas. El desplazamiento en sí lo realiza la interrupción de refresco, por lo que esta función no necesita llamarse en cada cuadro.
+ *
+ * @code
+ * actualizaMarquesina(); // Llamar periódicamente desde el ciclo principal.
+ * @endcode
+ *
+ * @remark Si no se llama con la frecuencia suficiente, la ventana se detiene al llegar a la última columna dibujada en lugar de mostrar datos viejos.
+ */
+void actualizaMarquesina(void);
+
+#endif	/* XC_HEADER_TEMPLATE_H */
@@ -1,88 +1,354 @@
 #include "matrizLed.h"
-//
-unsigned int buscaDirEEPROM(char dat)
+#include "cacheGlifos.h"
+
+static unsigned char indiceCaracter[INDICE_MAX]; //primeros caracteres del indice de la imagen
+static unsigned char indiceLongitud = 0;
+static unsigned char fuenteGlifos = 0;  //glifos de la imagen, 0 si no es valida
+static uint16_t fuenteSuma = 0;        //suma de verificacion de la cabecera
+//Carga no bloqueante de un glifo (pideGlifo()): primero la entrada del indice
+//y luego los patrones, que se separan en bytes sobre las mismas palabras. Una
+//palabra extra porque los patrones pueden empezar en direccion impar. La
+//cabecera de la imagen se lee en el mismo lugar: al recargar el indice el
+//glifo en curso ya no sirve (redibujaMarquesina() lo descarta).
+static union {
+    unsigned int palabras[ANCHO_MAX_GLIFO / 2 + 1];
+    uint8_t columnas[ANCHO_MAX_GLIFO + 2];
+    unsigned int cabecera[FUENTE_PALABRAS_CABECERA];
+} glifo;
+static unsigned char estadoGlifo = GLIFO_LIBRE;
+static unsigned char anchoGlifo;
+static unsigned char mascaraGlifo;
+static char caracterGlifo;
+
+//Columnas guardadas en la EEPROM: las que no repiten la anterior
+static unsigned char literalesGlifo(unsigned char mascara, unsigned char ancho)
+{
+    unsigned char j, n = ancho;
+    
+    for (j = 0; j < ancho; j++)
+    {
+        if (mascara & 1)
+            n--;
+        mascara >>= 1;
+    }
+    return n;
+}
+
+//Expande en el mismo arreglo las columnas guardadas (al inicio de columnas[])
+//a las ancho columnas del glifo. Se recorre de la ultima a la primera: la
+//columna j nunca queda antes del byte guardado que le corresponde, asi que no
+//se pisa ninguno que falte por leer. Una columna repetida toma el ultimo byte
+//guardado anterior a ella.
+static void expandeGlifo(uint8_t *columnas, unsigned char mascara,
+                         unsigned char ancho, unsigned char literales)
 {
-    unsigned int memoria;
-    unsigned char caracter;
+    unsigned char j = ancho;
     
-    unsigned char DatosAlmacenados = NUM_OF_CHARACTERS;
-    for(unsigned char i = 0; i < DatosAlmacenados;i++)
+    while (j > 0)
     {
-        //printCad("\nDirBuscada: "); enviaHexByte(10*i); 
-         memoria = lee93LC66B(10*i);
-         caracter = memoria & 0x00FF;
-         //printCad("--- mem:");enviaHexByte(caracter); printCad("\n");
-         if((dat - caracter) == 0)
-             return (10*i);
+        j--;
+        if ((mascara >> j) & 1)
+            columnas[j] = (literales != 0) ? columnas[literales - 1] : 0;
+        else
+            columnas[j] = columnas[--literales];
     }
-    return 5;
+}
+
+//Lee la imagen completa con una sola lectura secuencial: valida la cabecera,
+//copia a RAM los caracteres del indice y comprueba la suma de verificacion.
+//Quien la llama registra despues la fuente con fuenteCacheGlifos(), para que
+//esa llamada no se sume a la pila compilada de la lectura.
+static void cargaIndice(void)
+{
+    unsigned int palabra, dir, finIndice;
+    uint16_t suma = 0;
+    unsigned char k;
+    
+    indiceLongitud = 0;
+    fuenteGlifos = 0;
+    fuenteSuma = 0;
+    iniciaLectura93LC66B(0);
+    for (k = 0; k < FUENTE_PALABRAS_CABECERA; k++)
+        glifo.cabecera[k] = leeMemoria();
+    finIndice = FUENTE_DIR_INDICE + FUENTE_BYTES_ENTRADA * (glifo.cabecera[1] & 0x00FF);
+    if (glifo.cabecera[0] != FUENTE_FIRMA || (glifo.cabecera[1] >> 8) != FUENTE_VERSION ||
+        glifo.cabecera[2] > FUENTE_LONGITUD_MAX || glifo.cabecera[2] < finIndice)
+    {
+        terminaLectura93LC66B();
+        return;
+    }
+    for (dir = FUENTE_DIR_INDICE; dir < glifo.cabecera[2]; dir += 2)
+    {
+        palabra = leeMemoria();
+        suma += palabra;
+        //Primera palabra de cada entrada: caracter (LSB) y ancho (MSB)
+        if (dir < finIndice && ((dir - FUENTE_DIR_INDICE) & (FUENTE_BYTES_ENTRADA - 1)) == 0)
+        {
+            k = (dir - FUENTE_DIR_INDICE) / FUENTE_BYTES_ENTRADA;
+            if (k < INDICE_MAX)
+                indiceCaracter[indiceLongitud++] = palabra & 0x00FF;
+            indiceCacheGlifos(k, palabra & 0x00FF);
+        }
+    }
+    terminaLectura93LC66B();
+    if (suma != glifo.cabecera[3])
+    {
+        indiceLongitud = 0;
+        return;
+    }
+    fuenteGlifos = glifo.cabecera[1] & 0x00FF;
+    fuenteSuma = suma;
+}
+
+void init_matrizLed(void)
+{
+    cargaIndice();
+    fuenteCacheGlifos(fuenteGlifos, fuenteSuma);
+}
+
+unsigned char revisaIndiceEEPROM(void)
+{
+    leeAutomatico(0, glifo.cabecera, FUENTE_PALABRAS_CABECERA);
+    if (fuenteGlifos != 0 && glifo.cabecera[0] == FUENTE_FIRMA &&
+        (glifo.cabecera[1] & 0x00FF) == fuenteGlifos && glifo.cabecera[3] == fuenteSuma)
+        return 0;
+    cargaIndice();
+    fuenteCacheGlifos(fuenteGlifos, fuenteSuma);
+    return 1;
+}
+
+unsigned char glifosFuente(void)
+{
+    return fuenteGlifos;
+}
+
+unsigned int buscaDirEEPROM(unsigned char caracter)
+{
+    unsigned char bajo = 0, alto = indiceLongitud, medio, leido;
+    
+    //Los caracteres que no caben en RAM siguen ordenados en la EEPROM
+    //interna (y en la 93LC66B los que tampoco caben ahi)
+    if (indiceLongitud != 0 && caracter > indiceCaracter[indiceLongitud - 1])
+    {
+        bajo = indiceLongitud;
+        alto = fuenteGlifos;
+        while (bajo < alto)
+        {
+            medio = (bajo + alto) >> 1;
+            leido = caracterIndiceCacheGlifos(medio);
+            if (leido == 0)
+                leido = lee93LC66B(FUENTE_DIR_INDICE + FUENTE_BYTES_ENTRADA * medio) & 0x00FF;
+            if (leido == caracter)
+                return FUENTE_DIR_INDICE + FUENTE_BYTES_ENTRADA * medio;
+            if (leido < caracter)
+                bajo = medio + 1;
+            else
+                alto = medio;
+        }
+        return DIR_NO_ENCONTRADA;
+    }
+    while (bajo < alto)
+    {
+        medio = (bajo + alto) >> 1;
+        if (indiceCaracter[medio] == caracter)
+            return FUENTE_DIR_INDICE + FUENTE_BYTES_ENTRADA * medio;
+        if (indiceCaracter[medio] < caracter)
+            bajo = medio + 1;
+        else
+            alto = medio;
+    }
+    return DIR_NO_ENCONTRADA;
+}
+
+unsigned char cargaGlifo(char dat, uint8_t *patrones)
+{
+    unsigned int entrada[FUENTE_BYTES_ENTRADA / 2];
+    unsigned int dir;
+    unsigned char ancho, literales, j;
+    
+    ancho = leeCacheGlifos(dat, patrones);
+    if (ancho != 0)
+        return ancho;
+    PERFIL_INICIO(PERFIL_INDICE);
+    dir = buscaDirEEPROM(dat);
+    PERFIL_FIN(PERFIL_INDICE);
+    if (dir == DIR_NO_ENCONTRADA)
+        return 0;
+    PERFIL_INICIO(PERFIL_GLIFO);
+    //Entrada del indice: caracter y mascara, luego direccion y ancho
+    leeAutomatico(dir, entrada, FUENTE_BYTES_ENTRADA / 2);
+    ancho = FUENTE_ANCHO(entrada[1]);
+    if (ancho > ANCHO_MAX_GLIFO)
+        ancho = ANCHO_MAX_GLIFO;
+    literales = literalesGlifo(entrada[0] >> 8, ancho);
+    leeBytes93LC66B(FUENTE_DIR_PATRONES(entrada[1]), patrones, literales);
+    expandeGlifo(patrones, entrada[0] >> 8, ancho, literales);
+    for (j = ancho; j < ANCHO_MAX_GLIFO; j++)
+        patrones[j] = 0;
+    PERFIL_FIN(PERFIL_GLIFO);
+    guardaCacheGlifos(dat, patrones, ancho);
+    return ancho;
+}
+
+unsigned char pideGlifo(char dat)
+{
+    unsigned int dir;
+    
+    //En la EEPROM interna el glifo queda listo sin pasos
+    anchoGlifo = leeCacheGlifos(dat, glifo.columnas);
+    if (anchoGlifo != 0)
+    {
+        estadoGlifo = GLIFO_LISTO;
+        return 1;
+    }
+    PERFIL_INICIO(PERFIL_INDICE);
+    dir = buscaDirEEPROM(dat);
+    PERFIL_FIN(PERFIL_INDICE);
+    if (dir == DIR_NO_ENCONTRADA)
+    {
+        estadoGlifo = GLIFO_LIBRE;
+        return 0;
+    }
+    pideLectura93LC66B(dir, glifo.palabras, FUENTE_BYTES_ENTRADA / 2);
+    caracterGlifo = dat;
+    estadoGlifo = GLIFO_ENTRADA;
+    return 1;
+}
+
+const uint8_t *glifoListo(unsigned char *ancho)
+{
+    unsigned int palabra;   //tambien la direccion de los patrones
+    unsigned char j, literales;
+    
+    if (estadoGlifo == GLIFO_LISTO)
+    {
+        *ancho = anchoGlifo;
+        return glifo.columnas;
+    }
+    pasoLectura93LC66B();
+    if (!lecturaLista93LC66B())
+        return 0;
+    switch (estadoGlifo)
+    {
+        case GLIFO_ENTRADA:
+            mascaraGlifo = glifo.palabras[0] >> 8;
+            anchoGlifo = FUENTE_ANCHO(glifo.palabras[1]);
+            if (anchoGlifo > ANCHO_MAX_GLIFO)
+                anchoGlifo = ANCHO_MAX_GLIFO;
+            //Se leen palabras completas desde la direccion par anterior
+            palabra = FUENTE_DIR_PATRONES(glifo.palabras[1]);
+            literales = literalesGlifo(mascaraGlifo, anchoGlifo);
+            estadoGlifo = (palabra & 1) ? GLIFO_PATRONES_IMPAR : GLIFO_PATRONES;
+            pideLectura93LC66B(palabra & ~1, glifo.palabras, ((palabra & 1) + literales + 1) / 2);
+            return 0;
+        case GLIFO_PATRONES:
+        case GLIFO_PATRONES_IMPAR:
+            literales = literalesGlifo(mascaraGlifo, anchoGlifo);
+            //Separacion en el mismo lugar: la palabra j solo ocupa los bytes 2j y 2j+1
+            for (j = 0; j < ANCHO_MAX_GLIFO / 2 + 1; j++)
+            {
+                palabra = glifo.palabras[j];
+                glifo.columnas[2*j] = palabra & 0x00FF;
+                glifo.columnas[2*j+1] = (palabra >> 8) & 0x00FF;
+            }
+            if (estadoGlifo == GLIFO_PATRONES_IMPAR)
+            {
+                for (j = 0; j < literales; j++)
+                    glifo.columnas[j] = glifo.columnas[j + 1];
+            }
+            expandeGlifo(glifo.columnas, mascaraGlifo, anchoGlifo, literales);
+            for (j = anchoGlifo; j < ANCHO_MAX_GLIFO; j++)
+                glifo.columnas[j] = 0;
+            guardaCacheGlifos(caracterGlifo, glifo.columnas, anchoGlifo);
+            estadoGlifo = GLIFO_LISTO;
+            *ancho = anchoGlifo;
+            return glifo.columnas;
+        case GLIFO_LISTO:
+            *ancho = anchoGlifo;
+            return glifo.columnas;
+        default:
+            return 0;
+    }
+}
+
+void cancelaGlifo(void)
+{
+    estadoGlifo = GLIFO_LIBRE;
+}
+
+//Deja en blanco las columnas que sobran del cuadro y lo muestra
+static void muestraCuadro(uint8_t *cuadro, uint8_t usadas)
+{
+    uint8_t k;
+    
+    for (k = usadas; k < FILAS_PANTALLA; k++)
+        cuadro[k] = 0;
+    intercambiaPantalla();
+    esperaCuadros(CUADROS_POR_CARACTER);
+    //El buffer trasero se sigue mostrando hasta que se aplica el intercambio
+    while (cambioPendientePantalla())
+        NOP();
+    //Debug de contenido de mensaje
+    //printCad("Msg::---\n");
+    //for(int i = 0; i < FILAS_PANTALLA; i++)
+    //{
+    //    enviaHexByte(i);
+    //    printCad(":-");
+    //    enviaHexByte(cuadro[i]);
+    //    printCad("--");
+    //}
 }
 
 void printCad93LC66B(const char *cad)
 {
     unsigned char i = 0;
-    unsigned int memoria=0, dir;
     unsigned char numPatrones;
-    uint8_t const S[8] = {1, 2, 4, 8, 16, 32, 64, 128};
-    uint8_t message[10]={0};
-    int y,n,p;
+    uint8_t *cuadro;
+    unsigned char revisado = 0;
+    uint8_t glifo[ANCHO_MAX_GLIFO];
+    uint8_t k;
+    uint8_t usadas = 0; //columnas del cuadro ocupadas, con sus separaciones
     
+    while (cambioPendientePantalla())
+        NOP();
+    cuadro = bufferPantalla();
     while(cad[i]!= 0)
     {
         //printCad("\n");
         //enviaRS232(cad[i]);
         //printCad("- char-: ");
         //enviaHexByte(cad[i]);
-        dir = buscaDirEEPROM(cad[i]);
-        //printCad("  -dir-:");
-        //enviaHexByte(dir);
+        numPatrones = cargaGlifo(cad[i], glifo);
+        if (numPatrones == 0 && !revisado)
+        {
+            //Respaldo: la tabla pudo haber cambiado desde que se armo el indice
+            revisado = 1;
+            if (revisaIndiceEEPROM())
+                numPatrones = cargaGlifo(cad[i], glifo);
+        }
+        //printCad("NumPat: ");
+        //enviaHexByte(numPatrones);
         //printCad("\n");
-        if (dir != 5)
+        if (numPatrones != 0)
         {
-            memoria = lee93LC66B(dir);
-            numPatrones = (memoria >> 8) & (0x00FF);
-            
-            //printCad("NumPat: ");
-            //enviaHexByte(numPatrones);
-            //printCad("\n");
-            
-            for (int j = 0; j <= numPatrones; j++)
+            //El caracter que ya no cabe completo empieza el siguiente cuadro
+            if (usadas + numPatrones > FILAS_PANTALLA)
             {
-                if((j+2)%2 == 0)
-                {
-                    memoria = lee93LC66B(dir+j+2);
-                    message[j+1] = (memoria >> 8) & 0x00FF;
-                    message[j] = memoria & 0x00FF;
-                    //printCad("Direccion [");enviaHexByte(j);
-                    //printCad("]: ");
-                    //enviaHexByte((memoria >> 8) & 0x00FF);
-                    //enviaHexByte(memoria & 0x00FF);
-                    //printCad("\r\n");
-                }
+                muestraCuadro(cuadro, usadas);
+                cuadro = bufferPantalla();
+                usadas = 0;
             }
-
-            //for( y = 0; y < numPatrones+8; y++)
-            //{
-                for( p = 0; p < 32; p++)
-                {
-                    for(n=0;n<8;n++)
-                    {
-                        H595(~message[n],S[n]);
-                        __delay_us(5);
-                        H595(0,0);
-                    }
-                }
-            //}
-            //Debug de contenido de mensaje
-            //printCad("Msg::---\n");
-            //for(int i = 0; i < numPatrones+1; i++)
-            //{
-            //    enviaHexByte(i);
-            //    printCad(":-");
-            //    enviaHexByte(message[i]);
-            //    printCad("--");
-            //}
+            for (k = 0; k < numPatrones; k++)
+                cuadro[usadas++] = glifo[k];
+            for (k = 0; k < SEPARACION_GLIFOS && usadas < FILAS_PANTALLA; k++)
+                cuadro[usadas++] = 0;
         }
-    i++;    
+        i++;
     }
+    if (usadas != 0)
+        muestraCuadro(cuadro, usadas);
+    //Al terminar la cadena la matriz queda apagada
+    for (i = 0; i < FILAS_PANTALLA; i++)
+        cuadro[i] = 0;
+    intercambiaPantalla();
 }
@@ -14,65 +14,200 @@
 #include "m93lc66b.h"
 #include "h595.h"
 #include "rs232.h"
+#include "pantalla.h"
+#include "perfil.h"
+
+//Formato de la imagen de la EEPROM que genera herramientas/fuente.py
+//(direcciones en bytes, palabras LSB primero):
+//  0  firma 'F' 'M'
+//  2  numero de glifos (LSB) y version del formato (MSB)
+//  4  longitud total de la imagen en bytes
+//  6  suma de 16 bits de las palabras a partir de FUENTE_DIR_INDICE
+//  8  indice ordenado por caracter, 4 bytes por glifo: caracter, mascara de
+//     repeticion y una palabra con la direccion de sus patrones (bits 0-11)
+//     y su ancho (bits 12-15)
+//Los patrones son las columnas del glifo (una por byte, en cualquier
+//direccion) sin las que repiten la anterior: el bit j de la mascara indica
+//que la columna j es igual a la j-1, y antes de la primera se toma una
+//columna en blanco.
+#define FUENTE_FIRMA 0x4D46
+#define FUENTE_VERSION 2
+#define FUENTE_PALABRAS_CABECERA 4
+#define FUENTE_DIR_INDICE 8
+#define FUENTE_BYTES_ENTRADA 4
+//Capacidad de la EEPROM (ver M93_MODELO en m93lc66b.h)
+#define FUENTE_LONGITUD_MAX M93_BYTES
+//Columnas maximas de un glifo (ancho de la matriz)
+#define ANCHO_MAX_GLIFO 8
+//Campos de la segunda palabra de una entrada del indice
+#define FUENTE_DIR_PATRONES(palabra) ((palabra) & 0x0FFF)
+#define FUENTE_ANCHO(palabra) ((palabra) >> 12)
+//Columnas en blanco despues de cada caracter: los glifos se acomodan segun su
+//ancho real (fuente proporcional) en printCad93LC66B() y en la marquesina
+#ifndef SEPARACION_GLIFOS
+#define SEPARACION_GLIFOS 1
+#endif
+//Columnas en blanco que ocupa en la marquesina un caracter que no esta en la
+//fuente
+#define ANCHO_SIN_GLIFO (ANCHO_MAX_GLIFO / 2)
+//Valor de buscaDirEEPROM() cuando el caracter no esta en la fuente
+#define DIR_NO_ENCONTRADA 0xFFFF
+
+//Estados de la carga no bloqueante de un glifo (pideGlifo())
+#define GLIFO_LIBRE 0
+#define GLIFO_ENTRADA 1
+#define GLIFO_PATRONES 2
+#define GLIFO_LISTO 3
+//Como GLIFO_PATRONES, con los patrones en direccion impar: la paridad va en el
+//estado y no en otra variable
+#define GLIFO_PATRONES_IMPAR 4
+
+//Cuadros de refresco que permanece cada cuadro de printCad93LC66B (~160 ms)
+#define CUADROS_POR_CARACTER 20
+//Caracteres del indice que se mantienen en RAM; los demas se buscan en la
+//copia del indice en la EEPROM interna (cacheGlifos.h), que se lee casi tan
+//rapido, y solo los que tampoco caben ahi en la 93LC66B.
+#define INDICE_MAX 8
+
+/**
+ * @brief Inicializa el módulo de la matriz leyendo la cabecera de la fuente grabada en la EEPROM.
+ *
+ * @pre La EEPROM 93LC66B debe haber sido inicializada con `init_93lc66b()`.
+ *
+ * @details Lee la imagen completa con una sola lectura secuencial (`iniciaLectura93LC66B()` y `leeMemoria()`). Valida la firma, la versión y la longitud de la cabecera, copia a RAM los caracteres de las primeras `INDICE_MAX` entradas del índice, guarda el índice en la EEPROM interna (`indiceCacheGlifos()`) y comprueba la suma de verificación. Al final informa la fuente a `fuenteCacheGlifos()`, que conserva los glifos guardados en la EEPROM interna si la fuente es la misma del arranque anterior. Si algo no coincide la fuente se considera vacía y ningún carácter se encuentra.
+ *
+ * @code
+ * init_93lc66b();
+ * init_matrizLed();
+ * @endcode
+ *
+ * @note La imagen se genera con `herramientas/fuente.py`; ver el formato al inicio de este archivo.
+ */
+void init_matrizLed(void);
+/**
+ * @brief Verifica que el índice en RAM corresponda al contenido actual de la EEPROM y lo reconstruye si cambió.
+ *
+ * @pre `init_matrizLed()` debe haberse llamado previamente.
+ *
+ * @details Lee solo la cabecera de la imagen (4 palabras) y compara la firma, el número de glifos y la suma de verificación con los de la fuente cargada. Si alguno es diferente (por ejemplo, porque la EEPROM se reprogramó) o la fuente no era válida, el índice se vuelve a cargar con una lectura completa.
+ *
+ * @return 1 si el índice se reconstruyó, 0 si seguía vigente.
+ *
+ * @code
+ * if (revisaIndiceEEPROM()) {
+ *     // La tabla de caracteres cambió.
+ * }
+ * @endcode
+ *
+ * @remark `printCad93LC66B()` llama a esta función como respaldo cuando un carácter no se encuentra en el índice, como máximo una vez por cadena.
+ */
+unsigned char revisaIndiceEEPROM(void);
+/**
+ * @brief Número de glifos de la fuente cargada.
+ *
+ * @return El número de glifos de la cabecera, o 0 si la imagen de la EEPROM no es válida.
+ */
+unsigned char glifosFuente(void);
+/**
+ * @brief Busca la entrada del índice de la fuente que corresponde a un carácter.
+ *
+ * @param caracter Carácter que se va a buscar en la EEPROM (sin signo: el índice está ordenado de 0 a 255).
+ *
+ * @pre `init_matrizLed()` debe haberse llamado previamente para cargar el índice de caracteres en RAM.
+ *
+ * @details Como el índice de la imagen está ordenado por carácter, la posición del carácter en el índice da directamente la dirección de su entrada (`FUENTE_DIR_INDICE + 4 * posicion`). La búsqueda binaria se hace sobre la copia en RAM, sin acceder a la EEPROM; los caracteres posteriores a las primeras `INDICE_MAX` entradas se buscan con `caracterIndiceCacheGlifos()` en la copia de la EEPROM interna, y solo las entradas después de `CACHE_INDICE_MAX` (o todas, mientras hay una escritura interna en curso) se leen de la 93LC66B.
+ *
+ * @return La dirección (en bytes) de la entrada del índice del carácter `caracter`, o `DIR_NO_ENCONTRADA` si el carácter no está en la fuente.
+ *
+ * @code
+ * unsigned int address = buscaDirEEPROM('X');
+ * if (address != DIR_NO_ENCONTRADA) {
+ *     // La entrada de 'X' empieza en 'address'.
+ * }
+ * @endcode
+ *
+ * @remark Con 38 glifos la búsqueda requiere como máximo 6 comparaciones en RAM, sin ningún acceso a las EEPROM. Si la EEPROM se reprograma después del arranque, el índice debe actualizarse con `revisaIndiceEEPROM()`.
+ */
+unsigned int buscaDirEEPROM(unsigned char caracter);
 /**
- * @brief Busca la direccin en la EEPROM 93LC66B donde se encuentra almacenado un carcter especfico.
+ * @brief Lee de la EEPROM los patrones de un carácter.
+ *
+ * @param dat Carácter a cargar.
+ * @param patrones Arreglo de al menos `ANCHO_MAX_GLIFO` bytes donde se escriben las columnas del carácter.
+ *
+ * @pre `init_matrizLed()` debe haberse llamado previamente.
+ *
+ * @details Primero busca el glifo en la EEPROM interna (`leeCacheGlifos()`). Si no está, localiza la entrada del carácter con `buscaDirEEPROM()` y lee de ella la máscara de repetición, el ancho y la dirección de los patrones. Solo se leen con `leeBytes93LC66B()` las columnas que no repiten la anterior, directamente en `patrones`, y ahí mismo se expanden de la última columna a la primera, sin otro buffer; el glifo completo se pasa a `guardaCacheGlifos()`, que decide si se queda en la EEPROM interna. Las columnas después del ancho del glifo se ponen en cero.
  *
- * @param dat Carcter que se va a buscar en la EEPROM.
+ * @return El ancho del carácter en columnas, o 0 si el carácter no está en la fuente; en ese caso `patrones` no se modifica.
  *
- * @pre Los mdulos de la EEPROM 93LC66B (`m93lc66b.h`), los registros de desplazamiento (`h595.h`) y la comunicacin RS-232 (`rs232.h`) deben haber sido inicializados correctamente. `NUM_OF_CHARACTERS` debe estar definido como el nmero total de caracteres almacenados en la EEPROM. Se asume que los caracteres estn almacenados en palabras de 16 bits, donde solo se utiliza el byte menos significativo (LSB). Los datos deben estar almacenados en direcciones multiplos de 10.
+ * @code
+ * uint8_t columnas[ANCHO_MAX_GLIFO];
+ * if (cargaGlifo('A', columnas)) {
+ *     // columnas[] contiene la letra A.
+ * }
+ * @endcode
+ */
+unsigned char cargaGlifo(char dat, uint8_t *patrones);
+/**
+ * @brief Empieza a cargar un glifo sin bloquear; la carga avanza con `glifoListo()`.
+ *
+ * @param dat Carácter a cargar.
  *
- * @details Esta funcin busca la direccin en la EEPROM 93LC66B donde se encuentra almacenado el carcter `dat`. Realiza una bsqueda lineal en la EEPROM, leyendo palabras de 16 bits desde direcciones que son mltiplos de 10. Extrae el byte menos significativo (LSB) de cada palabra leda y lo compara con el carcter `dat`. Si se encuentra una coincidencia, la funcin retorna la direccin correspondiente.
+ * @pre `init_matrizLed()` debe haberse llamado previamente.
  *
- * El proceso es el siguiente:
- *   1. Se inicializa un bucle `for` que itera desde 0 hasta `NUM_OF_CHARACTERS - 1`.
- *   2. En cada iteracin:
- *     a. Se calcula la direccin de memoria actual como `10 * i`.
- *     b. Se lee una palabra de 16 bits desde la direccin calculada utilizando la funcin `lee93LC66B()`.
- *     c. Se extrae el byte menos significativo (LSB) de la palabra leda utilizando una mscara AND (`& 0x00FF`).
- *     d. Se compara el LSB extrado con el carcter `dat`.
- *     e. Si hay una coincidencia, se retorna la direccin actual (`10 * i`).
- *   3. Si no se encuentra ninguna coincidencia despus de iterar sobre todos los caracteres almacenados, la funcin retorna 5.
+ * @details Si el glifo está en la EEPROM interna lo copia en ese momento y la siguiente llamada a `glifoListo()` lo entrega. Si no, localiza el carácter con `buscaDirEEPROM()` y programa con `pideLectura93LC66B()` la lectura de su entrada del índice. Las lecturas las hace después `glifoListo()`, un paso por llamada, por lo que el ciclo principal puede seguir atendiendo comandos mientras tanto. Solo hay un glifo en carga a la vez; pedir otro descarta el anterior.
  *
- * @return Un valor entero sin signo de 16 bits (`unsigned int`) que representa la direccin de la EEPROM donde se encontr el carcter `dat`. Si no se encuentra el carcter, retorna 5.
+ * @return 1 si la carga empezó, 0 si el carácter no está en la fuente.
  *
  * @code
- * char charToFind = 'X';
- * unsigned int address = buscaDirEEPROM(charToFind);
- * if (address != 5) {
- *     // Se encontr el carcter en la direccin 'address'.
- * } else {
- *     // No se encontr el carcter.
+ * uint8_t ancho;
+ * const uint8_t *columnas;
+ * pideGlifo('A');
+ * while ((columnas = glifoListo(&ancho)) == 0) {
+ *     atiendeComandos();
  * }
  * @endcode
  *
- * @note El valor de retorno 5 en caso de no encontrar el carcter es arbitrario y podra ser modificado. Es importante que este valor sea un valor que no corresponda a una direccin vlida de la EEPROM, para poder diferenciar entre una direccin vlida y un error de bsqueda.
+ * @remark La búsqueda en el índice siempre es bloqueante, pero fuera de RAM solo lee la EEPROM interna salvo con fuentes de más de `CACHE_INDICE_MAX` glifos.
+ */
+unsigned char pideGlifo(char dat);
+/**
+ * @brief Avanza un paso la carga iniciada con `pideGlifo()`.
+ *
+ * @param ancho Variable donde se escribe el ancho del glifo cuando la carga termina.
+ *
+ * @details Llama a `pasoLectura93LC66B()`; al terminar la lectura de la entrada del índice programa la de los patrones (las palabras que contienen las columnas guardadas), y al terminar ésta separa los patrones en bytes (LSB primero), expande las columnas repetidas y pone en cero las columnas después del ancho, igual que `cargaGlifo()`; el glifo terminado se pasa a `guardaCacheGlifos()`. Si el glifo vino de la EEPROM interna regresa sus columnas de inmediato.
+ *
+ * @return Apuntador a las `ANCHO_MAX_GLIFO` columnas del glifo cuando está listo, o 0 mientras la carga sigue (o si no hay ninguna). Las columnas son válidas hasta el siguiente `pideGlifo()`.
+ */
+const uint8_t *glifoListo(unsigned char *ancho);
+/**
+ * @brief Descarta la carga no bloqueante en curso.
  *
- * @remark Esta funcin asume que los caracteres estn almacenados en el byte menos significativo (LSB) de palabras de 16 bits en la EEPROM y que las direcciones de almacenamiento son multiplos de 10. Consultar la hoja de datos de la 93LC66B para obtener informacin precisa sobre la organizacin de la memoria y el protocolo de comunicacin.
+ * @details La lectura de la EEPROM que estuviera a medias se termina la próxima vez que se use el bus.
  */
-unsigned int buscaDirEEPROM(char dat);
+void cancelaGlifo(void);
 /**
  * @brief Muestra una cadena de caracteres en un display utilizando datos almacenados en la EEPROM 93LC66B.
  *
  * @param cad Puntero constante a la cadena de caracteres que se va a mostrar.
  *
- * @pre Los mdulos de la EEPROM 93LC66B (`m93lc66b.h`), los registros de desplazamiento (`h595.h`) y la comunicacin RS-232 (`rs232.h`) deben haber sido inicializados correctamente. `NUM_OF_CHARACTERS` debe estar definido. La funcin `buscaDirEEPROM()` debe estar implementada correctamente. Se asume que los datos en la EEPROM estn organizados de la siguiente manera: en la direccin obtenida por `buscaDirEEPROM()` se almacena el nmero de patrones (bytes) que definen el carcter, y a partir de la direccin `dir + 2` se almacenan los patrones de 8 bits.
+ * @pre Los módulos de la EEPROM 93LC66B (`m93lc66b.h`), los registros de desplazamiento (`h595.h`) y la comunicación RS-232 (`rs232.h`) deben haber sido inicializados correctamente. La EEPROM debe contener una imagen generada con `herramientas/fuente.py` y `init_matrizLed()` debe haberse llamado previamente.
  *
- * @details Esta funcin toma una cadena de caracteres y la muestra en un display utilizando datos almacenados en la EEPROM 93LC66B. Por cada carcter en la cadena:
- *   1. Se busca la direccin en la EEPROM donde se almacenan los datos del carcter utilizando la funcin `buscaDirEEPROM()`.
- *   2. Si se encuentra la direccin (es decir, `buscaDirEEPROM()` no retorna 5):
- *     a. Se lee el nmero de patrones desde la EEPROM en la direccin obtenida y se guarda en `numPatrones`.
- *     b. Se leen los patrones del carcter desde la EEPROM, a partir de la direccin `dir + 2`, y se almacenan en el array `message`. Se leen los datos en pares, asumiendo que cada par representa un patrn.
- *     c. Se itera 32 veces para actualizar el display.
- *     d. Dentro de este bucle, se itera 8 veces, enviando cada byte del patrn a los registros de desplazamiento usando la funcin `H595()` y los valores del array `S`. Se genera un pequeo retardo entre cada envo.
- *   3. Se repiten los pasos 1 y 2 para el siguiente carcter de la cadena hasta que se encuentra el carcter nulo ('\0').
+ * @details Esta función toma una cadena de caracteres y la muestra en un display utilizando datos almacenados en la EEPROM 93LC66B. Cada cuadro muestra tantos caracteres completos como quepan en las `FILAS_PANTALLA` columnas de todos los paneles, cada uno con su ancho real y `SEPARACION_GLIFOS` columnas en blanco después:
+ *   1. Se leen las columnas del siguiente carácter con `cargaGlifo()`, que localiza el carácter con `buscaDirEEPROM()` y lee su entrada del índice y sus patrones.
+ *   2. Si el carácter ya no cabe en el buffer trasero de la pantalla (`bufferPantalla()`), las columnas sobrantes se dejan en blanco, se intercambian los buffers con `intercambiaPantalla()`, se esperan `CUADROS_POR_CARACTER` cuadros mientras la interrupción del Timer0 mantiene encendida la matriz y el carácter empieza el siguiente cuadro. Después se copian sus columnas a continuación de las del carácter anterior.
+ *   3. Se repiten los pasos 1 y 2 hasta que se encuentra el carácter nulo ('\0'), y se muestra el último cuadro.
+ *   4. Al terminar la cadena se muestra un cuadro vacío.
  *
  * @code
  * printCad93LC66B("Ejemplo"); // Muestra la cadena "Ejemplo" en el display.
  * @endcode
  *
- * @note La precisin de los retardos depende de la frecuencia del oscilador del microcontrolador. Asegrese de que la macro `__delay_us()` est configurada correctamente para su configuracin de hardware. El tamao del array `message` (10) debe ser lo suficientemente grande para almacenar el mximo nmero de patrones que se puedan leer desde la EEPROM.
+ * @note El refresco de la matriz debe haberse iniciado con `init_pantalla()`. El tiempo que se muestra cada carácter depende de la frecuencia de refresco configurada en `pantalla.h`.
  *
- * @remark Esta funcin asume una organizacin especfica de los datos en la EEPROM. Consultar la documentacin del formato de almacenamiento en la EEPROM para asegurar la compatibilidad. La constante `S` se utiliza para multiplexar los datos en el display. El valor 5 retornado por `buscaDirEEPROM` indica que el caracter no se encontro.
+ * @remark Esta función asume una organización específica de los datos en la EEPROM. Consultar la documentación del formato de almacenamiento en la EEPROM para asegurar la compatibilidad. Los caracteres que no están en la fuente se omiten.
  */
 void printCad93LC66B(const char *cad);
 
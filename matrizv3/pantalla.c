@@ -0,0 +1,270 @@
+#include "pantalla.h"
+
+//Un juego de planos de bits por buffer; con PANTALLA_BITS = 1 es un solo cuadro
+static uint8_t buffers[2][PANTALLA_BITS][FILAS_PANTALLA];
+static uint8_t trasero = 1;
+//Origen de las filas que recorre la interrupcion: un buffer de cuadro o una
+//tira de columnas (marquesina) vista a traves de una ventana de 8 filas. Los
+//planos de bits estan separados pasoPlano bytes (0: todos usan el mismo).
+static const uint8_t *volatile fuente;
+static volatile uint8_t pasoPlano = 0;
+static volatile uint8_t mascara = 0xFF;
+static volatile uint8_t desplazamiento = 0;
+static volatile uint8_t limite = 0;
+static volatile uint8_t velocidad = 0;
+static uint8_t acumulador = 0;
+static volatile unsigned int paradas = 0;   //avances perdidos por llegar al limite
+//Cambio de origen solicitado, se aplica al inicio del siguiente cuadro. La
+//interrupcion pone fuentePendiente en 0 al aplicarlo: no hace falta otra
+//bandera.
+static const uint8_t *volatile fuentePendiente = 0;
+static volatile uint8_t pasoPendiente;
+static volatile uint8_t mascaraPendiente;
+static volatile uint8_t velocidadPendiente;
+static volatile uint8_t cuadros = 0;
+static uint8_t fila = 0;
+static uint8_t anodo = 1;
+static uint8_t plano = 0;                   //intervalo actual de la fila
+static const uint8_t *fuentePlano;          //inicio del plano actual
+static uint8_t catodos[PANELES];
+//Brillo: cuentas del Timer0 del intervalo apagado de cada fila, cuadros por
+//segundo que resultan y anodo de la fila 0 (0: pantalla apagada)
+static volatile uint8_t apagado = 0;
+static volatile uint8_t cuadrosSegundo = CUADROS_POR_SEGUNDO;
+static volatile uint8_t anodoInicial = 1;
+
+void init_pantalla(void)
+{
+    uint8_t i, k;
+    for (k = 0; k < PANTALLA_BITS; k++)
+        for (i = 0; i < FILAS_PANTALLA; i++)
+        {
+            buffers[0][k][i] = 0;
+            buffers[1][k][i] = 0;
+        }
+    fuente = buffers[0][0];
+    trasero = 1;
+    brilloPantalla(PANTALLA_BRILLO_MAX);
+    OPTION_REGbits.T0CS = 0;    //Reloj interno (Fosc/4)
+    OPTION_REGbits.PSA = 0;     //Preescalador asignado al Timer0
+    OPTION_REG = (OPTION_REG & 0xF8) | PANTALLA_PREESCALADOR;
+    TMR0 = PANTALLA_RECARGA_TMR0;
+    INTCONbits.T0IF = 0;
+    INTCONbits.T0IE = 1;
+    INTCONbits.GIE = 1;
+}
+
+//Sin llamadas a otras funciones: dentro de la interrupcion cada llamada
+//gasta un nivel de la pila de hardware que le falta al ciclo principal
+void refrescaPantalla(void)
+{
+    uint8_t p, columna;
+    
+    INTCONbits.T0IF = 0;
+    if (plano == PANTALLA_BITS)
+    {
+        //Fila terminada: pasa a la siguiente y al terminar la ultima cierra el cuadro
+        plano = 0;
+        fila++;
+        anodo <<= 1;
+        if (fila == FILAS_PANEL)
+        {
+            fila = 0;
+            anodo = anodoInicial;
+            cuadros++;
+            //Avance de la ventana: velocidad/cuadrosSegundo columnas por cuadro
+            if (velocidad)
+            {
+                acumulador += velocidad;
+                if (acumulador >= cuadrosSegundo)
+                {
+                    acumulador -= cuadrosSegundo;
+                    if (desplazamiento != limite)
+                        desplazamiento++;
+                    else if (paradas != 0xFFFF)
+                        paradas++;
+                }
+            }
+        }
+        //Intervalo apagado que completa la fila y la alarga con menos brillo
+        if (apagado != 0)
+        {
+            TMR0 = (uint8_t)(256 - apagado);
+            for (p = 0; p < PANELES; p++)
+                catodos[p] = 0xFF;
+            H595_PANELES(catodos, 0);
+            return;
+        }
+    }
+    //El plano k dura PANTALLA_UNIDAD * 2^k cuentas
+    TMR0 = (uint8_t)(256 - (PANTALLA_UNIDAD << plano));
+    if (plano == 0)
+    {
+        if (fila == 0 && fuentePendiente != 0)
+        {
+            fuente = fuentePendiente;
+            pasoPlano = pasoPendiente;
+            mascara = mascaraPendiente;
+            velocidad = velocidadPendiente;
+            desplazamiento = 0;
+            limite = 0;
+            acumulador = 0;
+            fuentePendiente = 0;
+        }
+        fuentePlano = fuente;
+    }
+    columna = desplazamiento + fila;
+    for (p = 0; p < PANELES; p++)
+    {
+        catodos[p] = ~fuentePlano[columna & mascara];
+        columna += FILAS_PANEL;
+    }
+    PERFIL_INICIO(PERFIL_FILA);
+    H595_PANELES(catodos, anodo);
+    PERFIL_FIN(PERFIL_FILA);
+    fuentePlano += pasoPlano;
+    plano++;
+}
+
+//Regresa sin esperar; quien necesite el cambio aplicado consulta
+//cambioPendientePantalla(). Con un cambio anterior aun pendiente la
+//interrupcion no debe aplicar una mezcla de los dos. Macro y no funcion: los
+//comandos cambian el mensaje con la pila compilada casi llena y sus
+//parametros no caben otra vez en ella.
+#define SOLICITA_FUENTE(origen, paso, m, pxPorSegundo) do { \
+        uint8_t habilitada = INTCONbits.T0IE; \
+        INTCONbits.T0IE = 0; \
+        fuentePendiente = (origen); \
+        pasoPendiente = (paso); \
+        mascaraPendiente = (m); \
+        velocidadPendiente = (pxPorSegundo); \
+        INTCONbits.T0IE = habilitada; \
+    } while (0)
+
+uint8_t cambioPendientePantalla(void)
+{
+    //La interrupcion solo lo pone en 0: aun leido a medias nunca parece
+    //aplicado antes de tiempo
+    return fuentePendiente != 0;
+}
+
+uint8_t *tiraPantalla(void)
+{
+    return buffers[0][0];
+}
+
+uint8_t *bufferPantalla(void)
+{
+    return buffers[trasero][0];
+}
+
+uint8_t *planoPantalla(uint8_t k)
+{
+    return buffers[trasero][k];
+}
+
+void pixelPantalla(uint8_t columna, uint8_t bit, uint8_t nivel)
+{
+    uint8_t k, m = 1 << bit;
+    for (k = 0; k < PANTALLA_BITS; k++)
+    {
+        if (nivel & 1)
+            buffers[trasero][k][columna] |= m;
+        else
+            buffers[trasero][k][columna] &= ~m;
+        nivel >>= 1;
+    }
+}
+
+void intercambiaPantalla(void)
+{
+    //Sin desplazamiento los indices nunca pasan de FILAS_PANTALLA - 1. Todos
+    //los planos muestran el buffer 0: brillo completo en cada LED encendido
+    SOLICITA_FUENTE(buffers[trasero][0], 0, 0xFF, 0);
+    trasero ^= 1;
+}
+
+void intercambiaGrisesPantalla(void)
+{
+    SOLICITA_FUENTE(buffers[trasero][0], FILAS_PANTALLA, 0xFF, 0);
+    trasero ^= 1;
+}
+
+void ventanaPantalla(const uint8_t *tira, uint8_t m, uint8_t pxPorSegundo)
+{
+    if (pxPorSegundo > cuadrosSegundo)
+        pxPorSegundo = cuadrosSegundo;
+    SOLICITA_FUENTE(tira, 0, m, pxPorSegundo);
+}
+
+void velocidadPantalla(uint8_t pxPorSegundo)
+{
+    if (pxPorSegundo > cuadrosSegundo)
+        pxPorSegundo = cuadrosSegundo;
+    velocidad = pxPorSegundo;
+}
+
+void brilloPantalla(uint8_t nivel)
+{
+    //Fila de PANTALLA_TICS_FILA cuentas con el brillo maximo (y apagada) hasta
+    //PANTALLA_TICS_FILA_MAX con el nivel 1; la parte encendida no cambia
+    unsigned int periodo = PANTALLA_TICS_FILA;
+    uint8_t resto, c, habilitada;
+    
+    if (nivel != 0)
+        periodo += ((unsigned int)(PANTALLA_BRILLO_MAX - nivel) * (PANTALLA_TICS_FILA_MAX - PANTALLA_TICS_FILA)
+                    + (PANTALLA_BRILLO_MAX - 1) / 2) / (PANTALLA_BRILLO_MAX - 1);
+    resto = periodo - PANTALLA_TICS_ENCENDIDA;
+    //Un intervalo mas corto que la propia interrupcion no se puede cumplir
+    if (resto < PANTALLA_TICS_MINIMO)
+        resto = 0;
+    //Sin pasar de CUADROS_POR_SEGUNDO, para que el acumulador de la velocidad
+    //no se desborde
+    c = CUADROS_POR_SEGUNDO;
+    if (periodo > PANTALLA_TICS_FILA)
+        c = (uint8_t)((unsigned int)(PANTALLA_CUENTAS_SEGUNDO / FILAS_PANEL) / periodo);
+    //La interrupcion no debe ver el apagado nuevo con los cuadros anteriores
+    habilitada = INTCONbits.T0IE;
+    INTCONbits.T0IE = 0;
+    apagado = resto;
+    cuadrosSegundo = c;
+    anodoInicial = (nivel != 0);
+    //La ventana no puede avanzar mas de una columna por cuadro
+    if (velocidad > c)
+        velocidad = c;
+    if (velocidadPendiente > c)
+        velocidadPendiente = c;
+    if (acumulador >= c)
+        acumulador = 0;
+    INTCONbits.T0IE = habilitada;
+}
+
+void limiteVentana(uint8_t columna)
+{
+    limite = columna;
+}
+
+uint8_t desplazamientoVentana(void)
+{
+    return desplazamiento;
+}
+
+unsigned int paradasVentana(void)
+{
+    unsigned int n;
+    uint8_t habilitada;
+    
+    //Lectura de 16 bits que la interrupcion puede modificar a la mitad
+    habilitada = INTCONbits.T0IE;
+    INTCONbits.T0IE = 0;
+    n = paradas;
+    INTCONbits.T0IE = habilitada;
+    return n;
+}
+
+void esperaCuadros(unsigned char n)
+{
+    uint8_t inicio = cuadros;
+    while ((uint8_t)(cuadros - inicio) < n)
+        NOP();
+}
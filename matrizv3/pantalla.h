@@ -0,0 +1,257 @@
+/* 
+ * File:   pantalla.h
+ * Author: 
+ * Comments: Refresco de la matriz de LEDs por interrupcion del Timer0 con doble buffer
+ * Revision history: 
+ */
+
+// This is a guard condition so that contents of this file are not included
+// more than once.  
+#ifndef PANTALLA_H
+#define	PANTALLA_H
+
+#include <xc.h> // include processor files - each processor file is guarded.  
+#include <stdint.h>
+#include "h595.h"
+#include "perfil.h"
+
+//Filas (lineas de anodo) de cada panel y del letrero completo. Las filas de
+//los paneles se ponen una tras otra, asi que un buffer de cuadro o una
+//ventana tienen FILAS_PANTALLA bytes: los 8 primeros son el panel 0.
+#define FILAS_PANEL 8
+#define FILAS_PANTALLA (FILAS_PANEL * PANELES)
+//Bytes de los dos buffers de cuadro, que tiraPantalla() presta completos a la
+//marquesina
+#define PANTALLA_BYTES_TIRA (2 * PANTALLA_BITS * FILAS_PANTALLA)
+
+//Timer0 con preescalador 1:8 (8 us por cuenta a 4 MHz). Con 125 cuentas cada
+//fila se atiende cada 1 ms y la matriz completa se refresca a 125 Hz, sin
+//importar el numero de paneles (todos muestran la misma fila a la vez). Con
+//menos brillo las filas se alargan y el refresco baja (ver brilloPantalla()).
+#define PANTALLA_PREESCALADOR 0b010
+#define PANTALLA_TICS_FILA 125
+#define PANTALLA_RECARGA_TMR0 (256 - PANTALLA_TICS_FILA)
+#define CUADROS_POR_SEGUNDO 125
+//Cuentas del Timer0 en un segundo
+#define PANTALLA_CUENTAS_SEGUNDO 125000UL
+
+//Bits de gris por LED (1 a 4), por modulacion de codigo binario: cada fila se
+//muestra una vez por plano de bits y el plano k dura 2^k unidades. Con 1 bit
+//la matriz es de encendido/apagado y se comporta como antes. Cada bit
+//adicional duplica la RAM de los buffers de cuadro y agrega una interrupcion
+//por fila.
+#ifndef PANTALLA_BITS
+#define PANTALLA_BITS 1
+#endif
+#if PANTALLA_BITS < 1 || PANTALLA_BITS > 4
+#error "PANTALLA_BITS debe estar entre 1 y 4"
+#endif
+#define PANTALLA_NIVELES (1 << PANTALLA_BITS)
+//Cuentas del plano 0 y de la parte encendida de cada fila
+#define PANTALLA_UNIDAD (PANTALLA_TICS_FILA / (PANTALLA_NIVELES - 1))
+#define PANTALLA_TICS_ENCENDIDA (PANTALLA_UNIDAD * (PANTALLA_NIVELES - 1))
+//Intervalo mas corto que se programa en el Timer0 (~64 us, mas que lo que tarda
+//la interrupcion); un intervalo apagado menor se omite y la fila se acorta un
+//poco, por lo que con 3 o 4 bits el refresco sube hasta ~5 %
+#define PANTALLA_TICS_MINIMO 8
+#if PANTALLA_UNIDAD < PANTALLA_TICS_MINIMO
+#error "El plano 0 es mas corto que la interrupcion"
+#endif
+//Brillo global: la parte encendida de la fila no cambia y el brillo alarga el
+//intervalo apagado que la sigue, de PANTALLA_TICS_FILA cuentas por fila con el
+//brillo maximo a PANTALLA_TICS_FILA_MAX con el minimo. El refresco baja en la
+//misma proporcion: con 250 cuentas el brillo minimo es la mitad del maximo, a
+//62 cuadros/s; un valor mayor oscurece mas pero empieza a parpadear. El
+//intervalo apagado es uno solo del Timer0 (hasta 255 cuentas).
+#ifndef PANTALLA_TICS_FILA_MAX
+#define PANTALLA_TICS_FILA_MAX 250
+#endif
+#if PANTALLA_TICS_FILA_MAX < PANTALLA_TICS_FILA || PANTALLA_TICS_FILA_MAX - PANTALLA_TICS_ENCENDIDA > 255
+#error "PANTALLA_TICS_FILA_MAX debe estar entre PANTALLA_TICS_FILA y la parte encendida mas 255"
+#endif
+#define PANTALLA_BRILLO_MAX 255
+
+/**
+ * @brief Inicializa el refresco de la matriz por interrupción del Timer0.
+ *
+ * @pre Los pines del 74HC595 (puerto B) deben estar configurados como salidas.
+ *
+ * @details Limpia ambos buffers, configura el Timer0 con el reloj interno y el preescalador `PANTALLA_PREESCALADOR`, y habilita su interrupción junto con las interrupciones globales. A partir de este momento la rutina de interrupción debe llamar a `refrescaPantalla()` cada vez que se active `T0IF`.
+ *
+ * @code
+ * TRISB = 0x00;
+ * init_pantalla();
+ * @endcode
+ */
+void init_pantalla(void);
+/**
+ * @brief Atiende la interrupción del Timer0 mostrando la siguiente fila del buffer frontal.
+ *
+ * @pre Debe llamarse únicamente desde la rutina de interrupción, cuando `INTCONbits.T0IF` esté activo.
+ *
+ * @details Cada interrupción es un intervalo de la fila actual: uno por plano de bits (`PANTALLA_BITS`) y, si el brillo no es el máximo, uno apagado al final. Recarga el Timer0 con la duración del intervalo (`PANTALLA_UNIDAD * 2^plano` cuentas para el plano `plano`), limpia `T0IF` y envía con `H595Paneles()` el patrón del plano en la fila actual de cada panel junto con el ánodo que le corresponde, con un solo latch para toda la cadena. Así cada plano cuesta un solo desplazamiento por fila. Al comenzar un cuadro (fila 0) aplica el cambio de origen solicitado con `intercambiaPantalla()` o `ventanaPantalla()`, de modo que nunca se muestra un cuadro mezclado. Al terminar la última fila de los paneles incrementa el contador de cuadros y, si hay una ventana con velocidad, avanza su desplazamiento una columna cada vez que se acumulan tantas unidades de velocidad como cuadros por segundo da el brillo actual (`CUADROS_POR_SEGUNDO` con el brillo máximo), sin rebasar el límite fijado con `limiteVentana()`.
+ *
+ * @code
+ * void __interrupt() isr(void)
+ * {
+ *     if (INTCONbits.T0IE && INTCONbits.T0IF)
+ *         refrescaPantalla();
+ * }
+ * @endcode
+ */
+void refrescaPantalla(void);
+/**
+ * @brief Regresa el buffer trasero, donde se dibuja el siguiente cuadro.
+ *
+ * @details El buffer trasero tiene `FILAS_PANTALLA` bytes, el ancho combinado de todos los paneles; cada byte es el patrón de una fila (un bit en 1 enciende el LED) y el byte `FILAS_PANEL * p` es la primera fila del panel `p`. Su contenido no se muestra hasta llamar a `intercambiaPantalla()` y que la interrupción aplique el intercambio. Es también el plano 0 de `planoPantalla()`.
+ *
+ * @return Apuntador al buffer trasero.
+ *
+ * @code
+ * uint8_t *cuadro = bufferPantalla();
+ * cuadro[0] = 0xFF;
+ * intercambiaPantalla();
+ * @endcode
+ *
+ * @remark Después de cada intercambio el apuntador cambia; debe pedirse de nuevo para dibujar el siguiente cuadro, y no debe dibujarse en él mientras `cambioPendientePantalla()` regrese 1.
+ */
+uint8_t *bufferPantalla(void);
+/**
+ * @brief Intercambia de forma atómica el buffer trasero con el frontal.
+ *
+ * @pre Las interrupciones deben estar habilitadas.
+ *
+ * @details Solicita el intercambio y regresa sin esperar; la rutina de interrupción lo realiza al inicio del siguiente cuadro (como máximo un cuadro, 8 ms con el brillo máximo). `bufferPantalla()` entrega desde luego el buffer anterior, pero este se sigue mostrando hasta que `cambioPendientePantalla()` regrese 0; solo entonces está libre para dibujar. Una solicitud hecha mientras otra sigue pendiente la reemplaza.
+ *
+ * @code
+ * intercambiaPantalla();
+ * while (cambioPendientePantalla())
+ *     ; // o regresar y revisarlo en la siguiente vuelta del ciclo principal
+ * cuadro = bufferPantalla();
+ * @endcode
+ */
+void intercambiaPantalla(void);
+/**
+ * @brief Indica si el último cambio de origen solicitado todavía no se aplica.
+ *
+ * @details `intercambiaPantalla()`, `intercambiaGrisesPantalla()` y `ventanaPantalla()` solo dejan el cambio solicitado; la interrupción lo aplica al comenzar el siguiente cuadro. Quien necesita el cambio ya aplicado (para dibujar en el buffer trasero, o para fijar el límite de una ventana nueva, que el cambio pone en 0) consulta esta función en lugar de esperar dentro de la solicitud.
+ *
+ * @return 1 mientras el cambio está pendiente, 0 cuando ya se aplicó.
+ */
+uint8_t cambioPendientePantalla(void);
+/**
+ * @brief Regresa la RAM de los dos buffers de cuadro para usarla como tira de una ventana.
+ *
+ * @details Son `PANTALLA_BYTES_TIRA` bytes seguidos. La marquesina y los cuadros no se muestran a la vez, así que la tira no ocupa RAM propia. Mientras se muestra la tira con `ventanaPantalla()` no deben usarse `bufferPantalla()`, `planoPantalla()` ni `pixelPantalla()`; al cambiar de un modo al otro el primer cuadro puede mostrar lo que el otro modo dejó en la RAM.
+ *
+ * @return Apuntador al inicio de los buffers.
+ *
+ * @code
+ * uint8_t *tira = tiraPantalla();
+ * ventanaPantalla(tira, 15, 20); // Tira de 16 columnas, 20 columnas por segundo.
+ * @endcode
+ */
+uint8_t *tiraPantalla(void);
+/**
+ * @brief Regresa un plano de bits del buffer trasero, para dibujar en escala de grises.
+ *
+ * @param k Plano, de 0 (bit menos significativo del nivel) a `PANTALLA_BITS - 1`.
+ *
+ * @details Cada plano tiene el mismo formato que `bufferPantalla()`. El nivel de gris de un LED se forma con su bit en cada plano; el plano `k` se muestra durante `2^k` unidades de tiempo. Los planos se muestran con `intercambiaGrisesPantalla()`.
+ *
+ * @return Apuntador al plano `k` del buffer trasero.
+ */
+uint8_t *planoPantalla(uint8_t k);
+/**
+ * @brief Fija el nivel de gris de un LED en el buffer trasero.
+ *
+ * @param columna Fila del buffer (0 a `FILAS_PANTALLA - 1`), es decir, el byte del cuadro.
+ * @param bit Bit dentro del byte (0 a 7).
+ * @param nivel Nivel de gris, de 0 (apagado) a `PANTALLA_NIVELES - 1` (brillo completo).
+ *
+ * @code
+ * pixelPantalla(3, 0, PANTALLA_NIVELES / 2);
+ * intercambiaGrisesPantalla();
+ * @endcode
+ */
+void pixelPantalla(uint8_t columna, uint8_t bit, uint8_t nivel);
+/**
+ * @brief Intercambia el buffer trasero con el frontal mostrando todos sus planos de bits.
+ *
+ * @details Igual que `intercambiaPantalla()`, pero cada plano de la interrupción toma su propio plano del buffer, por lo que cada LED se muestra con su nivel de gris. `intercambiaPantalla()`, en cambio, usa el plano 0 en todos los planos y cada LED encendido queda con brillo completo.
+ */
+void intercambiaGrisesPantalla(void);
+/**
+ * @brief Fija el brillo global de la matriz.
+ *
+ * @param nivel Brillo de 0 (pantalla apagada) a `PANTALLA_BRILLO_MAX`.
+ *
+ * @details La unidad de los planos de bits no cambia: con 4 bits ya es el intervalo más corto que cumple la interrupción (`PANTALLA_TICS_MINIMO`), y los niveles de gris siguen siendo proporcionales con cualquier brillo. El brillo fija el intervalo apagado al final de cada fila: la fila dura `PANTALLA_TICS_FILA` cuentas con `PANTALLA_BRILLO_MAX` y crece en proporción hasta `PANTALLA_TICS_FILA_MAX` con el nivel 1, así que el brillo mínimo es `PANTALLA_TICS_ENCENDIDA / PANTALLA_TICS_FILA_MAX` del máximo con cualquier `PANTALLA_BITS`. Con filas más largas hay menos cuadros por segundo: la ventana sigue avanzando las columnas por segundo pedidas (limitadas a los cuadros por segundo del nuevo brillo) y `esperaCuadros()` tarda más. Con el nivel 0 la interrupción sigue recorriendo las filas al ritmo del brillo máximo, pero sin encender ningún ánodo; el cambio se aplica al comenzar el siguiente cuadro.
+ *
+ * @code
+ * brilloPantalla(PANTALLA_BRILLO_MAX / 2);
+ * @endcode
+ */
+void brilloPantalla(uint8_t nivel);
+/**
+ * @brief Muestra una ventana de `FILAS_PANTALLA` filas (todos los paneles) que se desliza sobre una tira circular de columnas.
+ *
+ * @param tira Arreglo circular de columnas; debe permanecer válido mientras se muestre.
+ * @param m Máscara del tamaño de la tira (tamaño - 1; el tamaño debe ser potencia de 2).
+ * @param pxPorSegundo Velocidad de avance en columnas por segundo (máximo los cuadros por segundo del brillo actual, `CUADROS_POR_SEGUNDO` con el brillo máximo).
+ *
+ * @details La rutina de interrupción muestra las filas `tira[(desplazamiento + fila) & m]`, con `fila` de 0 a `FILAS_PANTALLA - 1`, por lo que desplazar el mensaje solo cuesta incrementar `desplazamiento` una vez por columna; los datos de la tira nunca se vuelven a leer de la EEPROM. Regresa sin esperar: el cambio se aplica al inicio del siguiente cuadro con el desplazamiento y el límite en 0, por lo que la ventana no avanza hasta que se llame a `limiteVentana()` después de que `cambioPendientePantalla()` regrese 0.
+ *
+ * @code
+ * static uint8_t tira[32];
+ * ventanaPantalla(tira, 31, 20); // 20 columnas por segundo.
+ * while (cambioPendientePantalla())
+ *     ;
+ * limiteVentana(32 - FILAS_PANTALLA); // Hay datos válidos hasta la columna 31.
+ * @endcode
+ *
+ * @remark Para volver al modo de cuadros basta con llamar a `intercambiaPantalla()`.
+ */
+void ventanaPantalla(const uint8_t *tira, uint8_t m, uint8_t pxPorSegundo);
+/**
+ * @brief Cambia la velocidad de avance de la ventana actual.
+ *
+ * @param pxPorSegundo Velocidad en columnas por segundo (con el mismo máximo que en `ventanaPantalla()`); 0 detiene la ventana.
+ */
+void velocidadPantalla(uint8_t pxPorSegundo);
+/**
+ * @brief Fija el desplazamiento máximo al que puede llegar la ventana.
+ *
+ * @param columna Último desplazamiento permitido. La ventana se detiene al alcanzarlo, evitando mostrar columnas de la tira que todavía no se han llenado.
+ *
+ * @remark Los desplazamientos son contadores de 8 bits que dan la vuelta; la posición en la tira es `desplazamiento & m`.
+ */
+void limiteVentana(uint8_t columna);
+/**
+ * @brief Regresa el desplazamiento actual de la ventana.
+ *
+ * @return Primera columna (contador de 8 bits) que se está mostrando.
+ */
+uint8_t desplazamientoVentana(void);
+/**
+ * @brief Número de veces que la ventana debía avanzar una columna y no pudo porque llegó al límite.
+ *
+ * @details Cada parada es un plazo perdido por quien llena la tira (la marquesina): la columna siguiente no estaba lista cuando tocaba mostrarla, y el mensaje se detuvo un instante. Mientras valga 0 el desplazamiento ha sido continuo. El contador se detiene en 65535.
+ *
+ * @return Paradas desde el arranque.
+ */
+unsigned int paradasVentana(void);
+/**
+ * @brief Espera a que la rutina de refresco muestre un número de cuadros completos.
+ *
+ * @param n Número de cuadros a esperar.
+ *
+ * @details Durante la espera la matriz se sigue refrescando por interrupción, por lo que sustituye a los ciclos de `H595()` que antes mantenían encendida la matriz. Con un brillo menor que el máximo cada cuadro dura más (ver `brilloPantalla()`).
+ *
+ * @code
+ * esperaCuadros(125); // Aproximadamente 1 segundo con el brillo máximo.
+ * @endcode
+ */
+void esperaCuadros(unsigned char n);
+
+#endif	/* XC_HEADER_TEMPLATE_H */
@@ -0,0 +1,51 @@
+#include "perfil.h"
+
+#if PERFIL_ACTIVO
+
+uint16_t inicioPerfil[PERFIL_REGIONES];
+static RegistroPerfil tabla[PERFIL_REGIONES];
+
+void finPerfil(uint8_t r)
+{
+    uint16_t duracion = leeTimer1() - inicioPerfil[r];
+    RegistroPerfil *p = &tabla[r];
+    
+    if (p->cuenta == 0xFFFF)
+    {
+        p->cuenta >>= 1;
+        p->suma >>= 1;
+    }
+    //La tabla empieza en cero: la primera medicion fija el minimo
+    if (p->cuenta == 0 || duracion < p->minimo)
+        p->minimo = duracion;
+    if (duracion > p->maximo)
+        p->maximo = duracion;
+    p->cuenta++;
+    p->suma += duracion;
+}
+
+void leePerfil(uint8_t r, RegistroPerfil *registro)
+{
+    uint8_t gie = INTCONbits.GIE;
+    
+    INTCONbits.GIE = 0;
+    *registro = tabla[r];
+    INTCONbits.GIE = gie;
+}
+
+void limpiaPerfil(void)
+{
+    uint8_t r, gie = INTCONbits.GIE;
+    
+    INTCONbits.GIE = 0;
+    for (r = 0; r < PERFIL_REGIONES; r++)
+    {
+        tabla[r].cuenta = 0;
+        tabla[r].minimo = 0;
+        tabla[r].maximo = 0;
+        tabla[r].suma = 0;
+    }
+    INTCONbits.GIE = gie;
+}
+
+#endif
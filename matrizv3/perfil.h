@@ -0,0 +1,83 @@
+/*
+ * File:   perfil.h
+ * Author:
+ * Comments: Perfilador de rutinas criticas: mide regiones del codigo con el
+ *           Timer1 y acumula minimo, maximo, suma y cuenta de cada una en una
+ *           tabla fija de RAM que se envia con el comando 'F'
+ * Revision history:
+ */
+
+// This is a guard condition so that contents of this file are not included
+// more than once.
+#ifndef PERFIL_H
+#define	PERFIL_H
+
+#include <xc.h> // include processor files - each processor file is guarded.
+#include <stdint.h>
+#include "timer1.h"
+
+//0: las macros no generan codigo ni ocupan RAM. 1: se mide cada region (la
+//tabla ocupa 12 bytes de RAM por region). Las regiones de enviaRS232() y de
+//refrescaPantalla() suman dos niveles a la pila de hardware, que sin perfil ya
+//usa los 8; herramientas/recursos.py -DPERFIL_ACTIVO=1 muestra cuanto falta.
+#ifndef PERFIL_ACTIVO
+#define PERFIL_ACTIVO 0
+#endif
+
+//Regiones medidas; herramientas/perfil.py usa los mismos nombres en este orden
+#define PERFIL_INDICE 0     //busqueda en el indice de la fuente (buscaDirEEPROM)
+#define PERFIL_GLIFO 1      //lectura y expansion de un glifo de la 93LC66B (cargaGlifo)
+#define PERFIL_FILA 2       //envio de una fila a los 74HC595 (refrescaPantalla, en la interrupcion)
+#define PERFIL_UART 3       //entrega de un byte a la cola de transmision (enviaRS232)
+#define PERFIL_REGIONES 4
+
+typedef struct {
+    uint16_t cuenta;
+    uint16_t minimo;    //cuentas del Timer1
+    uint16_t maximo;
+    uint32_t suma;      //promedio = suma / cuenta
+} RegistroPerfil;
+
+#if PERFIL_ACTIVO
+//Marca de inicio de cada region; es global para que PERFIL_INICIO() no cueste
+//una llamada dentro de lo que se mide
+extern uint16_t inicioPerfil[PERFIL_REGIONES];
+#define PERFIL_INICIO(r) (inicioPerfil[r] = leeTimer1())
+#define PERFIL_FIN(r) finPerfil(r)
+#else
+#define PERFIL_INICIO(r)
+#define PERFIL_FIN(r)
+#endif
+
+/*
+ * Uso: PERFIL_INICIO(PERFIL_INDICE); ...; PERFIL_FIN(PERFIL_INDICE);
+ *
+ * Las regiones del ciclo principal incluyen el tiempo de las interrupciones
+ * que ocurran mientras corren, asi que su maximo es el peor caso real visto
+ * desde el ciclo principal. Una misma region no debe medirse a la vez desde
+ * el ciclo principal y desde la interrupcion.
+ */
+
+/**
+ * @brief Cierra la medición de una región iniciada con `PERFIL_INICIO()` y la acumula en la tabla.
+ *
+ * @param r Región (`PERFIL_INDICE`, `PERFIL_GLIFO`, ...).
+ *
+ * @pre `init_timer1()` debe haberse llamado previamente.
+ *
+ * @details Cuando la cuenta de la región llega a 65535 se dividen a la mitad la cuenta y la suma, de modo que el promedio se conserva y sigue siguiendo los cambios recientes. Las duraciones de 65536 cuentas o más (una vuelta del Timer1) no se distinguen de las cortas; con el preescalador en 1 son 65 ms.
+ *
+ * @note Se llama desde el ciclo principal y desde la interrupción (región `PERFIL_FILA`); XC8 genera una copia para cada contexto.
+ */
+void finPerfil(uint8_t r);
+/**
+ * @brief Copia el registro de una región sin que la interrupción lo cambie a la mitad.
+ *
+ * @param r Región.
+ * @param registro Variable donde se copia; una región sin mediciones tiene todos sus campos en 0.
+ */
+void leePerfil(uint8_t r, RegistroPerfil *registro);
+/** @brief Pone en cero la tabla de todas las regiones (al arranque ya está en cero). */
+void limpiaPerfil(void);
+
+#endif	/* XC_HEADER_TEMPLATE_H */
@@ -1,20 +1,113 @@
 #include "rs232.h"
 
+#define MASCARA_TX (RS232_TX_TAM - 1)
+
+static volatile unsigned char txBuffer[RS232_TX_TAM];
+static volatile unsigned char txCabeza = 0;   //solo la modifica el programa principal
+static volatile unsigned char txCola = 0;     //solo la modifica la interrupcion
+static unsigned int txDescartados = 0;
+static volatile unsigned int rxDesbordes = 0;
+
 void init_rs232(void)
 {
     //Configuracion para el puerto serial
-    SPBRG = 0x19; //9600 bps
-    TXSTA = 0x24; //transmision async habilitada
+    SPBRG = RS232_SPBRG(RS232_BAUDIOS);
+    TXSTA = RS232_BRGH(RS232_BAUDIOS) ? 0x24 : 0x20; //transmision async habilitada
     RCSTA = 0x90; //Recepcion async hailitada
     TRISBbits.TRISB1 = 1;  //RX
     TRISBbits.TRISB2 = 0;  //TX
+    PIE1bits.TXIE = 0;     //se habilita al encolar datos
+    PIE1bits.RCIE = 1;
+    INTCONbits.PEIE = 1;
+    INTCONbits.GIE = 1;
 }
 
+//Macros y no funciones: enviaRS232() es la ultima llamada de las respuestas
+//de comandos y no debe gastar otro nivel de la pila de hardware
+#define TX_LLENO() ((unsigned char)(txCabeza - txCola) >= RS232_TX_TAM)
+#define CUENTA_DESCARTADO() do { if (txDescartados != 0xFFFF) txDescartados++; } while (0)
+#define GUARDA_TX(dat) do { txBuffer[txCabeza & MASCARA_TX] = (dat); txCabeza++; PIE1bits.TXIE = 1; } while (0)
 
 void enviaRS232(unsigned char dat)
 {
-    while(!TXSTAbits.TRMT);  //Espera a que el buffer este vacio
-    TXREG = dat;   
+    PERFIL_INICIO(PERFIL_UART);
+    while(TX_LLENO())  //Espera a que haya lugar en el buffer
+        NOP();
+    GUARDA_TX(dat);
+    PERFIL_FIN(PERFIL_UART);
+}
+
+unsigned char enviaRS232NB(unsigned char dat)
+{
+#if RS232_POLITICA_TX == RS232_BLOQUEA
+    while(TX_LLENO())
+        NOP();
+#elif RS232_POLITICA_TX == RS232_SOBREESCRIBE
+    if (TX_LLENO())
+    {
+        //La cola la mueve la interrupcion; se detiene mientras se descarta
+        PIE1bits.TXIE = 0;
+        if (TX_LLENO())
+        {
+            txCola++;
+            CUENTA_DESCARTADO();
+        }
+    }
+#else
+    if (TX_LLENO())
+    {
+        CUENTA_DESCARTADO();
+        return 0;
+    }
+#endif
+    GUARDA_TX(dat);
+    return 1;
+}
+
+unsigned char espacioTxRS232(void)
+{
+    return RS232_TX_TAM - (unsigned char)(txCabeza - txCola);
+}
+
+void atiendeTxRS232(void)
+{
+    if (txCabeza != txCola)
+    {
+        TXREG = txBuffer[txCola & MASCARA_TX];
+        txCola++;
+    }
+    if (txCabeza == txCola)
+        PIE1bits.TXIE = 0;
+}
+
+unsigned char recibeRS232(void)
+{
+    if (RCSTAbits.OERR)
+    {
+        //Se perdio al menos un byte; reiniciar la recepcion limpia OERR
+        RCSTAbits.CREN = 0;
+        RCSTAbits.CREN = 1;
+        if (rxDesbordes != 0xFFFF)
+            rxDesbordes++;
+    }
+    return RCREG;
+}
+
+unsigned int desbordesRS232(void)
+{
+    unsigned int n;
+    
+    //El contador es de 16 bits: se relee si la interrupcion lo cambio a la mitad
+    do
+    {
+        n = rxDesbordes;
+    } while (n != rxDesbordes);
+    return n;
+}
+
+unsigned int descartadosRS232(void)
+{
+    return txDescartados;
 }
 
 void printCad(const char *cad)
@@ -26,20 +119,126 @@ void printCad(const char *cad)
     }
 }
 
-void enviaHexByte(unsigned char byte) {
-    unsigned char nibble;
+void printCadNB(const char *cad)
+{
+    unsigned char i = 0;
+    while(cad[i]!= 0){
+        enviaRS232NB(cad[i]);
+        i++;
+    }
+}
 
-    nibble = (byte >> 4) & 0x0F;
+static unsigned char nibbleHex(unsigned char nibble)
+{
     if (nibble < 10) {
-        enviaRS232('0' + nibble);
-    } else {
-        enviaRS232('A' + nibble - 10);
+        return '0' + nibble;
     }
+    return 'A' + nibble - 10;
+}
 
-    nibble = byte & 0x0F;
-    if (nibble < 10) {
-        enviaRS232('0' + nibble);
-    } else {
-        enviaRS232('A' + nibble - 10);
+void enviaHexByte(unsigned char byte) {
+    enviaRS232(nibbleHex((byte >> 4) & 0x0F));
+    enviaRS232(nibbleHex(byte & 0x0F));
+}
+
+void enviaHexByteNB(unsigned char byte) {
+    enviaRS232NB(nibbleHex((byte >> 4) & 0x0F));
+    enviaRS232NB(nibbleHex(byte & 0x0F));
+}
+
+#if RS232_AUTOBAUDIOS
+typedef struct {
+    unsigned long baudios;
+    uint8_t spbrg;
+    uint8_t brgh;
+} VelocidadRS232;
+
+//Velocidades que se pueden generar con este oscilador
+#define VELOCIDAD_RS232(b) { (b), RS232_SPBRG(b), RS232_BRGH(b) }
+static const VelocidadRS232 velocidades[] = {
+#if RS232_VALIDA(9600)
+    VELOCIDAD_RS232(9600),
+#endif
+#if RS232_VALIDA(19200)
+    VELOCIDAD_RS232(19200),
+#endif
+#if RS232_VALIDA(38400)
+    VELOCIDAD_RS232(38400),
+#endif
+#if RS232_VALIDA(57600)
+    VELOCIDAD_RS232(57600),
+#endif
+#if RS232_VALIDA(115200)
+    VELOCIDAD_RS232(115200),
+#endif
+};
+#define VELOCIDADES_RS232 (sizeof(velocidades) / sizeof(velocidades[0]))
+//Cuentas del Timer1 de dos bits a b bps
+#define CUENTAS_DOS_BITS(b) (uint16_t)(2000UL * TIMER1_CUENTAS_MS / (b))
+
+//Ancho en cuentas del Timer1 del primer pulso bajo en RX, o 0 si no llega
+//en las vueltas del Timer1 indicadas o la linea se queda en bajo
+static uint16_t midePulsoRx(unsigned int vueltas)
+{
+    uint16_t inicio;
+    
+    PIR1bits.TMR1IF = 0;
+    while (PORTBbits.RB1)
+    {
+        if (PIR1bits.TMR1IF)
+        {
+            PIR1bits.TMR1IF = 0;
+            if (--vueltas == 0)
+                return 0;
+        }
+    }
+    inicio = leeTimer1();
+    PIR1bits.TMR1IF = 0;
+    while (!PORTBbits.RB1)
+    {
+        if (PIR1bits.TMR1IF)
+            return 0;
+    }
+    return leeTimer1() - inicio;
+}
+
+unsigned long autobaudiosRS232(unsigned int esperaMs)
+{
+    //Vueltas del Timer1 (65536 cuentas) que caben en la espera
+    unsigned int vueltas = (unsigned long)esperaMs * TIMER1_CUENTAS_MS / 65536UL + 1;
+    uint16_t inicio, ancho, diferencia, menor = 0xFFFF;
+    uint8_t k, elegida = 0, gie = INTCONbits.GIE;
+    unsigned long baudios = 0;
+    
+    //Una interrupcion en medio del pulso lo alargaria
+    INTCONbits.GIE = 0;
+    RCSTAbits.CREN = 0;
+    ancho = midePulsoRx(vueltas);
+    for (k = 0; k < VELOCIDADES_RS232; k++)
+    {
+        diferencia = CUENTAS_DOS_BITS(velocidades[k].baudios);
+        diferencia = (ancho > diferencia) ? ancho - diferencia : diferencia - ancho;
+        if (diferencia < menor)
+        {
+            menor = diferencia;
+            elegida = k;
+        }
+    }
+    //Se rechaza un pulso a mas de un cuarto de la velocidad mas cercana
+    if (ancho != 0 && menor <= CUENTAS_DOS_BITS(velocidades[elegida].baudios) / 4)
+    {
+        baudios = velocidades[elegida].baudios;
+        SPBRG = velocidades[elegida].spbrg;
+        TXSTAbits.BRGH = velocidades[elegida].brgh;
+        //Se deja pasar el resto del 0x7E (ocho bits mas con el de paro)
+        inicio = leeTimer1();
+        while ((uint16_t)(leeTimer1() - inicio) < 4 * CUENTAS_DOS_BITS(baudios))
+            NOP();
     }
+    RCSTAbits.CREN = 1;
+    (void)RCREG;
+    (void)RCREG;
+    INTCONbits.GIE = gie;
+    return baudios;
 }
+#endif
@@ -11,94 +11,257 @@
 #define	RS232_H
 
 #include <xc.h> // include processor files - each processor file is guarded.  
+#include "perfil.h"
+
+#ifndef _XTAL_FREQ
+#define _XTAL_FREQ 4000000
+#endif
+
+//Buffer circular de transmision (potencia de 2), vaciado por la interrupcion TXIF.
+//Las respuestas largas de comandos.c se encolan por partes (ver espacioTxRS232())
+#define RS232_TX_TAM 8
+
+//Politicas cuando el buffer de transmision esta lleno
+#define RS232_DESCARTA 0      //se descarta el byte nuevo
+#define RS232_BLOQUEA 1       //se espera a que haya espacio
+#define RS232_SOBREESCRIBE 2  //se descarta el byte mas antiguo sin enviar
+#ifndef RS232_POLITICA_TX
+#define RS232_POLITICA_TX RS232_DESCARTA
+#endif
+
+//Velocidad del puerto serial en bps. SPBRG y BRGH se calculan con _XTAL_FREQ;
+//una velocidad que no se puede generar con un error menor a RS232_ERROR_MAX
+//no compila. Con el oscilador interno de 4 MHz solo 9600 y 19200 cumplen el
+//2 %; con un cristal de 20 MHz cumplen todas hasta 115200.
+#ifndef RS232_BAUDIOS
+#define RS232_BAUDIOS 9600
+#endif
+//Error maximo entre la velocidad real y la pedida, en milesimas (20 = 2 %)
+#ifndef RS232_ERROR_MAX
+#define RS232_ERROR_MAX 20
+#endif
+//1: init_rs232() no fija la velocidad de una vez; autobaudiosRS232() la mide
+//al arranque (ver su documentacion)
+#ifndef RS232_AUTOBAUDIOS
+#define RS232_AUTOBAUDIOS 0
+#endif
+//Tiempo que autobaudiosRS232() espera el byte de sincronia
+#ifndef RS232_AUTOBAUDIOS_MS
+#define RS232_AUTOBAUDIOS_MS 2000
+#endif
+
+//Generador de baudios: con BRGH=1 la velocidad es Fosc/(16 (SPBRG+1)); si
+//SPBRG no cabe en 8 bits se usa BRGH=0, Fosc/(64 (SPBRG+1)).
+#define RS232_DIVISOR_ALTO(b) ((_XTAL_FREQ / 16UL + (b) / 2) / (b))
+#define RS232_BRGH(b) (RS232_DIVISOR_ALTO(b) <= 256)
+#define RS232_DIVISOR(b) (RS232_BRGH(b) ? RS232_DIVISOR_ALTO(b) : (_XTAL_FREQ / 64UL + (b) / 2) / (b))
+#define RS232_SPBRG(b) (RS232_DIVISOR(b) - 1)
+#define RS232_REAL(b) (_XTAL_FREQ / (RS232_BRGH(b) ? 16UL : 64UL) / (RS232_DIVISOR(b) ? RS232_DIVISOR(b) : 1))
+#define RS232_ERROR(b) ((RS232_REAL(b) > (b) ? RS232_REAL(b) - (b) : (b) - RS232_REAL(b)) * 1000UL / (b))
+#define RS232_VALIDA(b) (RS232_DIVISOR(b) >= 1 && RS232_DIVISOR(b) <= 256 && RS232_ERROR(b) <= RS232_ERROR_MAX)
+
+#if !RS232_VALIDA(RS232_BAUDIOS)
+#error "RS232_BAUDIOS no se puede generar con _XTAL_FREQ dentro de RS232_ERROR_MAX"
+#endif
 
 /**
- * @brief Inicializa el mdulo USART (Universal Synchronous Asynchronous Receiver Transmitter) para la comunicacin RS-232 del PIC16F628A.
+ * @brief Inicializa el módulo USART (Universal Synchronous Asynchronous Receiver Transmitter) para la comunicación RS-232 del PIC16F628A.
  *
  * @pre Ninguna.
  *
- * @details Esta funcin configura el mdulo USART del microcontrolador para la comunicacin asncrona RS-232 a una velocidad de 9600 bps. Realiza las siguientes configuraciones:
- *   1. Configura el registro `SPBRG` para la velocidad de baudios de 9600 bps.
- *   2. Configura el registro `TXSTA` para habilitar la transmisin asncrona.
- *   3. Configura el registro `RCSTA` para habilitar la recepcin asncrona.
+ * @details Esta función configura el módulo USART del microcontrolador para la comunicación asíncrona RS-232 a la velocidad `RS232_BAUDIOS` (9600 bps si no se indica otra). Realiza las siguientes configuraciones:
+ *   1. Configura `SPBRG` y el bit `BRGH` de `TXSTA` con los valores que calcula `RS232_SPBRG()` a partir de `_XTAL_FREQ`.
+ *   2. Configura el registro `TXSTA` para habilitar la transmisión asíncrona.
+ *   3. Configura el registro `RCSTA` para habilitar la recepción asíncrona.
  *   4. Configura el pin RB1 como entrada (RX) y el pin RB2 como salida (TX).
+ *   5. Habilita la interrupción de recepción (`RCIE`) y las interrupciones de periféricos y globales. La interrupción de transmisión (`TXIE`) solo se activa mientras haya datos en el buffer.
  *
  * @code
- * init_rs232(); // Inicializa la comunicacin RS-232 a 9600 bps.
+ * init_rs232(); // Inicializa la comunicación RS-232 a RS232_BAUDIOS.
  * @endcode
  *
- * @note El valor de `SPBRG` (0x19) est calculado para una frecuencia de oscilador especfica. Si la frecuencia del oscilador es diferente, este valor debe recalcularse. Consultar la hoja de datos del microcontrolador para obtener la frmula de clculo y los valores correspondientes.
+ * @note `SPBRG` se calcula en tiempo de compilación con `_XTAL_FREQ`; si el oscilador es otro basta definir `_XTAL_FREQ` y `RS232_BAUDIOS` con -D. Una velocidad cuyo error supera `RS232_ERROR_MAX` detiene la compilación con `#error`.
  *
- * @remark Esta configuracin asume un modo de 8 bits de datos, sin paridad y 1 bit de stop. Para configuraciones diferentes (por ejemplo, con paridad), se deben modificar los registros `TXSTA` y `RCSTA` segn la hoja de datos del microcontrolador.
+ * @remark Esta configuración asume un modo de 8 bits de datos, sin paridad y 1 bit de stop. Para configuraciones diferentes (por ejemplo, con paridad), se deben modificar los registros `TXSTA` y `RCSTA` según la hoja de datos del microcontrolador.
  */
 void init_rs232(void);
 /**
- * @brief Enva un byte de datos a travs del puerto serial RS-232.
+ * @brief Envía un byte de datos a través del puerto serial RS-232.
  *
  * @param dat Byte de datos que se va a enviar.
  *
- * @pre El mdulo USART debe haber sido inicializado previamente con la funcin `init_rs232()`.
+ * @pre El módulo USART debe haber sido inicializado previamente con la función `init_rs232()`.
  *
- * @details Esta funcin enva un byte de datos a travs del puerto serial RS-232. Utiliza el registro `TXREG` para transmitir los datos y el bit `TRMT` (Transmit Shift Register Empty) del registro `TXSTA` para verificar si el buffer de transmisin est vaco antes de enviar un nuevo byte. El proceso es el siguiente:
- *   1. Se entra en un bucle `while` que espera a que el bit `TRMT` est a 1. Esto indica que el buffer de transmisin est vaco y listo para recibir un nuevo dato.
- *   2. Una vez que el buffer est vaco, se escribe el byte de datos `dat` en el registro `TXREG`. Esto inicia la transmisin del dato.
+ * @details Esta función coloca un byte en el buffer circular de transmisión, que la interrupción `TXIF` va vaciando hacia el registro `TXREG`. El proceso es el siguiente:
+ *   1. Si el buffer está lleno, se espera a que la interrupción libere un lugar.
+ *   2. Se guarda el byte en el buffer y se habilita la interrupción de transmisión (`TXIE`).
  *
  * @code
- * enviaRS232('A'); // Enva el carcter 'A'.
+ * enviaRS232('A'); // Envía el carácter 'A'.
  * unsigned char myByte = 0x42;
- * enviaRS232(myByte); // Enva el byte 0x42.
+ * enviaRS232(myByte); // Envía el byte 0x42.
  * @endcode
  *
- * @note Esta funcin bloquea la ejecucin del programa hasta que el buffer de transmisin est vaco. Si se necesita un manejo no bloqueante, se deben utilizar interrupciones o un enfoque diferente.
+ * @note Esta función solo se bloquea cuando el buffer está lleno, sin importar `RS232_POLITICA_TX`; conserva el orden con los bytes encolados por las variantes no bloqueantes. Las interrupciones deben estar habilitadas o la espera nunca termina.
  *
- * @remark Es importante asegurarse de que el dispositivo receptor est configurado con la misma velocidad de baudios y otros parmetros de comunicacin (bits de datos, paridad, bits de stop) que el transmisor.
+ * @remark Es importante asegurarse de que el dispositivo receptor esté configurado con la misma velocidad de baudios y otros parámetros de comunicación (bits de datos, paridad, bits de stop) que el transmisor.
  */
 void enviaRS232(unsigned char dat);
 /**
- * @brief Enva una cadena de caracteres a travs del puerto serial RS-232.
+ * @brief Envía una cadena de caracteres a través del puerto serial RS-232.
  *
  * @param cad Puntero constante a la cadena de caracteres que se va a enviar.
  *
- * @pre El mdulo USART debe haber sido inicializado previamente con la funcin `init_rs232()`.
+ * @pre El módulo USART debe haber sido inicializado previamente con la función `init_rs232()`.
  *
- * @details Esta funcin enva una cadena de caracteres terminada en nulo a travs del puerto serial RS-232. Itera sobre la cadena carcter por carcter, utilizando la funcin `enviaRS232()` para enviar cada carcter individualmente. El bucle contina hasta que se encuentra el carcter nulo ('\0'), que marca el final de la cadena.
+ * @details Esta función envía una cadena de caracteres terminada en nulo a través del puerto serial RS-232. Itera sobre la cadena carácter por carácter, utilizando la función `enviaRS232()` para enviar cada carácter individualmente. El bucle continúa hasta que se encuentra el carácter nulo ('\0'), que marca el final de la cadena.
  *
  * @code
- * printCad("Hola Mundo!"); // Enva la cadena "Hola Mundo!".
+ * printCad("Hola Mundo!"); // Envía la cadena "Hola Mundo!".
  * const char myString[] = "Otro ejemplo";
- * printCad(myString); // Enva la cadena "Otro ejemplo".
+ * printCad(myString); // Envía la cadena "Otro ejemplo".
  * @endcode
  *
- * @note Esta funcin depende de la funcin `enviaRS232()`, que tiene un comportamiento bloqueante. Por lo tanto, `printCad()` tambin bloquear la ejecucin del programa hasta que se haya enviado toda la cadena.
+ * @note Esta función depende de la función `enviaRS232()`, que se bloquea cuando el buffer de transmisión está lleno. Por lo tanto, `printCad()` bloqueará la ejecución del programa hasta que toda la cadena quepa en el buffer; para no bloquear se usa `printCadNB()`.
  *
- * @remark Es importante asegurarse de que la cadena `cad` est correctamente terminada en nulo. De lo contrario, la funcin podra intentar leer ms all del final de la cadena, lo que podra provocar un comportamiento indefinido.
+ * @remark Es importante asegurarse de que la cadena `cad` esté correctamente terminada en nulo. De lo contrario, la función podría intentar leer más allá del final de la cadena, lo que podría provocar un comportamiento indefinido.
  */
 void printCad(const char *cad);
 /**
- * @brief Enva un byte como dos caracteres hexadecimales a travs del puerto serial RS-232.
+ * @brief Envía un byte como dos caracteres hexadecimales a través del puerto serial RS-232.
  *
  * @param byte Byte que se va a enviar en formato hexadecimal.
  *
- * @pre El mdulo USART debe haber sido inicializado previamente con la funcin `init_rs232()`.
+ * @pre El módulo USART debe haber sido inicializado previamente con la función `init_rs232()`.
  *
- * @details Esta funcin convierte un byte en su representacin hexadecimal de dos caracteres y los enva a travs del puerto serial RS-232. El proceso es el siguiente:
- *   1. Se extrae el nibble alto (4 bits ms significativos) del byte usando un desplazamiento a la derecha y una mscara AND.
+ * @details Esta función convierte un byte en su representación hexadecimal de dos caracteres y los envía a través del puerto serial RS-232. El proceso es el siguiente:
+ *   1. Se extrae el nibble alto (4 bits más significativos) del byte usando un desplazamiento a la derecha y una máscara AND.
  *   2. Se verifica si el nibble es menor que 10.
- *     a. Si es menor que 10, se convierte a su representacin ASCII sumndole el cdigo ASCII del carcter '0'.
- *     b. Si es mayor o igual a 10, se convierte a su representacin ASCII sumndole el cdigo ASCII del carcter 'A' y restndole 10.
- *   3. Se enva el carcter resultante a travs de la funcin `enviaRS232()`.
+ *     a. Si es menor que 10, se convierte a su representación ASCII sumándole el código ASCII del carácter '0'.
+ *     b. Si es mayor o igual a 10, se convierte a su representación ASCII sumándole el código ASCII del carácter 'A' y restándole 10.
+ *   3. Se envía el carácter resultante a través de la función `enviaRS232()`.
  *   4. Se repiten los pasos 1-3 para el nibble bajo (4 bits menos significativos) del byte.
  *
  * @code
  * unsigned char myByte = 0xAF;
- * enviaHexByte(myByte); // Enva los caracteres 'A' y 'F' a travs del puerto serial.
+ * enviaHexByte(myByte); // Envía los caracteres 'A' y 'F' a través del puerto serial.
  * @endcode
  *
- * @note Esta funcin depende de la funcin `enviaRS232()`, que tiene un comportamiento bloqueante. Por lo tanto, `enviaHexByte()` tambin bloquear la ejecucin del programa hasta que se hayan enviado los dos caracteres.
+ * @note Esta función depende de la función `enviaRS232()`, que se bloquea cuando el buffer de transmisión está lleno. Para no bloquear se usa `enviaHexByteNB()`.
  *
- * @remark Esta funcin utiliza caracteres ASCII '0'-'9' y 'A'-'F' para representar los valores hexadecimales.
+ * @remark Esta función utiliza caracteres ASCII '0'-'9' y 'A'-'F' para representar los valores hexadecimales.
  */
 void enviaHexByte(unsigned char byte);
 
+/**
+ * @brief Envía un byte sin bloquear, aplicando la política de desbordamiento configurada.
+ *
+ * @param dat Byte de datos que se va a enviar.
+ *
+ * @pre El módulo USART debe haber sido inicializado previamente con la función `init_rs232()`.
+ *
+ * @details Coloca el byte en el buffer de transmisión. Si el buffer está lleno se aplica `RS232_POLITICA_TX`:
+ *   - `RS232_DESCARTA`: el byte nuevo se pierde.
+ *   - `RS232_BLOQUEA`: se espera a que haya espacio, igual que `enviaRS232()`.
+ *   - `RS232_SOBREESCRIBE`: se pierde el byte más antiguo que aún no se envía.
+ *
+ * Cada byte perdido incrementa el contador que regresa `descartadosRS232()`.
+ *
+ * @return 1 si el byte quedó en el buffer, 0 si se descartó.
+ *
+ * @code
+ * enviaRS232NB('A');
+ * @endcode
+ */
+unsigned char enviaRS232NB(unsigned char dat);
+/**
+ * @brief Variante no bloqueante de `printCad()`.
+ *
+ * @param cad Puntero constante a la cadena de caracteres terminada en nulo que se va a enviar.
+ *
+ * @details Encola cada carácter con `enviaRS232NB()`, por lo que regresa en cuanto la cadena está en el buffer (o descartada según `RS232_POLITICA_TX`) sin esperar a que se transmita.
+ *
+ * @code
+ * printCadNB("dir: "); enviaHexByteNB(0x1A);
+ * @endcode
+ */
+void printCadNB(const char *cad);
+/**
+ * @brief Variante no bloqueante de `enviaHexByte()`.
+ *
+ * @param byte Byte que se va a enviar en formato hexadecimal.
+ *
+ * @details Encola los dos caracteres hexadecimales con `enviaRS232NB()`.
+ */
+void enviaHexByteNB(unsigned char byte);
+/**
+ * @brief Regresa cuántos bytes caben en el buffer de transmisión sin esperar.
+ *
+ * @details Permite a quien envía una respuesta larga encolarla por partes: si no cabe la parte siguiente, regresa y lo intenta en otra vuelta del ciclo principal en lugar de quedarse esperando en `enviaRS232()`. La interrupción solo puede aumentar el espacio después de la lectura.
+ *
+ * @return Bytes libres, entre 0 y `RS232_TX_TAM`.
+ */
+unsigned char espacioTxRS232(void);
+/**
+ * @brief Atiende la interrupción de transmisión enviando el siguiente byte del buffer.
+ *
+ * @pre Debe llamarse únicamente desde la rutina de interrupción, cuando `PIE1bits.TXIE` y `PIR1bits.TXIF` estén activos.
+ *
+ * @details Escribe en `TXREG` el byte más antiguo del buffer (lo que limpia `TXIF`). Cuando el buffer queda vacío deshabilita `TXIE` para que la interrupción no se repita.
+ *
+ * @code
+ * if (PIE1bits.TXIE && PIR1bits.TXIF)
+ *     atiendeTxRS232();
+ * @endcode
+ */
+void atiendeTxRS232(void);
+/**
+ * @brief Lee el byte recibido por el puerto serial, recuperándose de un desbordamiento.
+ *
+ * @pre Debe llamarse desde la rutina de interrupción cuando `PIR1bits.RCIF` esté activo.
+ *
+ * @details Si el bit `OERR` indica que se perdieron datos, reinicia la recepción (`CREN`) e incrementa el contador de desbordamientos. Después lee `RCREG`, lo que limpia `RCIF`.
+ *
+ * @return El byte recibido.
+ *
+ * @code
+ * if (PIE1bits.RCIE && PIR1bits.RCIF)
+ *     procesaByteComando(recibeRS232());
+ * @endcode
+ */
+unsigned char recibeRS232(void);
+/**
+ * @brief Regresa el número de desbordamientos de recepción (`OERR`) detectados.
+ *
+ * @return Contador de desbordamientos desde el arranque (se satura en 0xFFFF).
+ */
+unsigned int desbordesRS232(void);
+#if RS232_AUTOBAUDIOS
+/**
+ * @brief Mide la velocidad del equipo conectado con un byte de sincronía y configura el USART con ella.
+ *
+ * @param esperaMs Milisegundos que se espera el byte antes de rendirse.
+ *
+ * @pre `init_rs232()` e `init_timer1()` deben haberse llamado previamente; se llama al arranque, antes de `init_pantalla()`, porque deshabilita las interrupciones mientras mide.
+ *
+ * @details El equipo envía un 0x7E suelto (la sincronía de las tramas, por ejemplo con `programa.py --autobaudios`). En la línea, su bit de inicio y su bit 0 forman un pulso bajo de dos bits; la función mide ese pulso en el pin RX con el Timer1 y elige la velocidad más cercana entre 9600, 19200, 38400, 57600 y 115200, solo entre las que cumplen `RS232_ERROR_MAX` con `_XTAL_FREQ`. Después deja pasar el resto del byte y vuelve a habilitar la recepción.
+ *
+ * @return La velocidad elegida en bps, o 0 si no llegó el byte o el pulso no corresponde a ninguna velocidad; en ese caso se conserva `RS232_BAUDIOS`.
+ *
+ * @code
+ * init_rs232();
+ * init_timer1();
+ * autobaudiosRS232(RS232_AUTOBAUDIOS_MS);
+ * @endcode
+ */
+unsigned long autobaudiosRS232(unsigned int esperaMs);
+#endif
+/**
+ * @brief Regresa el número de bytes perdidos por desbordamiento del buffer de transmisión.
+ *
+ * @return Contador de bytes descartados desde el arranque (se satura en 0xFFFF).
+ */
+unsigned int descartadosRS232(void);
+
 #endif	/* XC_HEADER_TEMPLATE_H */
 
@@ -0,0 +1,601 @@
+/*
+ * File:   banco.c
+ * Author:
+ * Comments: Banco de pruebas de rendimiento del firmware de matrizv3 sobre el
+ *           simulador (ver sim.h para la linea de compilacion).
+ * Revision history:
+ */
+
+//El firmware se compila con -Dmain=main_firmware; aqui se necesita el main de la PC
+#undef main
+
+#include <stdio.h>
+#include "sim.h"
+#include "../matrizLed.h"
+#include "../pantalla.h"
+#include "../marquesina.h"
+#include "../comandos.h"
+#include "../cacheGlifos.h"
+#include "../timer1.h"
+#include "../tareas.h"
+
+#define CARACTERES "ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789"
+
+//Tabla de tareas de main.c
+extern const Tarea tareasPrincipales[];
+extern const uint8_t numTareasPrincipales;
+
+static double us(uint64_t c)
+{
+    return (double)c * 1e6 / SIM_CICLOS_POR_SEGUNDO;
+}
+
+//Mismo arranque que main()
+static void arranque(void)
+{
+    PCONbits.OSCF = 1;
+    TRISB = 0x00;
+    init_93lc66b();
+    init_rs232();
+    init_comandos();
+    init_timer1();
+    CS = 0;
+    DI = 0;
+    SK = 0;
+    init_matrizLed();
+    init_pantalla();
+    init_tareas(tareasPrincipales, numTareasPrincipales);
+}
+
+//Vueltas del planificador de main(); el reloj avanza lo que tardaria cada vuelta
+static void cicloPrincipal(unsigned long ciclos)
+{
+    uint64_t fin = sim_ciclos() + ciclos;
+    while (sim_ciclos() < fin)
+    {
+        despachaTareas();
+        sim_espera_ciclos(20);
+    }
+}
+
+//Invalida la cabecera de la EEPROM interna; init_matrizLed() vacia las ranuras
+static void vaciaRanuras(void)
+{
+    escribeEEInterna(CACHE_DIR_GLIFOS, 0);
+    init_matrizLed();
+}
+
+//Peor tiempo de cada tarea contra su presupuesto
+static void imprimeTareas(void)
+{
+    uint8_t k;
+
+    for (k = 0; k < numTareas(); k++)
+        printf("   tarea %u: peor %5lu us, presupuesto %5lu us, %u excesos\n", k,
+               peorTarea(k) * 1000UL / TIMER1_CUENTAS_MS,
+               tareasPrincipales[k].presupuesto * 1000UL / TIMER1_CUENTAS_MS, excesosTarea(k));
+}
+
+static void bancoIndice(void)
+{
+    uint64_t t0 = sim_ciclos();
+    init_matrizLed();
+    printf("indice de caracteres (init_matrizLed)  %10.0f us  %lu palabras EEPROM, %u glifos\n",
+           us(sim_ciclos() - t0), sim_estadisticas()->palabrasEeprom, glifosFuente());
+}
+
+//Dos vueltas por los mismos caracteres, con las ranuras vacias: en la primera
+//se leen de la 93LC66B y el planificador graba las ranuras entre una carga y
+//otra (50 ms, lo que tarda un caracter de la marquesina), en la segunda los
+//que quedaron en las ranuras ya no tocan la 93LC66B
+static void bancoGlifos(void)
+{
+    uint8_t columnas[8];
+    const char *c;
+    uint64_t t0, total, peor;
+    unsigned int n, vuelta, aciertos;
+
+    vaciaRanuras();
+    for (vuelta = 1; vuelta <= 2; vuelta++)
+    {
+        total = peor = 0;
+        n = 0;
+        aciertos = aciertosCacheGlifos();
+        for (c = CARACTERES; *c; c++)
+        {
+            t0 = sim_ciclos();
+            cargaGlifo(*c, columnas);
+            t0 = sim_ciclos() - t0;
+            total += t0;
+            if (t0 > peor)
+                peor = t0;
+            n++;
+            cicloPrincipal(SIM_CICLOS_POR_SEGUNDO / 20);
+        }
+        printf("carga de glifo (cargaGlifo), vuelta %u  %10.0f us  promedio, %.0f us peor, %u de EEPROM interna\n",
+               vuelta, us(total) / n, us(peor), aciertosCacheGlifos() - aciertos);
+    }
+}
+
+static void bancoRefresco(void)
+{
+    uint8_t *cuadro = bufferPantalla();
+    const sim_estadisticas_t *e = sim_estadisticas();
+    uint64_t t0;
+    unsigned int p;
+
+    //Un caracter por panel
+    for (p = 0; p < PANELES; p++)
+        cargaGlifo(CARACTERES[p], cuadro + p * FILAS_PANEL);
+    intercambiaPantalla();
+    sim_limpia_estadisticas();
+    t0 = sim_ciclos();
+    esperaCuadros(CUADROS_POR_SEGUNDO);
+    t0 = sim_ciclos() - t0;
+    printf("refresco                               %10.1f cuadros/s  %lu filas, CPU en ISR %.1f %%\n",
+           CUADROS_POR_SEGUNDO / (t0 / (double)SIM_CICLOS_POR_SEGUNDO), e->filas,
+           100.0 * e->ciclosIsr / t0);
+    sim_matriz_imprime(stdout);
+}
+
+static void bancoFila(void)
+{
+    uint8_t catodos[PANELES] = { 0 };
+    uint64_t t0 = sim_ciclos();
+
+    H595Paneles(catodos, 0x01);
+    printf("fila de los 74HC595 (H595Paneles)      %10.0f us  %d paneles\n",
+           us(sim_ciclos() - t0), PANELES);
+}
+
+//Rampa de grises en las 8 filas del panel 0; reporta el brillo medido de cada
+//nivel contra el maximo con varios brillos globales. Con brillo 0 todo debe
+//quedar apagado.
+static void bancoGrises(void)
+{
+    const sim_estadisticas_t *e = sim_estadisticas();
+    static const unsigned int brillos[] = { PANTALLA_BRILLO_MAX, PANTALLA_BRILLO_MAX / 2,
+                                            PANTALLA_BRILLO_MAX / 4, PANTALLA_BRILLO_MAX / 16, 0 };
+    unsigned int c, b, k, nivel, brillo;
+    double medido, anterior;
+    unsigned int nivelAnterior;
+    int monotono;
+    unsigned int encendidos;
+    uint64_t t0;
+
+    for (c = 0; c < FILAS_PANTALLA; c++)
+        for (b = 0; b < 8; b++)
+            pixelPantalla(c, b, c < FILAS_PANEL ? c * (PANTALLA_NIVELES - 1) / (FILAS_PANEL - 1) : 0);
+    intercambiaGrisesPantalla();
+    for (k = 0; k < sizeof brillos / sizeof brillos[0]; k++)
+    {
+        brillo = brillos[k];
+        brilloPantalla(brillo);
+        esperaCuadros(1);
+        sim_limpia_estadisticas();
+        t0 = sim_ciclos();
+        esperaCuadros(CUADROS_POR_SEGUNDO);
+        t0 = sim_ciclos() - t0;
+        printf("grises %d bits, brillo %3u             %10.1f cuadros/s  CPU en ISR %.1f %%, %lu interrupciones\n",
+               PANTALLA_BITS, brillo, CUADROS_POR_SEGUNDO / (t0 / (double)SIM_CICLOS_POR_SEGUNDO),
+               100.0 * e->ciclosIsr / t0, e->interrupciones);
+        printf("   nivel/brillo medido:");
+        anterior = 0;
+        nivelAnterior = 0;
+        monotono = 1;
+        encendidos = 0;
+        for (c = 0; c < FILAS_PANEL; c++)
+        {
+            nivel = c * (PANTALLA_NIVELES - 1) / (FILAS_PANEL - 1);
+            medido = sim_matriz_brillo(c, 0) * 8;
+            //Un nivel mayor debe verse mas brillante que el anterior
+            if (nivel > nivelAnterior && medido <= anterior)
+                monotono = 0;
+            encendidos += medido > 0;
+            anterior = medido;
+            nivelAnterior = nivel;
+            printf("  %u/%.2f", nivel, medido);
+        }
+        if (brillo == 0)
+            printf("%s\n", encendidos == 0 ? "  apagada" : "  NO APAGADA");
+        else
+            printf("%s\n", monotono ? "" : "  NO MONOTONO");
+    }
+    brilloPantalla(PANTALLA_BRILLO_MAX);
+}
+
+static void bancoCache(void)
+{
+    const sim_estadisticas_t *e = sim_estadisticas();
+    unsigned long primera;
+    unsigned int aciertos = aciertosCacheGlifos();
+
+    sim_limpia_estadisticas();
+    printCad93LC66B("HOLA");
+    primera = e->palabrasEeprom;
+    sim_limpia_estadisticas();
+    printCad93LC66B("HOLA");
+    printf("printCad93LC66B(\"HOLA\") 1a/2a vez     %10lu / %lu palabras EEPROM, %u glifos de la EEPROM interna\n",
+           primera, e->palabrasEeprom, aciertosCacheGlifos() - aciertos);
+}
+
+static void bancoMarquesina(void)
+{
+    static const char texto[] = "MONTY 2025 ";
+    const sim_estadisticas_t *e = sim_estadisticas();
+    uint64_t fin, t0, peor = 0;
+    uint8_t columnas[ANCHO_MAX_GLIFO];
+    unsigned int vuelta = 0, ancho;
+    const char *c;
+
+    //Columnas de una vuelta con la fuente proporcional
+    for (c = texto; *c; c++)
+    {
+        ancho = cargaGlifo(*c, columnas);
+        vuelta += (ancho ? ancho : ANCHO_SIN_GLIFO) + SEPARACION_GLIFOS;
+    }
+    iniciaMarquesina(texto, 20);
+    sim_limpia_estadisticas();
+    fin = sim_ciclos() + 2 * SIM_CICLOS_POR_SEGUNDO;
+    //Peor duracion de una llamada: lo que se retrasa el resto del ciclo principal
+    while (sim_ciclos() < fin)
+    {
+        atiendeComandos();
+        t0 = sim_ciclos();
+        actualizaMarquesina();
+        t0 = sim_ciclos() - t0;
+        if (t0 > peor)
+            peor = t0;
+        pasoCacheGlifos();
+        sim_espera_ciclos(20);
+    }
+    printf("marquesina 20 col/s, 2 s               %10lu palabras EEPROM, %.0f us peor llamada\n",
+           e->palabrasEeprom, us(peor));
+    printf("   %u columnas por vuelta, %.1f caracteres/s\n", vuelta, 20.0 * (sizeof texto - 1) / vuelta);
+}
+
+//Aciertos de cada nivel de la carga de glifos desde el arranque
+static void bancoNiveles(void)
+{
+    const sim_estadisticas_t *e = sim_estadisticas();
+    unsigned int ai = aciertosCacheGlifos(), fi = fallosCacheGlifos();
+
+    printf("niveles: EEPROM interna %u/%u glifos\n", ai, ai + fi);
+    printf("   %lu lecturas y %lu bytes grabados de la EEPROM interna desde la ultima limpieza\n",
+           e->lecturasEEInterna, e->escriturasEEInterna);
+}
+
+static void bancoUart(void)
+{
+    static const char texto[] = "0123456789ABCDEF0123456789ABCDEF0123456789ABCDEF0123456789ABCDEF";
+    unsigned int n;
+    uint64_t t0, bloqueo;
+
+    sim_uart_limpia();
+    t0 = sim_ciclos();
+    printCad(texto);
+    bloqueo = sim_ciclos() - t0;
+    do
+    {
+        sim_espera_ciclos(100);
+        sim_uart_datos(&n);
+    } while (n < sizeof texto - 1);
+    t0 = sim_ciclos() - t0;
+    printf("UART printCad(%u bytes)                %10.0f us bloqueado, %.0f bytes/s\n",
+           (unsigned int)(sizeof texto - 1), us(bloqueo),
+           n / (t0 / (double)SIM_CICLOS_POR_SEGUNDO));
+}
+
+//Espera a que el USART termine de enviar n bytes; regresa los ciclos desde t0
+static uint64_t esperaUart(unsigned int n, uint64_t t0)
+{
+    unsigned int recibidos;
+
+    do
+    {
+        sim_espera_ciclos(100);
+        sim_uart_datos(&recibidos);
+    } while (recibidos < n);
+    return sim_ciclos() - t0;
+}
+
+//32 muestras en tramas 'L' contra las mismas en hexadecimal con enviaHexByte()
+static void bancoTelemetria(void)
+{
+    MuestraTelemetria muestras[32];
+    const uint8_t *d;
+    unsigned int n, k, validas = 0, recibidas = 0;
+    uint64_t t0, tTramas, tHex;
+    uint8_t c;
+
+    for (k = 0; k < 32; k++)
+    {
+        muestras[k].id = k & 3;
+        muestras[k].valor = 7 * k;
+    }
+    sim_uart_limpia();
+    t0 = sim_ciclos();
+    enviaMuestrasTelemetria(muestras, 32);
+    n = 4 * ((32 + TELEMETRIA_MAX_MUESTRAS - 1) / TELEMETRIA_MAX_MUESTRAS) + 2 * 32;
+    tTramas = esperaUart(n, t0);
+    //Se revisa cada trama como lo haria herramientas/telemetria.py
+    d = sim_uart_datos(&n);
+    for (k = 0; k + 4 <= n; k += 4 + d[k + 1])
+    {
+        unsigned int j;
+        if (d[k] != TRAMA_SYNC || k + 4 + d[k + 1] > n)
+            break;
+        c = 0;
+        for (j = 1; j < 3u + d[k + 1]; j++)
+            c = actualizaCRC8(c, d[k + j]);
+        if (c == d[k + 3 + d[k + 1]] && d[k + 2] == TELEMETRIA_MUESTRAS)
+        {
+            validas++;
+            recibidas += d[k + 1] / 2;
+        }
+    }
+    printf("telemetria 32 muestras en tramas 'L'    %10.0f us  %u bytes, %u tramas validas, %u muestras\n",
+           us(tTramas), n, validas, recibidas);
+    sim_uart_limpia();
+    t0 = sim_ciclos();
+    for (k = 0; k < 32; k++)
+    {
+        enviaHexByte(muestras[k].id);
+        enviaHexByte(muestras[k].valor);
+    }
+    tHex = esperaUart(4 * 32, t0);
+    printf("   en hexadecimal (enviaHexByte)       %10.0f us  %u bytes\n", us(tHex), 4 * 32);
+}
+
+static void bancoComando(void)
+{
+    //Trama 'E' (estadisticas): 7E 00 45 CRC
+    static const uint8_t trama[] = { 0x7E, 0x00, 0x45, 0xDC };
+    unsigned int n;
+    uint64_t t0;
+
+    sim_uart_limpia();
+    sim_uart_inyecta(trama, sizeof trama);
+    t0 = sim_ciclos();
+    //Respuesta: sincronia, longitud, tipo, 7 contadores de 16 bits y CRC
+    do
+    {
+        cicloPrincipal(100);
+        sim_uart_datos(&n);
+    } while (n < 4 + 2 * 7 && sim_ciclos() - t0 < SIM_CICLOS_POR_SEGUNDO);
+    printf("comando 'E' ida y vuelta               %10.0f us  %u bytes de respuesta\n",
+           us(sim_ciclos() - t0), n);
+}
+
+static uint8_t crc8(const uint8_t *dat, unsigned int n)
+{
+    uint8_t c = 0, k;
+    while (n--)
+    {
+        c ^= *dat++;
+        for (k = 0; k < 8; k++)
+            c = (c & 0x80) ? (c << 1) ^ 0x07 : c << 1;
+    }
+    return c;
+}
+
+//Envia una trama de comando y espera su respuesta; regresa el tipo recibido
+static uint8_t enviaTrama(uint8_t tipo, const uint8_t *datos, uint8_t n, uint8_t *respuesta)
+{
+    uint8_t trama[COMANDO_MAX_DATOS + 4];
+    const uint8_t *r;
+    unsigned int k, recibidos;
+    uint64_t t0 = sim_ciclos();
+
+    trama[0] = COMANDO_SYNC;
+    trama[1] = n;
+    trama[2] = tipo;
+    for (k = 0; k < n; k++)
+        trama[3 + k] = datos[k];
+    trama[3 + n] = crc8(trama + 1, n + 2);
+    sim_uart_limpia();
+    sim_uart_inyecta(trama, n + 4);
+    do
+    {
+        cicloPrincipal(100);
+        r = sim_uart_datos(&recibidos);
+    } while ((recibidos < 3 || recibidos < 4u + r[1]) && sim_ciclos() - t0 < SIM_CICLOS_POR_SEGUNDO);
+    if (recibidos < 4)
+        return 0;
+    if (respuesta != 0 && r[1] > 0)
+        *respuesta = r[3];
+    return r[2];
+}
+
+//Graba la imagen con tramas 'P' como herramientas/programa.py; regresa las
+//palabras escritas o -1 si alguna trama fallo
+static long programaPorUart(const uint8_t *imagen, unsigned int longitud)
+{
+    uint8_t datos[COMANDO_MAX_DATOS], escritas;
+    unsigned int dir, k, n;
+    long total = 0;
+
+    for (dir = 0; dir < longitud; dir += 2 * PROGRAMA_MAX_PALABRAS)
+    {
+        n = longitud - dir;
+        if (n > 2 * PROGRAMA_MAX_PALABRAS)
+            n = 2 * PROGRAMA_MAX_PALABRAS;
+        datos[0] = dir & 0xFF;
+        datos[1] = dir >> 8;
+        for (k = 0; k < n; k++)
+            datos[2 + k] = imagen[dir + k];
+        if (enviaTrama(COMANDO_PROGRAMA, datos, n + 2, &escritas) != COMANDO_PROGRAMA)
+            return -1;
+        total += escritas;
+    }
+    return total;
+}
+
+//Borra la EEPROM con ERAL, la vuelve a grabar por el puerto serial y la
+//regraba sin cambios (solo lecturas de comparacion)
+static void bancoPrograma(void)
+{
+    const sim_estadisticas_t *e = sim_estadisticas();
+    static uint8_t imagen[2 * SIM_PALABRAS_EEPROM];
+    unsigned int longitud, k;
+    uint8_t glifos = 0;
+    long escritas, sinCambios;
+    uint64_t t0, tEral, tGraba, tRegraba;
+
+    for (k = 0; k < SIM_PALABRAS_EEPROM; k++)
+    {
+        imagen[2 * k] = sim_eeprom_palabra(k) & 0xFF;
+        imagen[2 * k + 1] = sim_eeprom_palabra(k) >> 8;
+    }
+    longitud = imagen[4] | (imagen[5] << 8);
+    if (longitud > sizeof imagen)
+    {
+        printf("grabar imagen por UART                 la imagen no cabe en la EEPROM\n");
+        return;
+    }
+    sim_limpia_estadisticas();
+    t0 = sim_ciclos();
+    habilitaEscritura93LC66B();
+    borraTodo93LC66B();
+    esperaListo93LC66B();
+    protegeEscritura93LC66B();
+    tEral = sim_ciclos() - t0;
+    t0 = sim_ciclos();
+    escritas = programaPorUart(imagen, longitud);
+    enviaTrama(COMANDO_RECARGA, 0, 0, &glifos);
+    tGraba = sim_ciclos() - t0;
+    t0 = sim_ciclos();
+    sinCambios = programaPorUart(imagen, longitud);
+    tRegraba = sim_ciclos() - t0;
+    for (k = 0; k < longitud / 2; k++)
+        if (sim_eeprom_palabra(k) != (imagen[2 * k] | (imagen[2 * k + 1] << 8)))
+            break;
+    printf("grabar imagen por UART (%u bytes)      %10.0f ms  %ld palabras, %lu ciclos de escritura, %u glifos, %s\n",
+           longitud, us(tGraba) / 1000, escritas, e->escriturasEeprom - 1, glifos,
+           k == longitud / 2 ? "verificada" : "DIFERENTE");
+    printf("   ERAL %.1f ms; regrabar sin cambios %.0f ms, %ld palabras escritas\n",
+           us(tEral) / 1000, us(tRegraba) / 1000, sinCambios);
+}
+
+//Dos segundos de marquesina desde un arranque en frio (ranuras de la EEPROM
+//interna vacias) con tramas 'E', 'P' y 'M' a la mitad
+//('P' deja la marquesina en blanco y 'M' la reinicia):
+//peor tiempo de cada tarea contra su presupuesto y paradas de la ventana de
+//la pantalla
+static void bancoTareas(void)
+{
+    static const char texto[] = "HOLA";
+    const sim_estadisticas_t *e = sim_estadisticas();
+    uint8_t datos[2 + 2 * 4], k, r = 0;
+    unsigned int dir = M93_BYTES - 8, paradas;
+    unsigned long escrituras;
+
+    vaciaRanuras();
+    escrituras = e->escriturasEEInterna;
+    limpiaTareas();
+    paradas = paradasVentana();
+    iniciaMarquesina("MONTY 2025 ", 20);
+    cicloPrincipal(SIM_CICLOS_POR_SEGUNDO);
+    enviaTrama(COMANDO_ESTADISTICAS, 0, 0, 0);
+    //Cuatro palabras al final de la EEPROM, fuera de la imagen
+    datos[0] = dir & 0xFF;
+    datos[1] = dir >> 8;
+    for (k = 0; k < 8; k++)
+        datos[2 + k] = (sim_eeprom_palabra(dir / 2 + k / 2) >> (8 * (k & 1))) ^ 0x5A;
+    enviaTrama(COMANDO_PROGRAMA, datos, sizeof datos, &r);
+    enviaTrama(COMANDO_MENSAJE, (const uint8_t *)texto, sizeof texto - 1, 0);
+    cicloPrincipal(SIM_CICLOS_POR_SEGUNDO);
+    printf("planificador 2 s en frio, tramas E P M %10u paradas de la pantalla, P escribio %u palabras\n",
+           paradasVentana() - paradas, r);
+    printf("   %lu bytes internos grabados\n", e->escriturasEEInterna - escrituras);
+    imprimeTareas();
+}
+
+#if PERFIL_ACTIVO
+//Tabla del perfilador desde el arranque, leida con el comando 'F' como
+//herramientas/perfil.py
+static void bancoPerfil(void)
+{
+    static const char *nombres[PERFIL_REGIONES] = { "indice", "glifo", "fila", "uart" };
+    static const uint8_t limpia = 1;
+    RegistroPerfil registro;
+    uint8_t r;
+
+    //La respuesta de 'F' pasa por enviaRS232: se lee la tabla antes de pedirla
+    printf("perfil (region: cuenta, min/prom/max us)\n");
+    for (r = 0; r < PERFIL_REGIONES; r++)
+    {
+        leePerfil(r, &registro);
+        if (registro.cuenta == 0)
+        {
+            printf("   %-7s %6u\n", nombres[r], 0);
+            continue;
+        }
+        printf("   %-7s %6u  %6.0f / %7.1f / %6.0f\n", nombres[r], registro.cuenta,
+               registro.minimo * 1000.0 / TIMER1_CUENTAS_MS,
+               registro.suma * 1000.0 / TIMER1_CUENTAS_MS / registro.cuenta,
+               registro.maximo * 1000.0 / TIMER1_CUENTAS_MS);
+    }
+    r = 0;
+    enviaTrama(COMANDO_PERFIL, &limpia, 1, &r);
+    printf("   comando 'F': %u regiones en la respuesta\n", r);
+}
+#endif
+
+#if RS232_AUTOBAUDIOS
+//Un 0x7E desde la PC a cada velocidad y una trama 'E' ya a la velocidad medida
+static void bancoAutobaudios(void)
+{
+    static const unsigned long pruebas[] = { 19200, 9600, 19200 };
+    static const uint8_t sync = TRAMA_SYNC;
+    unsigned long medida;
+    unsigned int k;
+    uint8_t respuesta;
+
+    for (k = 0; k < sizeof pruebas / sizeof pruebas[0]; k++)
+    {
+        sim_uart_baudios(pruebas[k]);
+        sim_uart_inyecta(&sync, 1);
+        medida = autobaudiosRS232(RS232_AUTOBAUDIOS_MS);
+        respuesta = enviaTrama(COMANDO_ESTADISTICAS, 0, 0, 0);
+        printf("autobaudios PC a %6lu bps               %10lu bps medidos, SPBRG %u BRGH %u, respuesta '%c'\n",
+               pruebas[k], medida, SPBRG, TXSTAbits.BRGH, respuesta ? respuesta : '-');
+    }
+    sim_uart_baudios(0);
+    init_rs232();
+}
+#endif
+
+int main(int argc, char **argv)
+{
+    const char *imagen = argc > 1 ? argv[1] : "tabla_leds.bin";
+
+    if (sim_inicia(imagen) != 0)
+    {
+        fprintf(stderr, "no se pudo abrir %s\n", imagen);
+        return 1;
+    }
+    arranque();
+    printf("arranque                               %10.0f us\n", us(sim_ciclos()));
+    sim_limpia_estadisticas();
+    bancoIndice();
+    bancoGlifos();
+    bancoFila();
+    bancoRefresco();
+    bancoGrises();
+    bancoCache();
+    bancoMarquesina();
+    bancoNiveles();
+    bancoUart();
+    bancoTelemetria();
+    bancoComando();
+    bancoPrograma();
+    bancoTareas();
+#if PERFIL_ACTIVO
+    bancoPerfil();
+#endif
+#if RS232_AUTOBAUDIOS
+    bancoAutobaudios();
+#endif
+    return 0;
+}
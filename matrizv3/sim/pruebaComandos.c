@@ -0,0 +1,235 @@
+/*
+ * File:   pruebaComandos.c
+ * Author:
+ * Comments: Prueba del receptor de tramas de comandos.c sobre el simulador
+ *           (ver sim.h para la linea de compilacion). Alimenta secuencias de
+ *           bytes al receptor y revisa las respuestas y los contadores de la
+ *           respuesta 'E'. Regresa 0 si todas las revisiones pasan.
+ * Revision history:
+ */
+
+//El firmware se compila con -Dmain=main_firmware; aqui se necesita el main de la PC
+#undef main
+
+#include <stdio.h>
+#include <string.h>
+#include "sim.h"
+#include "../comandos.h"
+#include "../pantalla.h"
+#include "../timer1.h"
+
+//Contadores de la respuesta 'E', en su orden
+#define E_TRAMAS 0
+#define E_ERRORES_CRC 1
+#define E_PERDIDAS 2
+
+static unsigned int fallas = 0;
+
+static void revisa(int condicion, const char *descripcion)
+{
+    printf("%-60s %s\n", descripcion, condicion ? "ok" : "FALLA");
+    if (!condicion)
+        fallas++;
+}
+
+static uint8_t crc8(const uint8_t *dat, unsigned int n)
+{
+    uint8_t c = 0, k;
+    while (n--)
+    {
+        c ^= *dat++;
+        for (k = 0; k < 8; k++)
+            c = (c & 0x80) ? (c << 1) ^ 0x07 : c << 1;
+    }
+    return c;
+}
+
+//Arma una trama en t y regresa su longitud
+static unsigned int armaTrama(uint8_t *t, uint8_t tipo, const uint8_t *datos, uint8_t n)
+{
+    t[0] = COMANDO_SYNC;
+    t[1] = n;
+    t[2] = tipo;
+    if (n > 0)
+        memcpy(t + 3, datos, n);
+    t[3 + n] = crc8(t + 1, n + 2);
+    return n + 4;
+}
+
+//Entrega los bytes al receptor como lo haria la interrupcion de RX
+static void alimenta(const uint8_t *bytes, unsigned int n)
+{
+    while (n--)
+        procesaByteComando(*bytes++);
+}
+
+//Atiende la trama pendiente y espera a que salga la respuesta completa.
+//Regresa el tipo de la respuesta (0 si no hubo) y copia sus datos en datos.
+static uint8_t atiende(uint8_t *datos, unsigned int *n)
+{
+    const uint8_t *r;
+    unsigned int recibidos, k;
+
+    sim_uart_limpia();
+    //100 ms llamando cada ms, como la tarea de comandos: las respuestas mas
+    //largas ('E' y 'T', 18 bytes) se encolan por partes y tardan 19 ms a 9600 bps
+    for (k = 0; k < 100; k++)
+    {
+        atiendeComandos();
+        sim_espera_ciclos(SIM_CICLOS_POR_SEGUNDO / 1000);
+    }
+    r = sim_uart_datos(&recibidos);
+    *n = 0;
+    if (recibidos < 4 || r[0] != COMANDO_SYNC || recibidos != 4u + r[1])
+        return 0;
+    if (crc8(r + 1, r[1] + 2) != r[3 + r[1]])
+        return 0;
+    *n = r[1];
+    if (datos != 0)
+        memcpy(datos, r + 3, r[1]);
+    return r[2];
+}
+
+//Pide la respuesta 'E' y regresa el contador k
+static unsigned int contador(uint8_t k)
+{
+    uint8_t t[8], datos[COMANDO_MAX_DATOS];
+    unsigned int n;
+
+    alimenta(t, armaTrama(t, COMANDO_ESTADISTICAS, 0, 0));
+    if (atiende(datos, &n) != COMANDO_ESTADISTICAS || n < 2u * k + 2)
+        return 0xFFFF;
+    return datos[2 * k] | (datos[2 * k + 1] << 8);
+}
+
+static void pruebaValida(void)
+{
+    uint8_t t[COMANDO_MAX_DATOS + 4], v = 30;
+    unsigned int n, tramas = contador(E_TRAMAS);
+
+    alimenta(t, armaTrama(t, COMANDO_VELOCIDAD, &v, 1));
+    revisa(atiende(0, &n) == COMANDO_VELOCIDAD && n == 0, "trama 'V' valida: responde 'V' sin datos");
+    alimenta(t, armaTrama(t, COMANDO_VELOCIDAD, 0, 0));
+    revisa(atiende(t, &n) == COMANDO_NAK && n == 1 && t[0] == COMANDO_VELOCIDAD,
+           "trama 'V' sin argumento: responde NAK con el tipo");
+    //Cada 'E' tambien cuenta como trama valida
+    revisa(contador(E_TRAMAS) == tramas + 3, "las tres tramas se cuentan como validas");
+}
+
+static void pruebaCRC(void)
+{
+    uint8_t t[8];
+    unsigned int n, errores = contador(E_ERRORES_CRC), tramas = contador(E_TRAMAS);
+
+    armaTrama(t, COMANDO_ESTADISTICAS, 0, 0);
+    t[3] ^= 0x01;
+    alimenta(t, 4);
+    revisa(atiende(0, &n) == 0, "CRC incorrecto: no responde");
+    revisa(contador(E_ERRORES_CRC) == errores + 1, "CRC incorrecto: cuenta un error de CRC");
+    revisa(contador(E_TRAMAS) == tramas + 2, "CRC incorrecto: no se cuenta como valida");
+}
+
+static void pruebaLongitud(void)
+{
+    uint8_t t[COMANDO_MAX_DATOS + 8], v = 30;
+    unsigned int n, k, perdidas = contador(E_PERDIDAS);
+
+    //Longitud mayor que el buffer: se descarta sin leer los datos
+    t[0] = COMANDO_SYNC;
+    t[1] = COMANDO_MAX_DATOS + 1;
+    t[2] = COMANDO_MENSAJE;
+    for (k = 3; k < COMANDO_MAX_DATOS + 5; k++)
+        t[k] = 'A';
+    alimenta(t, COMANDO_MAX_DATOS + 5);
+    revisa(atiende(0, &n) == 0, "longitud mayor que COMANDO_MAX_DATOS: no responde");
+    revisa(contador(E_PERDIDAS) == perdidas + 1, "longitud mayor que COMANDO_MAX_DATOS: cuenta una perdida");
+    //La siguiente trama se recibe normalmente
+    alimenta(t, armaTrama(t, COMANDO_VELOCIDAD, &v, 1));
+    revisa(atiende(0, &n) == COMANDO_VELOCIDAD, "la trama siguiente se recibe");
+    //Los comandos que no son 'M' ni 'P' tienen un buffer mas corto
+    memset(t + 16, 30, COMANDO_MAX_ARGUMENTOS + 1);
+    alimenta(t, armaTrama(t, COMANDO_VELOCIDAD, t + 16, COMANDO_MAX_ARGUMENTOS + 1));
+    revisa(atiende(0, &n) == 0, "'V' con mas de COMANDO_MAX_ARGUMENTOS bytes: no responde");
+    revisa(contador(E_PERDIDAS) == perdidas + 2, "'V' con mas de COMANDO_MAX_ARGUMENTOS bytes: perdida");
+}
+
+static void pruebaSyncRepetido(void)
+{
+    uint8_t t[COMANDO_MAX_DATOS + 8], v = 30;
+    unsigned int n, perdidas = contador(E_PERDIDAS);
+
+    //0x7E 0x7E: el segundo no es una longitud valida y vuelve a ser sync
+    t[0] = COMANDO_SYNC;
+    n = armaTrama(t + 1, COMANDO_VELOCIDAD, &v, 1) + 1;
+    alimenta(t, n);
+    revisa(atiende(0, &n) == COMANDO_VELOCIDAD, "0x7E repetido: la trama se recibe");
+    revisa(contador(E_PERDIDAS) == perdidas + 1, "0x7E repetido: cuenta una perdida");
+}
+
+static void pruebaPendiente(void)
+{
+    uint8_t t[2 * (COMANDO_MAX_DATOS + 4)], v = 30;
+    unsigned int n, perdidas = contador(E_PERDIDAS);
+
+    //Dos tramas sin atender la primera: la segunda se pierde
+    n = armaTrama(t, COMANDO_VELOCIDAD, &v, 1);
+    n += armaTrama(t + n, COMANDO_ESTADISTICAS, 0, 0);
+    alimenta(t, n);
+    revisa(atiende(0, &n) == COMANDO_VELOCIDAD, "trama con otra pendiente: responde solo la primera");
+    revisa(atiende(0, &n) == 0, "trama con otra pendiente: la segunda no se atiende");
+    revisa(contador(E_PERDIDAS) == perdidas + 1, "trama con otra pendiente: cuenta una perdida");
+}
+
+static void pruebaVolcado(void)
+{
+    uint8_t t[8], dir[3] = { 0x10, 0x00, VOLCADO_MAX_PALABRAS };
+    const uint8_t *r;
+    uint64_t t0, fin, peor = 0;
+    unsigned int n, k, iguales = 0;
+
+    //Volcado de VOLCADO_MAX_PALABRAS: se envia por partes sin bloquear
+    alimenta(t, armaTrama(t, COMANDO_VOLCADO, dir, 3));
+    sim_uart_limpia();
+    fin = sim_ciclos() + SIM_CICLOS_POR_SEGUNDO / 2;
+    do
+    {
+        t0 = sim_ciclos();
+        atiendeComandos();
+        t0 = sim_ciclos() - t0;
+        if (t0 > peor)
+            peor = t0;
+        sim_espera_ciclos(500);
+        r = sim_uart_datos(&n);
+    } while (sim_ciclos() < fin && n < 4u + 2 * VOLCADO_MAX_PALABRAS);
+    revisa(n == 4u + 2 * VOLCADO_MAX_PALABRAS && r[1] == 2 * VOLCADO_MAX_PALABRAS
+           && r[2] == COMANDO_VOLCADO && crc8(r + 1, r[1] + 2) == r[3 + r[1]],
+           "trama 'D' de VOLCADO_MAX_PALABRAS: respuesta completa");
+    for (k = 0; k < VOLCADO_MAX_PALABRAS; k++)
+        iguales += (r[3 + 2 * k] | (r[4 + 2 * k] << 8)) == sim_eeprom_palabra(8 + k);
+    revisa(iguales == VOLCADO_MAX_PALABRAS, "trama 'D': las palabras son las de la EEPROM");
+    revisa(peor < SIM_CICLOS_POR_SEGUNDO / 200, "trama 'D': ninguna llamada tarda 5 ms o mas");
+    alimenta(t, armaTrama(t, COMANDO_ESTADISTICAS, 0, 0));
+    revisa(atiende(0, &n) == COMANDO_ESTADISTICAS, "despues de 'D' se atiende la siguiente trama");
+}
+
+int main(void)
+{
+    sim_inicia(NULL);
+    PCONbits.OSCF = 1;
+    TRISB = 0x00;
+    init_93lc66b();
+    init_rs232();
+    init_comandos();
+    init_timer1();
+    init_matrizLed();
+    init_pantalla();
+
+    pruebaValida();
+    pruebaCRC();
+    pruebaLongitud();
+    pruebaSyncRepetido();
+    pruebaPendiente();
+    pruebaVolcado();
+    printf("%u fallas\n", fallas);
+    return fallas != 0;
+}
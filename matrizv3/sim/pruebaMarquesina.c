@@ -0,0 +1,140 @@
+/*
+ * File:   pruebaMarquesina.c
+ * Author:
+ * Comments: Prueba de la marquesina sobre el simulador (ver sim.h para la
+ *           compilacion). Desplaza varios mensajes, cortos y largos, durante
+ *           varias vueltas; de vez en cuando detiene la ventana y compara lo
+ *           que muestra la matriz con el dibujo esperado del mensaje. Regresa
+ *           0 si todas las revisiones pasan.
+ * Revision history:
+ */
+
+//El firmware se compila con -Dmain=main_firmware; aqui se necesita el main de la PC
+#undef main
+
+#include <stdio.h>
+#include <string.h>
+#include "sim.h"
+#include "../matrizLed.h"
+#include "../pantalla.h"
+#include "../marquesina.h"
+#include "../timer1.h"
+
+//Columnas por segundo durante la prueba (cerca del maximo, para dar vueltas rapido)
+#define VELOCIDAD_PRUEBA 100
+//Duracion de cada mensaje y cada cuanto se revisa la matriz, en ms
+#define DURACION_MS 2500
+#define REVISION_MS 97
+//Columnas maximas de una vuelta que se pueden comparar
+#define DIBUJO_MAX 256
+
+static unsigned int fallas = 0;
+
+static void revisa(int condicion, const char *descripcion, const char *cad)
+{
+    printf("%-44s \"%s\"%*s %s\n", descripcion, cad, (int)(14 - strlen(cad)), "", condicion ? "ok" : "FALLA");
+    if (!condicion)
+        fallas++;
+}
+
+//Dibujo de una vuelta del mensaje, como lo arma la marquesina: cada caracter
+//con su ancho real (o ANCHO_SIN_GLIFO en blanco) y su separacion
+static unsigned int dibujaEsperado(const char *cad, uint8_t *dibujo)
+{
+    uint8_t glifo[ANCHO_MAX_GLIFO];
+    unsigned int n = 0, j;
+    uint8_t ancho, k;
+
+    for (j = 0; cad[j] != 0; j++)
+    {
+        ancho = cargaGlifo(cad[j], glifo);
+        for (k = 0; k < (ancho ? ancho : ANCHO_SIN_GLIFO); k++)
+            dibujo[n++] = ancho ? glifo[k] : 0;
+        for (k = 0; k < SEPARACION_GLIFOS; k++)
+            dibujo[n++] = 0;
+    }
+    return n;
+}
+
+//Columna mostrada en la fila f de la ventana detenida
+static uint8_t columnaMostrada(unsigned int f)
+{
+    uint8_t columna = 0, b;
+
+    for (b = 0; b < 8; b++)
+        if (sim_matriz_brillo(f, b) > 0.01)
+            columna |= 1 << b;
+    return columna;
+}
+
+//Desplaza el mensaje y regresa las revisiones de la ventana que no coincidieron
+static unsigned int pruebaMensaje(const char *cad, unsigned int *revisiones)
+{
+    uint8_t dibujo[DIBUJO_MAX];
+    unsigned int longitud = dibujaEsperado(cad, dibujo), ms, f, malas = 0;
+    unsigned long columna = 0;      //desplazamiento absoluto de la ventana
+    uint8_t anterior, actual;
+
+    *revisiones = 0;
+    iniciaMarquesina(cad, VELOCIDAD_PRUEBA);
+    //La ventana nueva empieza en 0 cuando la interrupcion la aplica
+    while (cambioPendientePantalla())
+        sim_espera_ciclos(100);
+    anterior = desplazamientoVentana();
+    for (ms = 1; ms <= DURACION_MS; ms++)
+    {
+        sim_espera_ciclos(SIM_CICLOS_POR_SEGUNDO / 1000);
+        actualizaMarquesina();
+        actual = desplazamientoVentana();
+        columna += (uint8_t)(actual - anterior);
+        anterior = actual;
+        if (ms % REVISION_MS != 0)
+            continue;
+        //Con la ventana detenida cada fila muestra siempre la misma columna
+        cambiaVelocidadMarquesina(0);
+        sim_espera_ciclos(SIM_CICLOS_POR_SEGUNDO / CUADROS_POR_SEGUNDO);
+        sim_limpia_estadisticas();
+        sim_espera_ciclos(4 * SIM_CICLOS_POR_SEGUNDO / CUADROS_POR_SEGUNDO);
+        for (f = 0; f < FILAS_PANTALLA; f++)
+            if (columnaMostrada(f) != dibujo[(columna + f) % longitud])
+            {
+                malas++;
+                break;
+            }
+        (*revisiones)++;
+        cambiaVelocidadMarquesina(VELOCIDAD_PRUEBA);
+    }
+    return malas;
+}
+
+int main(int argc, char **argv)
+{
+    static const char *mensajes[] = { "'", "' ", "A", "1", "AB", "HOLA", "MONTY 2025 " };
+    const char *imagen = argc > 1 ? argv[1] : "tabla_leds.bin";
+    unsigned int k, revisiones, malas;
+
+    if (sim_inicia(imagen) != 0)
+    {
+        fprintf(stderr, "no se pudo abrir %s\n", imagen);
+        return 2;
+    }
+    PCONbits.OSCF = 1;
+    TRISB = 0x00;
+    init_93lc66b();
+    init_timer1();
+    init_matrizLed();
+    init_pantalla();
+    if (glifosFuente() == 0)
+    {
+        fprintf(stderr, "%s no tiene una fuente valida\n", imagen);
+        return 2;
+    }
+
+    for (k = 0; k < sizeof(mensajes) / sizeof(mensajes[0]); k++)
+    {
+        malas = pruebaMensaje(mensajes[k], &revisiones);
+        revisa(revisiones != 0 && malas == 0, "la matriz muestra el mensaje en cada vuelta", mensajes[k]);
+    }
+    printf("%u fallas\n", fallas);
+    return fallas != 0;
+}
@@ -0,0 +1,644 @@
+#include <stdlib.h>
+#include <string.h>
+#include "xc.h"
+#include "sim.h"
+
+//Rutina de interrupcion del firmware (main.c)
+extern void isr(void);
+
+//Pines de la EEPROM 93LC66B (PORTA) y de los 74HC595 (PORTB), como en el firmware
+#define PIN_CS 0x01
+#define PIN_SK 0x02
+#define PIN_DI 0x04
+#define PIN_DO 0x08
+#define PIN_DATA 0x20
+#define PIN_LATCH 0x40
+#define PIN_CLK 0x80
+
+static sim_registros_t sfr;
+static sim_estadisticas_t est;
+static uint64_t ciclos;
+static int enIsr;
+static uint8_t portaPrevio, portbPrevio;
+
+//Timer0 y Timer1: ciclos que aun no completan una cuenta del preescalador
+static unsigned long t0Resto;
+static unsigned long t1Resto;
+
+//USART
+static uint8_t uartSalida[SIM_UART_MAX];
+static unsigned int uartN;
+static int txRegLleno, tsrOcupado;
+static uint8_t txRegDato, tsrDato;
+static uint64_t tsrFin;
+static uint8_t uartEntrada[SIM_UART_MAX];
+static unsigned int entradaN, entradaI;
+static uint64_t rxSiguiente;
+static uint8_t rxFifo[2];
+static int rxN;
+static unsigned long baudiosHost;   //0: la PC usa la velocidad del USART
+
+//EEPROM Microwire con celdas de M93_ORG bits y M93_BITS_DIRECCION bits de
+//direccion; los bits de direccion sobrantes (93xx56 y 93xx76) se ignoran
+#define EE_MASCARA ((1u << M93_ORG) - 1)
+enum { EE_INACTIVA, EE_OPCODE, EE_DIRECCION, EE_LECTURA, EE_DATO, EE_IGNORA };
+static uint16_t eeprom[SIM_CELDAS_EEPROM];
+static int eeEstado, eeBits, eeDo = 1;
+static unsigned int eeOpcode, eeDireccion, eeDato;
+static int eeHabilitada;        //EWEN recibido
+static uint64_t eeOcupadaHasta; //fin del ciclo interno de escritura
+
+//EEPROM de datos interna; la escritura solo arranca despues de 0x55 y 0xAA
+//en EECON2 con WREN activo
+static uint8_t eeInterna[SIM_BYTES_EEINTERNA];
+static int eeiSecuencia, eeiEscribiendo;
+static uint64_t eeiFin;
+static uint8_t eeiDireccion, eeiDato;
+
+//Cadena de 74HC595; el chip 0 es el conectado al microcontrolador
+static uint8_t registro595[SIM_CHIPS_595];
+static uint8_t salida595[SIM_CHIPS_595];
+static uint64_t ultimoLatch;
+static double encendido[8 * (SIM_CHIPS_595 / 2)][8];
+static uint64_t ventanaInicio;
+
+static unsigned long ciclosPorBit(void)
+{
+    return (sfr.txsta.bits.BRGH ? 4UL : 16UL) * (sfr.spbrg + 1UL);
+}
+
+//Duracion de un bit de lo que envia la PC
+static unsigned long ciclosBitHost(void)
+{
+    return baudiosHost ? SIM_CICLOS_POR_SEGUNDO / baudiosHost : ciclosPorBit();
+}
+
+//Nivel de la linea RX: los bits del byte en curso (inicio, datos LSB primero
+//y paro) o reposo en alto
+static int lineaRx(void)
+{
+    unsigned long bit = ciclosBitHost(), pos;
+    uint64_t inicio;
+
+    if (entradaI >= entradaN)
+        return 1;
+    inicio = rxSiguiente - 10 * bit;
+    if (ciclos < inicio)
+        return 1;
+    pos = (unsigned long)((ciclos - inicio) / bit);
+    if (pos == 0)
+        return 0;
+    if (pos <= 8)
+        return (uartEntrada[entradaI] >> (pos - 1)) & 1;
+    return 1;
+}
+
+//Ciclo interno de escritura o borrado: se graba al recibir el ultimo bit y
+//la memoria queda ocupada el tiempo tipico de la hoja de datos
+static void eepromPrograma(unsigned int direccion, uint16_t dato, int todas)
+{
+    unsigned int k;
+
+    if (!eeHabilitada)
+        return;
+    est.escriturasEeprom++;
+    if (todas)
+    {
+        for (k = 0; k < SIM_CELDAS_EEPROM; k++)
+            eeprom[k] = dato;
+        eeOcupadaHasta = ciclos + SIM_CICLOS_ESCRITURA_TODA;
+    }
+    else
+    {
+        eeprom[direccion & (SIM_CELDAS_EEPROM - 1)] = dato;
+        eeOcupadaHasta = ciclos + SIM_CICLOS_ESCRITURA;
+    }
+}
+
+static void eepromReloj(int di)
+{
+    est.relojesEeprom++;
+    switch (eeEstado)
+    {
+        case EE_INACTIVA:
+            //Mientras graba, la memoria ignora los comandos
+            if (di && ciclos >= eeOcupadaHasta)
+            {
+                est.comandosEeprom++;
+                eeEstado = EE_OPCODE;
+                eeBits = 0;
+                eeOpcode = 0;
+            }
+            break;
+        case EE_OPCODE:
+            eeOpcode = (eeOpcode << 1) | di;
+            if (++eeBits == 2)
+            {
+                eeEstado = EE_DIRECCION;
+                eeBits = 0;
+                eeDireccion = 0;
+            }
+            break;
+        case EE_DIRECCION:
+            eeDireccion = (eeDireccion << 1) | di;
+            if (++eeBits == M93_BITS_DIRECCION)
+            {
+                //Los comandos especiales usan los dos bits altos
+                unsigned int especial = eeDireccion >> (M93_BITS_DIRECCION - 2);
+                eeDireccion &= SIM_CELDAS_EEPROM - 1;
+                eeBits = 0;
+                eeEstado = EE_IGNORA;
+                if (eeOpcode == 2)
+                {
+                    eeEstado = EE_LECTURA;
+                    eeDo = 0;       //bit ficticio
+                }
+                else if (eeOpcode == 1 || (eeOpcode == 0 && especial == 1))
+                {
+                    //WRITE y WRAL: sigue el dato
+                    eeEstado = EE_DATO;
+                    eeDato = 0;
+                }
+                else if (eeOpcode == 3)
+                {
+                    eepromPrograma(eeDireccion, EE_MASCARA, 0);
+                }
+                else if (especial == 3)
+                {
+                    eeHabilitada = 1;
+                }
+                else if (especial == 0)
+                {
+                    eeHabilitada = 0;
+                }
+                else
+                {
+                    eepromPrograma(0, EE_MASCARA, 1);
+                }
+            }
+            break;
+        case EE_DATO:
+            eeDato = (eeDato << 1) | di;
+            if (++eeBits == M93_ORG)
+            {
+                eeEstado = EE_IGNORA;
+                eepromPrograma(eeDireccion, eeDato, eeOpcode == 0);
+            }
+            break;
+        case EE_LECTURA:
+            if (eeBits == M93_ORG)
+            {
+                eeBits = 0;
+                eeDireccion = (eeDireccion + 1) & (SIM_CELDAS_EEPROM - 1);
+            }
+            //Se cuentan palabras de 16 bits de la imagen, tambien en x8
+            if (eeBits == 0 && (M93_ORG == 16 || (eeDireccion & 1) == 0))
+                est.palabrasEeprom++;
+            eeDo = (eeprom[eeDireccion] >> (M93_ORG - 1 - eeBits)) & 1;
+            eeBits++;
+            break;
+        default:
+            break;
+    }
+}
+
+static void acumulaMatriz(void)
+{
+    double dt = (double)(ciclos - ultimoLatch);
+    unsigned int p, f, b;
+    for (p = 0; p < SIM_CHIPS_595 / 2; p++)
+    {
+        uint8_t cat = salida595[2 * p];
+        uint8_t an = salida595[2 * p + 1];
+        for (f = 0; f < 8; f++)
+        {
+            if (!(an & (1 << f)))
+                continue;
+            for (b = 0; b < 8; b++)
+                if (!(cat & (1 << b)))
+                    encendido[p * 8 + f][b] += dt;
+        }
+    }
+    ultimoLatch = ciclos;
+}
+
+static void procesaPines(void)
+{
+    uint8_t a = sfr.porta.byte, b = sfr.portb.byte;
+    uint8_t subeA = a & ~portaPrevio, bajaA = ~a & portaPrevio;
+    uint8_t subeB = b & ~portbPrevio;
+    int k;
+
+    if (bajaA & PIN_CS)
+    {
+        eeEstado = EE_INACTIVA;
+        eeDo = 1;
+    }
+    if ((subeA & PIN_SK) && (a & PIN_CS))
+        eepromReloj((a & PIN_DI) != 0);
+    //Con CS en alto y sin comando, DO indica si termino el ciclo de escritura
+    if ((a & PIN_CS) && eeEstado == EE_INACTIVA)
+        eeDo = ciclos >= eeOcupadaHasta;
+    sfr.porta.bits.RA3 = eeDo;
+    portaPrevio = sfr.porta.byte;
+
+    if (subeB & PIN_CLK)
+    {
+        uint8_t acarreo = (b & PIN_DATA) != 0;
+        est.relojes595++;
+        for (k = 0; k < SIM_CHIPS_595; k++)
+        {
+            uint8_t sale = registro595[k] >> 7;
+            registro595[k] = (registro595[k] << 1) | acarreo;
+            acarreo = sale;
+        }
+    }
+    if (subeB & PIN_LATCH)
+    {
+        acumulaMatriz();
+        memcpy(salida595, registro595, sizeof salida595);
+        est.latches++;
+        for (k = 1; k < SIM_CHIPS_595; k += 2)
+            if (salida595[k])
+            {
+                est.filas++;
+                break;
+            }
+    }
+    portbPrevio = b;
+
+    //Escritura en TXREG
+    if (sfr.txreg != 0xFFFF)
+    {
+        txRegDato = sfr.txreg & 0xFF;
+        sfr.txreg = 0xFFFF;
+        txRegLleno = 1;
+    }
+    //EEPROM interna: lectura inmediata, escritura de SIM_CICLOS_EEINTERNA
+    if (sfr.eecon1.bits.RD)
+    {
+        sfr.eedata = eeInterna[sfr.eeadr & (SIM_BYTES_EEINTERNA - 1)];
+        sfr.eecon1.bits.RD = 0;
+        est.lecturasEEInterna++;
+    }
+    if (sfr.eecon2 != 0xFFFF)
+    {
+        if (sfr.eecon2 == 0x55)
+            eeiSecuencia = 1;
+        else
+            eeiSecuencia = (sfr.eecon2 == 0xAA && eeiSecuencia == 1) ? 2 : 0;
+        sfr.eecon2 = 0xFFFF;
+    }
+    if (sfr.eecon1.bits.WR && !eeiEscribiendo)
+    {
+        if (sfr.eecon1.bits.WREN && eeiSecuencia == 2)
+        {
+            eeiEscribiendo = 1;
+            eeiDireccion = sfr.eeadr & (SIM_BYTES_EEINTERNA - 1);
+            eeiDato = sfr.eedata;
+            eeiFin = ciclos + SIM_CICLOS_EEINTERNA;
+        }
+        else
+        {
+            sfr.eecon1.bits.WR = 0;
+        }
+        eeiSecuencia = 0;
+    }
+    //Limpiar CREN limpia OERR
+    if (!sfr.rcsta.bits.CREN)
+    {
+        sfr.rcsta.bits.OERR = 0;
+        rxN = 0;
+    }
+}
+
+static void avanzaPerifericos(unsigned long n)
+{
+    ciclos += n;
+    if (enIsr)
+        est.ciclosIsr += n;
+
+    //Timer0 con reloj interno
+    if (!sfr.option_reg.bits.T0CS)
+    {
+        unsigned long pre = sfr.option_reg.bits.PSA ? 1UL : (2UL << (sfr.option_reg.byte & 7));
+        unsigned long cuentas;
+        t0Resto += n;
+        cuentas = t0Resto / pre;
+        t0Resto %= pre;
+        if (sfr.tmr0 + cuentas > 255)
+            sfr.intcon.bits.T0IF = 1;
+        sfr.tmr0 = (uint8_t)(sfr.tmr0 + cuentas);
+    }
+
+    //Timer1 libre con reloj interno
+    if (sfr.t1con.bits.TMR1ON && !sfr.t1con.bits.TMR1CS)
+    {
+        unsigned long pre = 1UL << ((sfr.t1con.byte >> 4) & 3);
+        unsigned long cuenta;
+        t1Resto += n;
+        cuenta = ((unsigned long)sfr.tmr1h << 8 | sfr.tmr1l) + t1Resto / pre;
+        t1Resto %= pre;
+        if (cuenta > 0xFFFF)
+            sfr.pir1.bits.TMR1IF = 1;
+        sfr.tmr1l = cuenta & 0xFF;
+        sfr.tmr1h = (cuenta >> 8) & 0xFF;
+    }
+
+    if (eeiEscribiendo && ciclos >= eeiFin)
+    {
+        eeInterna[eeiDireccion] = eeiDato;
+        eeiEscribiendo = 0;
+        sfr.eecon1.bits.WR = 0;
+        sfr.pir1.bits.EEIF = 1;
+        est.escriturasEEInterna++;
+    }
+
+    //Transmision
+    if (!tsrOcupado && txRegLleno && sfr.txsta.bits.TXEN)
+    {
+        tsrOcupado = 1;
+        txRegLleno = 0;
+        tsrDato = txRegDato;
+        tsrFin = ciclos + 10 * ciclosPorBit();
+    }
+    while (tsrOcupado && ciclos >= tsrFin)
+    {
+        if (uartN < SIM_UART_MAX)
+            uartSalida[uartN++] = tsrDato;
+        est.uartEnviados++;
+        tsrOcupado = 0;
+        if (txRegLleno)
+        {
+            tsrOcupado = 1;
+            txRegLleno = 0;
+            tsrDato = txRegDato;
+            tsrFin += 10 * ciclosPorBit();
+        }
+    }
+    sfr.pir1.bits.TXIF = !txRegLleno;
+    sfr.txsta.bits.TRMT = !tsrOcupado;
+
+    //Recepcion
+    while (entradaI < entradaN && ciclos >= rxSiguiente)
+    {
+        if (sfr.rcsta.bits.SPEN && sfr.rcsta.bits.CREN)
+        {
+            uint8_t dato = uartEntrada[entradaI];
+            long diferencia = (long)ciclosPorBit() - (long)ciclosBitHost();
+            //Con mas de 3 % de diferencia entre las velocidades el byte llega danado
+            if (100 * labs(diferencia) > 3 * (long)ciclosBitHost())
+                dato ^= 0xA5;
+            if (rxN < 2)
+                rxFifo[rxN++] = dato;
+            else
+            {
+                sfr.rcsta.bits.OERR = 1;
+                est.uartDesbordes++;
+            }
+        }
+        entradaI++;
+        rxSiguiente += 10 * ciclosBitHost();
+    }
+    sfr.portb.bits.RB1 = lineaRx();
+    sfr.pir1.bits.RCIF = rxN > 0;
+}
+
+static void revisaInterrupciones(void)
+{
+    while (!enIsr && sfr.intcon.bits.GIE &&
+           ((sfr.intcon.bits.T0IE && sfr.intcon.bits.T0IF) ||
+            (sfr.intcon.bits.PEIE && (sfr.pie1.byte & sfr.pir1.byte))))
+    {
+        enIsr = 1;
+        est.interrupciones++;
+        sfr.intcon.bits.GIE = 0;
+        avanzaPerifericos(SIM_CICLOS_ISR);
+        isr();
+        procesaPines();
+        sfr.intcon.bits.GIE = 1;
+        enIsr = 0;
+    }
+}
+
+static void avanza(unsigned long n)
+{
+    procesaPines();
+    avanzaPerifericos(n);
+    revisaInterrupciones();
+}
+
+//Ciclos hasta el siguiente evento de un periferico, para no saltarlo en los retardos largos
+static unsigned long ciclosHastaEvento(void)
+{
+    unsigned long minimo = 1000;
+    if (!sfr.option_reg.bits.T0CS)
+    {
+        unsigned long pre = sfr.option_reg.bits.PSA ? 1UL : (2UL << (sfr.option_reg.byte & 7));
+        unsigned long t = (256UL - sfr.tmr0) * pre - t0Resto;
+        if (t < minimo)
+            minimo = t;
+    }
+    if (tsrOcupado && tsrFin > ciclos && tsrFin - ciclos < minimo)
+        minimo = (unsigned long)(tsrFin - ciclos);
+    if (entradaI < entradaN && rxSiguiente > ciclos && rxSiguiente - ciclos < minimo)
+        minimo = (unsigned long)(rxSiguiente - ciclos);
+    return minimo ? minimo : 1;
+}
+
+volatile sim_registros_t *sim_sfr(void)
+{
+    avanza(1);
+    return &sfr;
+}
+
+uint8_t sim_lee_rcreg(void)
+{
+    uint8_t dat;
+    avanza(1);
+    dat = rxFifo[0];
+    if (rxN > 0)
+    {
+        rxFifo[0] = rxFifo[1];
+        rxN--;
+        est.uartRecibidos++;
+    }
+    sfr.pir1.bits.RCIF = rxN > 0;
+    return dat;
+}
+
+void sim_retardo_ciclos(unsigned long n)
+{
+    procesaPines();
+    while (n > 0)
+    {
+        unsigned long paso = ciclosHastaEvento();
+        if (paso > n)
+            paso = n;
+        avanzaPerifericos(paso);
+        n -= paso;
+        revisaInterrupciones();
+    }
+}
+
+int sim_inicia(const char *imagen)
+{
+    FILE *f;
+    uint8_t bytes[M93_BYTES];
+    size_t n = 0, i;
+
+    memset(&sfr, 0, sizeof sfr);
+    sfr.trisa.byte = 0xFF;
+    sfr.trisb.byte = 0xFF;
+    sfr.option_reg.byte = 0xFF;
+    sfr.txsta.byte = 0x02;
+    sfr.txreg = 0xFFFF;
+    sfr.eecon2 = 0xFFFF;
+    sfr.porta.bits.RA3 = 1;
+    ciclos = 0;
+    enIsr = 0;
+    portaPrevio = sfr.porta.byte;
+    portbPrevio = sfr.portb.byte;
+    t0Resto = 0;
+    t1Resto = 0;
+    uartN = 0;
+    txRegLleno = tsrOcupado = 0;
+    entradaN = entradaI = 0;
+    baudiosHost = 0;
+    rxN = 0;
+    eeEstado = EE_INACTIVA;
+    eeDo = 1;
+    eeHabilitada = 0;
+    eeOcupadaHasta = 0;
+    memset(registro595, 0, sizeof registro595);
+    memset(salida595, 0, sizeof salida595);
+    sim_limpia_estadisticas();
+
+    for (i = 0; i < SIM_CELDAS_EEPROM; i++)
+        eeprom[i] = EE_MASCARA;
+    //Como un PIC nuevo: EEPROM interna borrada
+    memset(eeInterna, 0xFF, sizeof eeInterna);
+    eeiSecuencia = eeiEscribiendo = 0;
+    if (imagen == NULL)
+        return 0;
+    f = fopen(imagen, "rb");
+    if (f == NULL)
+        return -1;
+    n = fread(bytes, 1, sizeof bytes, f);
+    fclose(f);
+#if M93_ORG == 16
+    for (i = 0; i + 1 < n; i += 2)
+        eeprom[i / 2] = bytes[i] | (bytes[i + 1] << 8);
+    if (n & 1)
+        eeprom[n / 2] = 0xFF00 | bytes[n - 1];
+#else
+    for (i = 0; i < n; i++)
+        eeprom[i] = bytes[i];
+#endif
+    return 0;
+}
+
+uint64_t sim_ciclos(void)
+{
+    return ciclos;
+}
+
+double sim_segundos(void)
+{
+    return (double)ciclos / SIM_CICLOS_POR_SEGUNDO;
+}
+
+void sim_espera_ciclos(unsigned long n)
+{
+    sim_retardo_ciclos(n);
+}
+
+const sim_estadisticas_t *sim_estadisticas(void)
+{
+    return &est;
+}
+
+void sim_limpia_estadisticas(void)
+{
+    memset(&est, 0, sizeof est);
+    memset(encendido, 0, sizeof encendido);
+    ultimoLatch = ciclos;
+    ventanaInicio = ciclos;
+}
+
+const uint8_t *sim_uart_datos(unsigned int *n)
+{
+    *n = uartN;
+    return uartSalida;
+}
+
+void sim_uart_limpia(void)
+{
+    uartN = 0;
+}
+
+void sim_uart_inyecta(const uint8_t *datos, unsigned int n)
+{
+    if (entradaI >= entradaN)
+    {
+        entradaI = entradaN = 0;
+        rxSiguiente = ciclos + 10 * ciclosBitHost();
+    }
+    while (n-- > 0 && entradaN < SIM_UART_MAX)
+        uartEntrada[entradaN++] = *datos++;
+}
+
+void sim_uart_baudios(unsigned long bps)
+{
+    baudiosHost = bps;
+}
+
+int sim_uart_pendiente(void)
+{
+    return entradaI < entradaN;
+}
+
+uint16_t sim_eeprom_palabra(unsigned int direccion)
+{
+    direccion &= SIM_PALABRAS_EEPROM - 1;
+#if M93_ORG == 16
+    return eeprom[direccion];
+#else
+    return eeprom[2 * direccion] | (eeprom[2 * direccion + 1] << 8);
+#endif
+}
+
+double sim_matriz_brillo(unsigned int fila, unsigned int bit)
+{
+    double total;
+    acumulaMatriz();
+    total = (double)(ciclos - ventanaInicio);
+    if (fila >= 8 * (SIM_CHIPS_595 / 2) || bit >= 8 || total <= 0)
+        return 0;
+    return encendido[fila][bit] / total;
+}
+
+uint8_t sim_eeinterna_byte(unsigned int direccion)
+{
+    return eeInterna[direccion & (SIM_BYTES_EEINTERNA - 1)];
+}
+
+void sim_matriz_imprime(FILE *salida)
+{
+    unsigned int f, b;
+    double maximo = 0;
+    acumulaMatriz();
+    for (f = 0; f < 8 * (SIM_CHIPS_595 / 2); f++)
+        for (b = 0; b < 8; b++)
+            if (encendido[f][b] > maximo)
+                maximo = encendido[f][b];
+    for (b = 0; b < 8; b++)
+    {
+        for (f = 0; f < 8 * (SIM_CHIPS_595 / 2); f++)
+        {
+            double v = maximo > 0 ? encendido[f][b] / maximo : 0;
+            fputc(v > 0.66 ? '#' : v > 0.33 ? '+' : v > 0.05 ? '.' : ' ', salida);
+        }
+        fputc('\n', salida);
+    }
+}
@@ -0,0 +1,128 @@
+/*
+ * File:   sim.h
+ * Author:
+ * Comments: Simulador en PC del hardware de matrizv3: reloj virtual de
+ *           instrucciones, Timer0, Timer1, USART, EEPROM Microwire (93LC66B u otro
+ *           modelo segun M93_MODELO y M93_ORG), EEPROM de datos interna y
+ *           cadena de 74HC595.
+ * Revision history:
+ *
+ * Compilacion con el Makefile de este directorio (desde matrizv3/sim):
+ *
+ *   make corre           banco de rendimiento (sim/banco.c) con tabla_leds.bin
+ *   make pruebas         prueba del receptor de tramas (sim/pruebaComandos.c)
+ *                        y banco de ListaEnlazadaPrueba; falla si alguna falla
+ *   make recursos        pila de hardware y RAM estimadas para el PIC16F628A
+ *                        (herramientas/recursos.py)
+ *
+ * Cada programa se enlaza con sim.c y todas las fuentes del firmware, con
+ * -Dmain=main_firmware y este directorio antes que el del compilador para que
+ * se use este xc.h. Los parametros de compilacion del firmware se cambian con
+ * DEFS. Por ejemplo, para comparar el refresco con cada profundidad de grises:
+ *
+ *   for b in 1 2 3 4; do make -B DEFS=-DPANTALLA_BITS=$b corre; done
+ *
+ * o, para otra EEPROM de la familia, -DM93_MODELO=86 -DM93_ORG=8. Con
+ * -DPERFIL_ACTIVO=1 el banco termina con la tabla del perfilador (comando 'F'),
+ * y con -DRS232_AUTOBAUDIOS=1 con la medicion de la velocidad de la PC.
+ *
+ * main.c se enlaza solo por su rutina de interrupcion isr(); su main() queda
+ * renombrado como main_firmware() y no se ejecuta.
+ */
+
+// This is a guard condition so that contents of this file are not included
+// more than once.
+#ifndef SIM_H
+#define	SIM_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "../h595.h"
+#include "../m93lc66b.h"
+
+//Reloj del PIC simulado: 4 MHz, 1 ciclo de instruccion = 1 us
+#define SIM_FOSC 4000000UL
+#define SIM_CICLOS_POR_SEGUNDO (SIM_FOSC / 4)
+//Ciclos que se cobran por la entrada y salida de la interrupcion (latencia y
+//guardado de contexto de XC8)
+#define SIM_CICLOS_ISR 24
+//Registros 74HC595 en cascada (dos por panel: catodos y anodos). Para simular
+//varios paneles se compila todo con -DPANELES=n.
+#define SIM_CHIPS_595 (2 * PANELES)
+//Palabras de 16 bits de la imagen y celdas de la EEPROM (iguales en x16)
+#define SIM_PALABRAS_EEPROM (M93_BYTES / 2)
+#define SIM_CELDAS_EEPROM (M93_BYTES / M93_BYTES_CELDA)
+//Duracion del ciclo interno de escritura de la 93LC66B: WRITE y ERASE por
+//palabra, WRAL y ERAL para toda la memoria (valores tipicos, en ciclos)
+#define SIM_CICLOS_ESCRITURA 2000
+#define SIM_CICLOS_ESCRITURA_TODA 8000
+//EEPROM de datos del PIC16F628A: 128 bytes, 4 ms por byte
+#define SIM_BYTES_EEINTERNA 128
+#define SIM_CICLOS_EEINTERNA 4000
+#define SIM_UART_MAX 65536
+
+typedef struct {
+    uint64_t ciclosIsr;         //ciclos ejecutados dentro de la interrupcion
+    unsigned long interrupciones;
+    unsigned long latches;      //pulsos de LATCH en los 74HC595
+    unsigned long filas;        //latches con algun anodo encendido
+    unsigned long relojes595;
+    unsigned long comandosEeprom;
+    unsigned long relojesEeprom;
+    unsigned long palabrasEeprom;
+    unsigned long escriturasEeprom; //ciclos internos de escritura o borrado
+    unsigned long lecturasEEInterna;
+    unsigned long escriturasEEInterna;
+    unsigned long uartEnviados;
+    unsigned long uartRecibidos;
+    unsigned long uartDesbordes;
+} sim_estadisticas_t;
+
+/**
+ * @brief Reinicia el simulador y carga la imagen de la EEPROM.
+ *
+ * @param imagen Archivo con el contenido de la EEPROM (palabras de 16 bits, LSB primero, como `tabla_leds.bin`), o NULL para una memoria borrada. En x8 cada byte del archivo ocupa una celda.
+ *
+ * @return 0 si la imagen se cargó, -1 si no se pudo abrir.
+ */
+int sim_inicia(const char *imagen);
+/** @brief Ciclos de instrucción transcurridos desde `sim_inicia()`. */
+uint64_t sim_ciclos(void);
+/** @brief Tiempo virtual transcurrido en segundos. */
+double sim_segundos(void);
+/** @brief Deja correr el reloj virtual (y las interrupciones) durante `ciclos` ciclos. */
+void sim_espera_ciclos(unsigned long ciclos);
+/** @brief Contadores del simulador. */
+const sim_estadisticas_t *sim_estadisticas(void);
+/** @brief Pone en cero los contadores y la imagen acumulada de la matriz. */
+void sim_limpia_estadisticas(void);
+
+/** @brief Bytes recibidos por el sumidero del USART (lo que envió el firmware). */
+const uint8_t *sim_uart_datos(unsigned int *n);
+/** @brief Vacía el sumidero del USART. */
+void sim_uart_limpia(void);
+/** @brief Envía bytes al firmware por el USART, a la velocidad configurada en SPBRG. */
+void sim_uart_inyecta(const uint8_t *datos, unsigned int n);
+/**
+ * @brief Fija la velocidad a la que la PC envía los bytes inyectados.
+ *
+ * @param bps Bits por segundo, o 0 para usar siempre la velocidad configurada en SPBRG (el valor inicial).
+ *
+ * @details Con una velocidad fija el pin RX (RB1) sigue los bits de lo que se envía, para medirlos con `autobaudiosRS232()`, y los bytes llegan dañados si difiere más de 3 % de la del USART.
+ */
+void sim_uart_baudios(unsigned long bps);
+/** @brief Regresa 1 mientras queden bytes inyectados por entregar. */
+int sim_uart_pendiente(void);
+
+/** @brief Palabra de 16 bits de la imagen (bytes `2 * direccion` y siguiente) en la EEPROM simulada. */
+uint16_t sim_eeprom_palabra(unsigned int direccion);
+
+/** @brief Byte actual de la EEPROM de datos interna simulada. */
+uint8_t sim_eeinterna_byte(unsigned int direccion);
+
+/** @brief Dibuja con caracteres la imagen promedio de la matriz desde la última limpieza. */
+void sim_matriz_imprime(FILE *salida);
+/** @brief Fracción del tiempo (0 a 1) que un LED estuvo encendido desde la última limpieza. */
+double sim_matriz_brillo(unsigned int fila, unsigned int bit);
+
+#endif	/* SIM_H */
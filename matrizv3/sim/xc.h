@@ -0,0 +1,94 @@
+/*
+ * File:   xc.h (simulador)
+ * Author:
+ * Comments: Sustituto de <xc.h> para compilar el firmware de matrizv3 en la PC.
+ *           Cada acceso a un registro pasa por sim_sfr(), que cobra un ciclo de
+ *           instruccion, avanza los perifericos simulados y atiende interrupciones.
+ * Revision history:
+ */
+
+// This is a guard condition so that contents of this file are not included
+// more than once.
+#ifndef SIM_XC_H
+#define	SIM_XC_H
+
+#include <stdint.h>
+
+#define SIM_BITS8(p) struct { uint8_t p##0:1, p##1:1, p##2:1, p##3:1, p##4:1, p##5:1, p##6:1, p##7:1; }
+
+typedef struct {
+    union { uint8_t byte; SIM_BITS8(RA) bits; } porta;
+    union { uint8_t byte; SIM_BITS8(RB) bits; } portb;
+    union { uint8_t byte; SIM_BITS8(TRISA) bits; } trisa;
+    union { uint8_t byte; SIM_BITS8(TRISB) bits; } trisb;
+    union { uint8_t byte; struct { uint8_t RBIF:1, INTF:1, T0IF:1, RBIE:1, INTE:1, T0IE:1, PEIE:1, GIE:1; } bits; } intcon;
+    union { uint8_t byte; struct { uint8_t TMR1IF:1, TMR2IF:1, CCP1IF:1, :1, TXIF:1, RCIF:1, CMIF:1, EEIF:1; } bits; } pir1;
+    union { uint8_t byte; struct { uint8_t TMR1IE:1, TMR2IE:1, CCP1IE:1, :1, TXIE:1, RCIE:1, CMIE:1, EEIE:1; } bits; } pie1;
+    union { uint8_t byte; struct { uint8_t PS0:1, PS1:1, PS2:1, PSA:1, T0SE:1, T0CS:1, INTEDG:1, nRBPU:1; } bits; } option_reg;
+    union { uint8_t byte; struct { uint8_t TX9D:1, TRMT:1, BRGH:1, :1, SYNC:1, TXEN:1, TX9:1, CSRC:1; } bits; } txsta;
+    union { uint8_t byte; struct { uint8_t RX9D:1, OERR:1, FERR:1, ADEN:1, CREN:1, SREN:1, RX9:1, SPEN:1; } bits; } rcsta;
+    union { uint8_t byte; struct { uint8_t nBOR:1, nPOR:1, :1, OSCF:1; } bits; } pcon;
+    uint8_t tmr0;
+    union { uint8_t byte; struct { uint8_t TMR1ON:1, TMR1CS:1, nT1SYNC:1, T1OSCEN:1, T1CKPS0:1, T1CKPS1:1; } bits; } t1con;
+    uint8_t tmr1l;
+    uint8_t tmr1h;
+    uint8_t cmcon;
+    uint8_t spbrg;
+    uint16_t txreg;     //0xFFFF: sin escritura pendiente
+    union { uint8_t byte; struct { uint8_t RD:1, WR:1, WREN:1, WRERR:1; } bits; } eecon1;
+    uint16_t eecon2;    //0xFFFF: sin escritura pendiente
+    uint8_t eeadr;
+    uint8_t eedata;
+} sim_registros_t;
+
+volatile sim_registros_t *sim_sfr(void);
+uint8_t sim_lee_rcreg(void);
+void sim_retardo_ciclos(unsigned long ciclos);
+
+#define PORTA       (sim_sfr()->porta.byte)
+#define PORTAbits   (sim_sfr()->porta.bits)
+#define PORTB       (sim_sfr()->portb.byte)
+#define PORTBbits   (sim_sfr()->portb.bits)
+#define TRISA       (sim_sfr()->trisa.byte)
+#define TRISAbits   (sim_sfr()->trisa.bits)
+#define TRISB       (sim_sfr()->trisb.byte)
+#define TRISBbits   (sim_sfr()->trisb.bits)
+#define INTCON      (sim_sfr()->intcon.byte)
+#define INTCONbits  (sim_sfr()->intcon.bits)
+#define PIR1        (sim_sfr()->pir1.byte)
+#define PIR1bits    (sim_sfr()->pir1.bits)
+#define PIE1        (sim_sfr()->pie1.byte)
+#define PIE1bits    (sim_sfr()->pie1.bits)
+#define OPTION_REG  (sim_sfr()->option_reg.byte)
+#define OPTION_REGbits (sim_sfr()->option_reg.bits)
+#define TXSTA       (sim_sfr()->txsta.byte)
+#define TXSTAbits   (sim_sfr()->txsta.bits)
+#define RCSTA       (sim_sfr()->rcsta.byte)
+#define RCSTAbits   (sim_sfr()->rcsta.bits)
+#define PCON        (sim_sfr()->pcon.byte)
+#define PCONbits    (sim_sfr()->pcon.bits)
+#define TMR0        (sim_sfr()->tmr0)
+#define T1CON       (sim_sfr()->t1con.byte)
+#define T1CONbits   (sim_sfr()->t1con.bits)
+#define TMR1L       (sim_sfr()->tmr1l)
+#define TMR1H       (sim_sfr()->tmr1h)
+#define CMCON       (sim_sfr()->cmcon)
+#define SPBRG       (sim_sfr()->spbrg)
+#define TXREG       (sim_sfr()->txreg)
+#define RCREG       (sim_lee_rcreg())
+#define EECON1      (sim_sfr()->eecon1.byte)
+#define EECON1bits  (sim_sfr()->eecon1.bits)
+#define EECON2      (sim_sfr()->eecon2)
+#define EEADR       (sim_sfr()->eeadr)
+#define EEDATA      (sim_sfr()->eedata)
+
+#define __interrupt(...)
+#define NOP() sim_retardo_ciclos(1)
+#define di() (INTCONbits.GIE = 0)
+#define ei() (INTCONbits.GIE = 1)
+
+//Igual que en XC8, los retardos usan el _XTAL_FREQ visible donde se invocan
+#define __delay_us(x) sim_retardo_ciclos((unsigned long)((x) * (_XTAL_FREQ / 4000000.0)))
+#define __delay_ms(x) sim_retardo_ciclos((unsigned long)((x) * (_XTAL_FREQ / 4000.0)))
+
+#endif	/* SIM_XC_H */
@@ -0,0 +1,89 @@
+#include "tareas.h"
+
+static const Tarea *tareas;
+static uint8_t numero = 0;
+static uint8_t faltan[TAREAS_MAX];      //ticks para la siguiente ejecucion
+static uint16_t peor[TAREAS_MAX];
+static uint8_t excesos[TAREAS_MAX];
+static uint16_t ultimoTick;
+
+void init_tareas(const Tarea *tabla, uint8_t n)
+{
+    uint8_t k;
+    
+    tareas = tabla;
+    numero = (n > TAREAS_MAX) ? TAREAS_MAX : n;
+    for (k = 0; k < numero; k++)
+        faltan[k] = 0;
+    limpiaTareas();
+    ultimoTick = leeTimer1();
+}
+
+void despachaTareas(void)
+{
+    uint16_t ahora = leeTimer1();
+    uint16_t inicio;
+    uint8_t k, desborde;
+    
+    //Un tick a la vez, sin contarlos en otra variable; casi siempre es uno
+    while ((uint16_t)(ahora - ultimoTick) >= TAREAS_CUENTAS_TICK)
+    {
+        ultimoTick += TAREAS_CUENTAS_TICK;
+        for (k = 0; k < numero; k++)
+            if (faltan[k] != 0)
+                faltan[k]--;
+    }
+    for (k = 0; k < numero; k++)
+    {
+        if (faltan[k] != 0)
+            continue;
+        faltan[k] = tareas[k].periodo;
+        //Ejecuta la tarea y registra su duracion, aqui mismo para no gastar
+        //un nivel de la pila de hardware. La bandera se limpia despues de
+        //leer el inicio y se lee antes del fin: un desborde registrado
+        //siempre queda entre las dos lecturas.
+        inicio = leeTimer1();
+        PIR1bits.TMR1IF = 0;
+        tareas[k].funcion();
+        desborde = PIR1bits.TMR1IF;
+        //ahora ya no se usa: queda el fin y luego la duracion, para no
+        //ocupar mas bytes de la pila compilada
+        ahora = leeTimer1();
+        //Si el contador dio la vuelta y volvio a pasar por el inicio, la
+        //diferencia de 16 bits ya no sirve
+        if (desborde && ahora >= inicio)
+            ahora = TAREAS_DURACION_MAX;
+        else
+            ahora -= inicio;
+        if (ahora > peor[k])
+            peor[k] = ahora;
+        if (ahora > tareas[k].presupuesto && excesos[k] != 255)
+            excesos[k]++;
+    }
+}
+
+uint16_t peorTarea(uint8_t k)
+{
+    return peor[k];
+}
+
+uint8_t excesosTarea(uint8_t k)
+{
+    return excesos[k];
+}
+
+uint8_t numTareas(void)
+{
+    return numero;
+}
+
+void limpiaTareas(void)
+{
+    uint8_t k;
+    
+    for (k = 0; k < TAREAS_MAX; k++)
+    {
+        peor[k] = 0;
+        excesos[k] = 0;
+    }
+}
@@ -0,0 +1,93 @@
+/*
+ * File:   tareas.h
+ * Author:
+ * Comments: Planificador cooperativo de las tareas del ciclo principal, con
+ *           ticks del Timer1, periodo y presupuesto por tarea y registro del
+ *           peor tiempo de ejecucion
+ * Revision history:
+ */
+
+// This is a guard condition so that contents of this file are not included
+// more than once.
+#ifndef TAREAS_H
+#define	TAREAS_H
+
+#include <xc.h> // include processor files - each processor file is guarded.
+#include <stdint.h>
+#include "timer1.h"
+
+//Tareas maximas de la tabla; cada una ocupa 4 bytes de RAM para su cuenta
+//regresiva y sus estadisticas
+#ifndef TAREAS_MAX
+#define TAREAS_MAX 4
+#endif
+//Duracion de un tick del planificador en cuentas del Timer1 (1 ms)
+#define TAREAS_CUENTAS_TICK TIMER1_CUENTAS_MS
+//Valor de peorTarea() cuando una ejecucion duro una vuelta completa del Timer1 o mas
+#define TAREAS_DURACION_MAX 0xFFFF
+
+/*
+ * Una tarea es una funcion que hace un poco de trabajo y regresa: en lugar de
+ * esperar (a la EEPROM, a la UART, a que la pantalla consuma columnas) guarda
+ * su estado y regresa, y el planificador la vuelve a llamar en su siguiente
+ * periodo. Ninguna tarea interrumpe a otra; el refresco de la matriz y la
+ * UART siguen corriendo en la interrupcion, asi que una tarea larga no apaga
+ * la matriz, pero si retrasa a las demas tareas.
+ */
+typedef struct {
+    void (*funcion)(void);
+    uint8_t periodo;        //ticks entre ejecuciones; 0: en cada vuelta
+    uint16_t presupuesto;   //cuentas del Timer1 que puede durar una ejecucion
+} Tarea;
+
+/**
+ * @brief Registra la tabla fija de tareas y pone en cero sus estadísticas.
+ *
+ * @param tabla Arreglo constante de tareas, en orden de prioridad (la primera se revisa primero en cada vuelta).
+ * @param n Número de tareas (a lo sumo `TAREAS_MAX`; las demás se ignoran).
+ *
+ * @pre `init_timer1()` debe haberse llamado previamente.
+ *
+ * @details Todas las tareas quedan listas para ejecutarse en la primera llamada a `despachaTareas()`.
+ *
+ * @code
+ * static const Tarea tareas[] = {
+ *     { atiendeComandos, 1, 5000 },
+ *     { actualizaMarquesina, 1, 2000 },
+ * };
+ * init_tareas(tareas, 2);
+ * while (1)
+ *     despachaTareas();
+ * @endcode
+ */
+void init_tareas(const Tarea *tabla, uint8_t n);
+/**
+ * @brief Da una vuelta del planificador: cuenta los ticks transcurridos y ejecuta las tareas que ya cumplieron su periodo.
+ *
+ * @details Lee el Timer1 y avanza un tick por cada `TAREAS_CUENTAS_TICK` cuentas desde el último; cada tarea tiene una cuenta regresiva de ticks que se recarga con su `periodo` al ejecutarla. Si pasaron varios periodos (porque otra tarea tardó), la tarea se ejecuta una sola vez, sin ráfagas para ponerse al corriente. Cada ejecución se mide con el Timer1: se guarda la más larga (`peorTarea()`) y se cuentan las que rebasan el `presupuesto` de la tarea (`excesosTarea()`).
+ *
+ * @remark Los ticks se cuentan sobre el contador de 16 bits del Timer1, así que una vuelta del planificador no debe tardar más de una vuelta del contador (65 ms con el preescalador en 1); si tarda más se pierden esos ticks y la ejecución culpable queda registrada con `TAREAS_DURACION_MAX`.
+ */
+void despachaTareas(void);
+/**
+ * @brief Peor tiempo de ejecución registrado de una tarea.
+ *
+ * @param k Posición de la tarea en la tabla.
+ *
+ * @return Cuentas del Timer1 (microsegundos con el preescalador en 1) de la ejecución más larga, o `TAREAS_DURACION_MAX` si alguna duró una vuelta del Timer1 o más.
+ */
+uint16_t peorTarea(uint8_t k);
+/**
+ * @brief Ejecuciones de una tarea que rebasaron su presupuesto.
+ *
+ * @param k Posición de la tarea en la tabla.
+ *
+ * @return Número de ejecuciones más largas que el `presupuesto` de la tarea (se detiene en 255).
+ */
+uint8_t excesosTarea(uint8_t k);
+/** @brief Número de tareas registradas con `init_tareas()`. */
+uint8_t numTareas(void);
+/** @brief Pone en cero el peor tiempo y los excesos de todas las tareas. */
+void limpiaTareas(void);
+
+#endif	/* XC_HEADER_TEMPLATE_H */
@@ -0,0 +1,61 @@
+#include "telemetria.h"
+
+static uint8_t crcTrama;
+
+uint8_t actualizaCRC8(uint8_t crc, uint8_t dat)
+{
+    uint8_t k;
+    crc ^= dat;
+    for (k = 0; k < 8; k++)
+    {
+        if (crc & 0x80)
+            crc = (crc << 1) ^ 0x07;
+        else
+            crc <<= 1;
+    }
+    return crc;
+}
+
+void iniciaTrama(uint8_t tipo, uint8_t n)
+{
+    enviaRS232(TRAMA_SYNC);
+    enviaRS232(n);
+    enviaRS232(tipo);
+    crcTrama = actualizaCRC8(actualizaCRC8(0, n), tipo);
+}
+
+void enviaDatoTrama(uint8_t dat)
+{
+    enviaRS232(dat);
+    crcTrama = actualizaCRC8(crcTrama, dat);
+}
+
+void enviaPalabraTrama(unsigned int dat)
+{
+    enviaDatoTrama(dat & 0x00FF);
+    enviaDatoTrama((dat >> 8) & 0x00FF);
+}
+
+void terminaTrama(void)
+{
+    enviaRS232(crcTrama);
+}
+
+void enviaMuestrasTelemetria(const MuestraTelemetria *muestras, uint8_t n)
+{
+    uint8_t lote, k;
+    
+    while (n != 0)
+    {
+        lote = (n > TELEMETRIA_MAX_MUESTRAS) ? TELEMETRIA_MAX_MUESTRAS : n;
+        iniciaTrama(TELEMETRIA_MUESTRAS, 2 * lote);
+        for (k = 0; k < lote; k++)
+        {
+            enviaDatoTrama(muestras[k].id);
+            enviaDatoTrama(muestras[k].valor);
+        }
+        terminaTrama();
+        muestras += lote;
+        n -= lote;
+    }
+}
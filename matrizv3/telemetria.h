@@ -0,0 +1,91 @@
+/*
+ * File:   telemetria.h
+ * Author:
+ * Comments: Tramas binarias por RS-232 (sincronia, longitud, tipo, datos y
+ *           CRC-8) para respuestas de comandos y envio de muestras por lotes
+ * Revision history:
+ */
+
+// This is a guard condition so that contents of this file are not included
+// more than once.
+#ifndef TELEMETRIA_H
+#define	TELEMETRIA_H
+
+#include <xc.h> // include processor files - each processor file is guarded.
+#include <stdint.h>
+#include "rs232.h"
+
+/*
+ * Formato de trama (el mismo que comandos.h):
+ *
+ *   0x7E | LONGITUD | TIPO | DATOS[LONGITUD] | CRC8
+ *
+ * El CRC-8 (polinomio 0x07, valor inicial 0) se calcula sobre LONGITUD, TIPO
+ * y DATOS; los valores de 16 bits van con el byte menos significativo
+ * primero. Cada byte de datos ocupa un byte en la linea, contra dos
+ * caracteres con enviaHexByte(), y la trama completa se descarta en el
+ * receptor si el CRC no coincide. herramientas/telemetria.py decodifica las
+ * tramas.
+ *
+ * Tramas que el firmware envia por su cuenta:
+ *   'L' (id, valor)...    Lote de muestras, dos bytes por muestra en el orden
+ *                         en que se tomaron.
+ */
+#define TRAMA_SYNC 0x7E
+#define TELEMETRIA_MUESTRAS 'L'
+
+//Muestras maximas por trama 'L'; un lote mas largo se parte en varias tramas
+#ifndef TELEMETRIA_MAX_MUESTRAS
+#define TELEMETRIA_MAX_MUESTRAS 16
+#endif
+
+//Misma disposicion que Sensor de ListaEnlazadaPrueba (id y valor de 8 bits)
+typedef struct {
+    uint8_t id;
+    uint8_t valor;
+} MuestraTelemetria;
+
+/**
+ * @brief Agrega un byte al CRC-8 de una trama (polinomio 0x07).
+ *
+ * @param crc CRC acumulado (0 al empezar).
+ * @param dat Byte que se agrega.
+ *
+ * @return El CRC con `dat` incluido.
+ *
+ * @remark Es el mismo CRC con el que `atiendeComandos()` revisa las tramas recibidas.
+ */
+uint8_t actualizaCRC8(uint8_t crc, uint8_t dat);
+/**
+ * @brief Empieza a enviar una trama: sincronía, longitud y tipo.
+ *
+ * @param tipo Tipo de la trama.
+ * @param n Bytes de datos que se enviarán con `enviaDatoTrama()` y `enviaPalabraTrama()` antes de `terminaTrama()`.
+ *
+ * @pre `init_rs232()` debe haberse llamado previamente.
+ *
+ * @details Los bytes se envían con `enviaRS232()`, que se bloquea mientras la cola de transmisión está llena. Solo se arma una trama a la vez y solo desde el ciclo principal.
+ *
+ * @code
+ * iniciaTrama('V', 0);
+ * terminaTrama();
+ * @endcode
+ */
+void iniciaTrama(uint8_t tipo, uint8_t n);
+/** @brief Envía un byte de datos de la trama en curso. */
+void enviaDatoTrama(uint8_t dat);
+/** @brief Envía un valor de 16 bits de la trama en curso, el byte menos significativo primero. */
+void enviaPalabraTrama(unsigned int dat);
+/** @brief Envía el CRC-8 y cierra la trama en curso. */
+void terminaTrama(void);
+/**
+ * @brief Envía un lote de muestras en tramas 'L' de hasta `TELEMETRIA_MAX_MUESTRAS` muestras.
+ *
+ * @param muestras Arreglo de muestras, por ejemplo el lote que regresa `sacarAnillo()` en ListaEnlazadaPrueba.
+ * @param n Número de muestras; con 0 no se envía nada.
+ *
+ * @details Un lote de `n` muestras ocupa `2n` bytes más 4 por trama en la línea, contra `4n` caracteres si cada valor se enviara en hexadecimal.
+ */
+void enviaMuestrasTelemetria(const MuestraTelemetria *muestras, uint8_t n);
+
+#endif	/* XC_HEADER_TEMPLATE_H */
@@ -0,0 +1,23 @@
+#include "timer1.h"
+
+void init_timer1(void)
+{
+    T1CON = 0x00;               //Detenido, reloj interno, sin oscilador T1
+    TMR1H = 0;
+    TMR1L = 0;
+    PIR1bits.TMR1IF = 0;
+    T1CON = TIMER1_T1CKPS << 4;
+    T1CONbits.TMR1ON = 1;
+}
+
+uint16_t leeTimer1(void)
+{
+    uint8_t alto, bajo;
+    
+    do
+    {
+        alto = TMR1H;
+        bajo = TMR1L;
+    } while (alto != TMR1H);
+    return ((uint16_t)alto << 8) | bajo;
+}
@@ -0,0 +1,65 @@
+/*
+ * File:   timer1.h
+ * Author:
+ * Comments: Base de tiempo libre con el Timer1 para medir duraciones y marcar
+ *           los ticks del planificador de tareas
+ * Revision history:
+ */
+
+// This is a guard condition so that contents of this file are not included
+// more than once.
+#ifndef TIMER1_H
+#define	TIMER1_H
+
+#include <xc.h> // include processor files - each processor file is guarded.
+#include <stdint.h>
+
+#ifndef _XTAL_FREQ
+#define _XTAL_FREQ 4000000
+#endif
+
+//Preescalador del Timer1 (1, 2, 4 u 8). Con 1 cada cuenta es un ciclo de
+//instruccion (1 us a 4 MHz) y el contador da la vuelta cada 65.5 ms.
+#ifndef TIMER1_PREESCALADOR
+#define TIMER1_PREESCALADOR 1
+#endif
+#if TIMER1_PREESCALADOR == 1
+#define TIMER1_T1CKPS 0
+#elif TIMER1_PREESCALADOR == 2
+#define TIMER1_T1CKPS 1
+#elif TIMER1_PREESCALADOR == 4
+#define TIMER1_T1CKPS 2
+#elif TIMER1_PREESCALADOR == 8
+#define TIMER1_T1CKPS 3
+#else
+#error "TIMER1_PREESCALADOR debe ser 1, 2, 4 u 8"
+#endif
+//Cuentas del Timer1 por milisegundo
+#define TIMER1_CUENTAS_MS (_XTAL_FREQ / 4000UL / TIMER1_PREESCALADOR)
+
+/**
+ * @brief Arranca el Timer1 como contador libre de 16 bits con el reloj de instrucciones.
+ *
+ * @details Configura `T1CON` con el preescalador `TIMER1_PREESCALADOR` y el reloj interno (Fosc/4), pone el contador en cero y lo enciende. No habilita su interrupción: el contador solo se lee con `leeTimer1()` y `TMR1IF` indica que dio la vuelta.
+ *
+ * @code
+ * init_timer1();
+ * @endcode
+ */
+void init_timer1(void);
+/**
+ * @brief Lee el valor actual del Timer1.
+ *
+ * @details El contador sigue corriendo mientras se leen sus dos bytes: si `TMR1H` cambió entre la primera y la segunda lectura, el byte bajo dio la vuelta en medio y se vuelve a leer, de modo que nunca se combina un byte alto viejo con uno bajo nuevo.
+ *
+ * @return Cuentas del Timer1; la diferencia `(uint16_t)(fin - inicio)` entre dos lecturas es la duración en cuentas mientras sea menor a 65536.
+ *
+ * @code
+ * uint16_t t0 = leeTimer1();
+ * H595Paneles(catodos, 0x01);
+ * uint16_t cuentas = leeTimer1() - t0;
+ * @endcode
+ */
+uint16_t leeTimer1(void);
+
+#endif	/* XC_HEADER_TEMPLATE_H */